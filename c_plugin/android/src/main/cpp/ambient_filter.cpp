@@ -0,0 +1,109 @@
+#include "ambient_filter.h"
+#include <cmath>
+
+namespace {
+
+// Frequency that `f` appears at after being sampled at `fs` (folded into [0, fs/2]).
+double aliasedFrequency(double f, double fs) {
+    return std::fabs(f - fs * std::round(f / fs));
+}
+
+} // namespace
+
+void Biquad::setIdentity() {
+    b0 = 1.0; b1 = 0.0; b2 = 0.0;
+    a1 = 0.0; a2 = 0.0;
+    reset();
+}
+
+void Biquad::setHighPass(double fs, double fc, double q) {
+    const double w0    = 2.0 * M_PI * fc / fs;
+    const double cosw  = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double a0    = 1.0 + alpha;
+
+    b0 =  (1.0 + cosw) * 0.5 / a0;
+    b1 = -(1.0 + cosw)       / a0;
+    b2 =  (1.0 + cosw) * 0.5 / a0;
+    a1 = (-2.0 * cosw)       / a0;
+    a2 = (1.0 - alpha)       / a0;
+    reset();
+}
+
+void Biquad::setNotch(double fs, double f0, double q) {
+    const double w0    = 2.0 * M_PI * f0 / fs;
+    const double cosw  = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double a0    = 1.0 + alpha;
+
+    b0 = 1.0           / a0;
+    b1 = (-2.0 * cosw) / a0;
+    b2 = 1.0           / a0;
+    a1 = (-2.0 * cosw) / a0;
+    a2 = (1.0 - alpha) / a0;
+    reset();
+}
+
+void Biquad::prime(double x) {
+    // Steady-state gain for a constant input is sum(b) / (1 + sum(a)).
+    const double y = x * (b0 + b1 + b2) / (1.0 + a1 + a2);
+    z2 = b2 * x - a2 * y;
+    z1 = b1 * x - a1 * y + z2;
+    primed = true;
+}
+
+double Biquad::process(double x) {
+    if (!primed) prime(x);
+    const double y = b0 * x + z1;
+    z1 = b1 * x - a1 * y + z2;
+    z2 = b2 * x - a2 * y;
+    return y;
+}
+
+void AmbientFilter::configure(const AmbientConfig& c) {
+    cfg = c;
+    if (cfg.ringBlocks < 0) cfg.ringBlocks = 0;
+    if (cfg.q <= 0.0)       cfg.q = 0.707;
+
+    const double fs      = cfg.fps;
+    const double nyquist = fs * 0.5;
+
+    if (fs <= 0.0 || cfg.freqHz <= 0.0) {
+        biquad.setIdentity();
+        return;
+    }
+
+    switch (cfg.filterType) {
+        case AMBIENT_FILTER_HIGHPASS:
+            if (cfg.freqHz < nyquist) biquad.setHighPass(fs, cfg.freqHz, cfg.q);
+            else                      biquad.setIdentity();
+            break;
+        case AMBIENT_FILTER_NOTCH: {
+            // 100/120 Hz flicker is far above the frame rate; it shows up at
+            // its alias. When the alias lands on (or very near) DC there is
+            // nothing left to notch that background subtraction won't remove.
+            double f0 = aliasedFrequency(cfg.freqHz, fs);
+            if (f0 > 0.02 * fs && f0 < nyquist) biquad.setNotch(fs, f0, cfg.q);
+            else                                biquad.setIdentity();
+            break;
+        }
+        default:
+            biquad.setIdentity();
+            break;
+    }
+}
+
+bool AmbientFilter::innerRect(int gridH, int gridW, int& r0, int& c0, int& r1, int& c1) const {
+    const int ring = cfg.ringBlocks;
+    r0 = 0; c0 = 0; r1 = gridH; c1 = gridW;
+    if (ring <= 0) return false;
+    if (gridH <= 2 * ring || gridW <= 2 * ring) return false;
+    r0 = ring; c0 = ring;
+    r1 = gridH - ring; c1 = gridW - ring;
+    return true;
+}
+
+double AmbientFilter::filter(double y) {
+    if (cfg.filterType == AMBIENT_FILTER_NONE) return y;
+    return biquad.process(y);
+}
@@ -0,0 +1,83 @@
+#ifndef AMBIENT_FILTER_H
+#define AMBIENT_FILTER_H
+
+#include <cstdint>
+
+// Filter applied to the per-frame luma series after background subtraction.
+enum AmbientFilterType {
+    AMBIENT_FILTER_NONE     = 0,
+    AMBIENT_FILTER_HIGHPASS = 1,  // removes slow ambient drift
+    AMBIENT_FILTER_NOTCH    = 2,  // removes aliased 100/120 Hz mains flicker
+};
+
+struct AmbientConfig {
+    int    ringBlocks = 0;        // width of the background ring in blocks, 0 = no subtraction
+    int    filterType = AMBIENT_FILTER_NONE;
+    double fps        = 30.0;     // camera frame rate the series is sampled at
+    double freqHz     = 100.0;    // high-pass cutoff, or mains flicker frequency for the notch
+    double q          = 0.707;
+};
+
+// Second-order IIR section (transposed direct form II) used for the
+// high-pass and notch variants. Coefficients follow the RBJ audio cookbook.
+class Biquad {
+public:
+    void setIdentity();
+    void setHighPass(double fs, double fc, double q);
+    void setNotch(double fs, double f0, double q);
+
+    // Sets the internal state as if `x` had been applied forever, so the
+    // first frame after a reset does not produce a large step transient.
+    void prime(double x);
+    double process(double x);
+    void reset() { z1 = z2 = 0.0; primed = false; }
+
+private:
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0;
+    double a1 = 0.0, a2 = 0.0;
+    double z1 = 0.0, z2 = 0.0;
+    bool   primed = false;
+};
+
+// Ambient-light and mains-flicker rejection stage for process_frame_color.
+//
+// The background is the mean of a ring of blocks along the ROI border, which
+// is expected to contain only ambient light. The LED estimate is taken from
+// the blocks inside the ring and the difference is passed through the
+// configured temporal filter.
+class AmbientFilter {
+public:
+    void configure(const AmbientConfig& cfg);
+    const AmbientConfig& config() const { return cfg; }
+
+    // Returns false when the grid is too small to leave any blocks inside
+    // the ring; the caller then falls back to the whole grid.
+    bool innerRect(int gridH, int gridW, int& r0, int& c0, int& r1, int& c1) const;
+
+    // Mean of the ring blocks. `grid[r][c]` must yield the block value.
+    template <typename Grid>
+    double backgroundMean(const Grid& grid, int gridH, int gridW) const {
+        const int ring = cfg.ringBlocks;
+        uint64_t sum = 0;
+        int n = 0;
+        for (int r = 0; r < gridH; ++r) {
+            const bool edgeRow = r < ring || r >= gridH - ring;
+            for (int c = 0; c < gridW; ++c) {
+                if (edgeRow || c < ring || c >= gridW - ring) {
+                    sum += grid[r][c];
+                    ++n;
+                }
+            }
+        }
+        return n > 0 ? double(sum) / n : 0.0;
+    }
+
+    double filter(double y);
+    void reset() { biquad.reset(); }
+
+private:
+    AmbientConfig cfg;
+    Biquad        biquad;
+};
+
+#endif // AMBIENT_FILTER_H
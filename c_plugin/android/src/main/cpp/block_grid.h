@@ -0,0 +1,59 @@
+#ifndef BLOCK_GRID_H
+#define BLOCK_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Read-only view of one downsampled block grid, rows x cols, row-major with
+// no padding. `grid[r][c]` works like it did on the old vector-of-vectors.
+struct BlockGridView {
+    const uint8_t* data = nullptr;
+    int rows = 0;
+    int cols = 0;
+
+    const uint8_t* operator[](int r) const { return data + size_t(r) * cols; }
+    bool empty() const { return rows == 0 || cols == 0; }
+};
+
+// Fixed-depth history of block grids in one contiguous allocation.
+//
+// Every slot has room for the largest grid the session can produce, so
+// changing ROI size never reallocates; only configure() does. Slots keep
+// their own geometry so a grid from before an ROI change is recognisable.
+template <int Depth>
+class BlockGridRing {
+public:
+    void configure(int maxRows, int maxCols) {
+        slotSize = size_t(maxRows > 0 ? maxRows : 0) * size_t(maxCols > 0 ? maxCols : 0);
+        storage.assign(slotSize * Depth, 0);
+        clear();
+    }
+
+    void clear() {
+        for (int i = 0; i < Depth; ++i) rowsOf[i] = colsOf[i] = 0;
+    }
+
+    size_t capacity() const { return slotSize; }
+
+    // Storage of slot `i`; holds up to capacity() entries.
+    uint8_t* data(int i) { return storage.data() + size_t(i) * slotSize; }
+
+    // Records the geometry of the grid just written to slot `i`.
+    void setShape(int i, int rows, int cols) {
+        rowsOf[i] = rows;
+        colsOf[i] = cols;
+    }
+
+    BlockGridView view(int i) const {
+        return BlockGridView{storage.data() + size_t(i) * slotSize, rowsOf[i], colsOf[i]};
+    }
+
+private:
+    std::vector<uint8_t> storage;
+    size_t slotSize = 0;
+    int rowsOf[Depth] = {};
+    int colsOf[Depth] = {};
+};
+
+#endif // BLOCK_GRID_H
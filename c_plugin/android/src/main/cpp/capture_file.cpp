@@ -0,0 +1,314 @@
+#include "capture_file.h"
+#include "c_plugin.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+inline uint64_t alignUp(uint64_t v) {
+    return (v + CAPTURE_ALIGN - 1) & ~uint64_t(CAPTURE_ALIGN - 1);
+}
+
+// Bytes spanned by a plane of `rows` x `cols` samples
+inline int64_t planeSpan(int rows, int cols, int rowStride, int pixelStride) {
+    if (rows <= 0 || cols <= 0) return 0;
+    return int64_t(rows - 1) * rowStride + int64_t(cols - 1) * pixelStride + 1;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// CaptureWriter
+
+bool CaptureWriter::open(const char* path) {
+    close();
+    file = std::fopen(path, "wb");
+    if (!file) return false;
+
+    offset = 0;
+    failed = false;
+    index.clear();
+
+    CaptureFileHeader header = {};
+    std::memcpy(header.magic, "LIFICAP", 8);
+    header.version    = CAPTURE_VERSION;
+    header.headerSize = sizeof(CaptureFileHeader);
+    put(&header, sizeof(header));
+    pad();
+    return !failed;
+}
+
+void CaptureWriter::put(const void* data, size_t size) {
+    if (size && std::fwrite(data, 1, size, file) != size) failed = true;
+    offset += size;
+}
+
+void CaptureWriter::pad() {
+    static const uint8_t zeros[CAPTURE_ALIGN] = {};
+    put(zeros, size_t(alignUp(offset) - offset));
+}
+
+bool CaptureWriter::write(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                          int width, int height, int yRowStride, int uvRowStride, int uvPixelStride,
+                          int count, int64_t timestampNs, int x0, int y0, int w, int h,
+                          int cropMargin) {
+    if (!file || failed || !y || !u || !v || width <= 0 || height <= 0) return false;
+
+    CaptureFrameHeader fh = {};
+    fh.magic       = CAPTURE_FRAME_MAGIC;
+    fh.timestampNs = timestampNs;
+    fh.count       = count;
+    fh.frameWidth  = width;
+    fh.frameHeight = height;
+
+    const uint8_t* ySrc = y;
+    const uint8_t* uSrc = u;
+    const uint8_t* vSrc = v;
+    bool crop = cropMargin >= 0;
+
+    if (crop) {
+        // ROI plus margin, on even coordinates so the chroma grid lines up
+        int cx0 = std::max(0, x0 - cropMargin) & ~1;
+        int cy0 = std::max(0, y0 - cropMargin) & ~1;
+        int cx1 = std::min(width,  (std::max(x0 + w + cropMargin, cx0 + 1) + 1) & ~1);
+        int cy1 = std::min(height, (std::max(y0 + h + cropMargin, cy0 + 1) + 1) & ~1);
+        if (cx0 >= width || cy0 >= height) return false;
+
+        fh.originX = cx0;
+        fh.originY = cy0;
+        fh.width   = cx1 - cx0;
+        fh.height  = cy1 - cy0;
+        fh.yRowStride    = fh.width;
+        fh.uvRowStride   = (fh.width + 1) / 2;
+        fh.uvPixelStride = 1;
+    } else {
+        fh.width         = width;
+        fh.height        = height;
+        fh.yRowStride    = yRowStride;
+        fh.uvRowStride   = uvRowStride;
+        fh.uvPixelStride = uvPixelStride;
+    }
+
+    const int cw = (fh.width + 1) / 2, ch = (fh.height + 1) / 2;
+    fh.ySize = uint32_t(planeSpan(fh.height, fh.width, fh.yRowStride, 1));
+    fh.uSize = uint32_t(planeSpan(ch, cw, fh.uvRowStride, fh.uvPixelStride));
+    fh.vSize = fh.uSize;
+    fh.yOffset = uint32_t(alignUp(sizeof(CaptureFrameHeader)));
+    fh.uOffset = uint32_t(alignUp(fh.yOffset + fh.ySize));
+    fh.vOffset = uint32_t(alignUp(fh.uOffset + fh.uSize));
+    fh.recordSize = uint32_t(alignUp(fh.vOffset + fh.vSize));
+
+    fh.roiX = x0 - fh.originX;
+    fh.roiY = y0 - fh.originY;
+    fh.roiW = w;
+    fh.roiH = h;
+
+    if (crop) {
+        // Repack Y tightly and chroma as planar U and V
+        scratch.resize(size_t(fh.ySize) + 2 * size_t(fh.uSize));
+        uint8_t* yDst = scratch.data();
+        uint8_t* uDst = yDst + fh.ySize;
+        uint8_t* vDst = uDst + fh.uSize;
+        for (int r = 0; r < fh.height; ++r) {
+            std::memcpy(yDst + size_t(r) * fh.width,
+                        y + size_t(fh.originY + r) * yRowStride + fh.originX, size_t(fh.width));
+        }
+        for (int r = 0; r < ch; ++r) {
+            const size_t row = size_t(fh.originY / 2 + r) * uvRowStride;
+            for (int c = 0; c < cw; ++c) {
+                const size_t at = row + size_t(fh.originX / 2 + c) * uvPixelStride;
+                uDst[size_t(r) * cw + c] = u[at];
+                vDst[size_t(r) * cw + c] = v[at];
+            }
+        }
+        ySrc = yDst;
+        uSrc = uDst;
+        vSrc = vDst;
+    }
+
+    index.push_back(offset);
+    const uint64_t start = offset;
+    put(&fh, sizeof(fh));
+    pad();
+    put(ySrc, fh.ySize);
+    pad();
+    put(uSrc, fh.uSize);
+    pad();
+    put(vSrc, fh.vSize);
+    pad();
+    if (offset - start != fh.recordSize) failed = true;
+    return !failed;
+}
+
+int CaptureWriter::close() {
+    if (!file) return -1;
+
+    CaptureFileHeader header = {};
+    std::memcpy(header.magic, "LIFICAP", 8);
+    header.version     = CAPTURE_VERSION;
+    header.headerSize  = sizeof(CaptureFileHeader);
+    header.indexOffset = offset;
+    header.frameCount  = uint32_t(index.size());
+    put(index.data(), index.size() * sizeof(uint64_t));
+
+    if (std::fseek(file, 0, SEEK_SET) != 0) failed = true;
+    else if (std::fwrite(&header, sizeof(header), 1, file) != 1) failed = true;
+    if (std::fclose(file) != 0) failed = true;
+    file = nullptr;
+
+    const int frames = int(index.size());
+    index.clear();
+    return failed ? -1 : frames;
+}
+
+// ---------------------------------------------------------------------------
+// CaptureReader
+
+bool CaptureReader::open(const char* path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(CaptureFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+    base = static_cast<const uint8_t*>(map);
+    length = size_t(st.st_size);
+
+    const CaptureFileHeader* header = reinterpret_cast<const CaptureFileHeader*>(base);
+    if (std::memcmp(header->magic, "LIFICAP", 8) != 0 || header->version != CAPTURE_VERSION) {
+        close();
+        return false;
+    }
+
+    const uint64_t indexBytes = uint64_t(header->frameCount) * sizeof(uint64_t);
+    if (header->indexOffset != 0 && header->indexOffset <= length &&
+        indexBytes <= length - header->indexOffset) {
+        offsets.resize(header->frameCount);
+        std::memcpy(offsets.data(), base + header->indexOffset, size_t(indexBytes));
+        for (uint64_t off : offsets) {
+            if (!validRecord(off)) {
+                close();
+                return false;
+            }
+        }
+    } else {
+        // Unfinished capture: walk the records
+        uint64_t off = alignUp(header->headerSize);
+        while (validRecord(off)) {
+            offsets.push_back(off);
+            off += reinterpret_cast<const CaptureFrameHeader*>(base + off)->recordSize;
+        }
+    }
+
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        const CaptureFrameHeader* fh = frame(i).info;
+        maxW = std::max(maxW, fh->width);
+        maxH = std::max(maxH, fh->height);
+    }
+    return true;
+}
+
+void CaptureReader::close() {
+    if (base) munmap(const_cast<uint8_t*>(base), length);
+    base = nullptr;
+    length = 0;
+    offsets.clear();
+    maxW = maxH = 0;
+}
+
+bool CaptureReader::validRecord(uint64_t off) const {
+    if (off % CAPTURE_ALIGN != 0 || off > length || length - off < sizeof(CaptureFrameHeader)) {
+        return false;
+    }
+    const CaptureFrameHeader* fh = reinterpret_cast<const CaptureFrameHeader*>(base + off);
+    if (fh->magic != CAPTURE_FRAME_MAGIC || fh->recordSize < sizeof(CaptureFrameHeader) ||
+        fh->recordSize > length - off) {
+        return false;
+    }
+    if (fh->width <= 0 || fh->height <= 0 || fh->yRowStride < fh->width ||
+        fh->uvRowStride <= 0 || fh->uvPixelStride <= 0) {
+        return false;
+    }
+
+    const int cw = (fh->width + 1) / 2, ch = (fh->height + 1) / 2;
+    const uint64_t size = fh->recordSize;
+    return planeSpan(fh->height, fh->width, fh->yRowStride, 1) <= int64_t(fh->ySize) &&
+           planeSpan(ch, cw, fh->uvRowStride, fh->uvPixelStride) <= int64_t(fh->uSize) &&
+           planeSpan(ch, cw, fh->uvRowStride, fh->uvPixelStride) <= int64_t(fh->vSize) &&
+           uint64_t(fh->yOffset) + fh->ySize <= size &&
+           uint64_t(fh->uOffset) + fh->uSize <= size &&
+           uint64_t(fh->vOffset) + fh->vSize <= size;
+}
+
+CaptureFrame CaptureReader::frame(size_t i) const {
+    CaptureFrame f;
+    if (i >= offsets.size()) return f;
+    const uint8_t* rec = base + offsets[i];
+    f.info = reinterpret_cast<const CaptureFrameHeader*>(rec);
+    f.y = rec + f.info->yOffset;
+    f.u = rec + f.info->uOffset;
+    f.v = rec + f.info->vOffset;
+    return f;
+}
+
+// ---------------------------------------------------------------------------
+// C API
+
+struct lifi_recorder {
+    CaptureWriter writer;
+};
+
+extern "C" {
+
+lifi_recorder* lifi_recorder_open(const char* path) {
+    if (!path) return nullptr;
+    lifi_recorder* rec = new lifi_recorder();
+    if (!rec->writer.open(path)) {
+        delete rec;
+        return nullptr;
+    }
+    return rec;
+}
+
+int32_t lifi_recorder_write(
+        lifi_recorder* rec,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        int32_t count,
+        int64_t timestamp_ns,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        int32_t crop_margin
+) {
+    if (!rec) return 0;
+    return rec->writer.write(y_plane, u_plane, v_plane, width, height,
+                             y_row_stride, uv_row_stride, uv_pixel_stride,
+                             count, timestamp_ns, x0, y0, w, h, crop_margin) ? 1 : 0;
+}
+
+int32_t lifi_recorder_close(lifi_recorder* rec) {
+    if (!rec) return -1;
+    int frames = rec->writer.close();
+    delete rec;
+    return frames;
+}
+
+}
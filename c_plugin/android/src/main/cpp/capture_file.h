@@ -0,0 +1,118 @@
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Raw camera-frame capture container (.lfc).
+//
+//   CaptureFileHeader
+//   record 0: CaptureFrameHeader, Y, U, V planes (each 64-byte aligned)
+//   record 1: ...
+//   index:    uint64_t offset of every record
+//
+// The index and frame count are patched into the file header on close. A
+// capture cut short (app killed) has indexOffset == 0 and is read by walking
+// the records, which carry their own size.
+//
+// Planes are stored either whole, byte for byte with the camera's strides,
+// or as a crop around the ROI, repacked tightly (chroma planar). Replay hands
+// the decoder pointers straight into the mapped file.
+
+struct CaptureFileHeader {
+    char     magic[8];          // "LIFICAP"
+    uint32_t version;
+    uint32_t headerSize;        // sizeof(CaptureFileHeader)
+    uint64_t indexOffset;       // 0 if the recorder was not closed
+    uint32_t frameCount;
+    uint32_t reserved;
+};
+
+struct CaptureFrameHeader {
+    uint32_t magic;             // CAPTURE_FRAME_MAGIC
+    uint32_t recordSize;        // header + planes + padding
+    int64_t  timestampNs;
+    int32_t  count;             // Count argument of process_frame_color
+
+    // Camera frame, and where the stored planes sit inside it
+    int32_t  frameWidth, frameHeight;
+    int32_t  originX, originY;
+
+    // Stored planes
+    int32_t  width, height;
+    int32_t  yRowStride, uvRowStride, uvPixelStride;
+    uint32_t yOffset, uOffset, vOffset;     // from the start of the record
+    uint32_t ySize, uSize, vSize;
+
+    // Decoder ROI, in stored-plane coordinates
+    int32_t  roiX, roiY, roiW, roiH;
+};
+
+constexpr uint32_t CAPTURE_VERSION     = 1;
+constexpr uint32_t CAPTURE_FRAME_MAGIC = 0x4D52464C;   // "LFRM"
+constexpr size_t   CAPTURE_ALIGN       = 64;
+
+// One frame of a mapped capture. Pointers stay valid until the reader closes.
+struct CaptureFrame {
+    const CaptureFrameHeader* info = nullptr;
+    const uint8_t* y = nullptr;
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+};
+
+// Appends frames to a capture file.
+class CaptureWriter {
+public:
+    ~CaptureWriter() { close(); }
+
+    bool open(const char* path);
+
+    // Stores one YUV_420_888 frame. cropMargin < 0 stores the full planes;
+    // otherwise only the ROI grown by cropMargin pixels on each side.
+    bool write(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+               int width, int height, int yRowStride, int uvRowStride, int uvPixelStride,
+               int count, int64_t timestampNs, int x0, int y0, int w, int h, int cropMargin);
+
+    // Writes the index and header. Returns the number of frames, -1 on error.
+    int close();
+
+private:
+    FILE* file = nullptr;
+    uint64_t offset = 0;
+    std::vector<uint64_t> index;
+    std::vector<uint8_t> scratch;
+    bool failed = false;
+
+    void put(const void* data, size_t size);
+    void pad();
+};
+
+// Memory-maps a capture for zero-copy replay.
+class CaptureReader {
+public:
+    ~CaptureReader() { close(); }
+
+    // Maps the file and validates every record. Returns false if the file is
+    // not a capture or a record points outside it.
+    bool open(const char* path);
+    void close();
+
+    size_t size() const { return offsets.size(); }
+    CaptureFrame frame(size_t i) const;
+
+    // Largest stored plane size, for sizing a decoder session
+    int maxWidth() const { return maxW; }
+    int maxHeight() const { return maxH; }
+
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+    std::vector<uint64_t> offsets;
+    int maxW = 0, maxH = 0;
+
+    bool validRecord(uint64_t offset) const;
+};
+
+#endif // CAPTURE_FILE_H
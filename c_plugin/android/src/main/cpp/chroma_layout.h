@@ -0,0 +1,58 @@
+#ifndef CHROMA_LAYOUT_H
+#define CHROMA_LAYOUT_H
+
+#include <cstdint>
+
+// Chroma layouts of the YUV 4:2:0 frames cameras hand out, told apart by
+// the geometry of the U and V planes.
+//
+// YUV_420_888 only promises planes with a row and a pixel stride; in
+// practice it is one of the layouts below, fixed for the life of a stream.
+// Kernels are instantiated per layout so the inner loop indexes chroma
+// with a compile-time stride instead of working it out per pixel; the
+// instance is picked once per frame from the plane pointers.
+enum ChromaLayout : uint8_t {
+    CHROMA_PLANAR = 0,      // I420 / YV12: separate planes, pixel stride 1
+    CHROMA_NV12,            // interleaved U,V: pixel stride 2, v == u + 1
+    CHROMA_NV21,            // interleaved V,U: pixel stride 2, u == v + 1
+    CHROMA_STRIDED,         // anything else: pixel stride read at run time
+    CHROMA_LAYOUT_COUNT
+};
+
+inline ChromaLayout chromaLayout(const uint8_t* u, const uint8_t* v, int pixelStride) {
+    if (pixelStride == 1) return CHROMA_PLANAR;
+    if (pixelStride == 2 && v == u + 1) return CHROMA_NV12;
+    if (pixelStride == 2 && u == v + 1) return CHROMA_NV21;
+    return CHROMA_STRIDED;
+}
+
+// Chroma of one frame row in layout L; U(x) and V(x) are the samples for
+// frame column x.
+template <ChromaLayout L>
+struct ChromaRow {
+    const uint8_t* u;       // start of the row in the U plane
+    const uint8_t* v;
+    int stride;             // pixel stride, only read for CHROMA_STRIDED
+
+    uint8_t U(int x) const {
+        const int i = x >> 1;
+        switch (L) {
+            case CHROMA_PLANAR:  return u[i];
+            case CHROMA_NV12:    return u[2 * i];
+            case CHROMA_NV21:    return v[2 * i + 1];
+            default:             return u[i * stride];
+        }
+    }
+
+    uint8_t V(int x) const {
+        const int i = x >> 1;
+        switch (L) {
+            case CHROMA_PLANAR:  return v[i];
+            case CHROMA_NV12:    return u[2 * i + 1];
+            case CHROMA_NV21:    return v[2 * i];
+            default:             return v[i * stride];
+        }
+    }
+};
+
+#endif // CHROMA_LAYOUT_H
@@ -0,0 +1,68 @@
+#include "frame_cadence.h"
+#include <algorithm>
+
+void FrameCadence::updateEstimate(uint64_t intervalNs) {
+    recent[recentNext] = intervalNs;
+    recentNext = (recentNext + 1) % HISTORY;
+    recentCount = std::min(recentCount + 1, HISTORY);
+    if (recentCount < 3) return;
+
+    uint64_t sorted[HISTORY];
+    std::copy(recent, recent + recentCount, sorted);
+    std::nth_element(sorted, sorted + recentCount / 2, sorted + recentCount);
+    estimate = sorted[recentCount / 2];
+}
+
+uint8_t FrameCadence::frame(int64_t timestampNs, bool sensor, int64_t processingNs) {
+    uint8_t flags = 0;
+    ++frames;
+    lastMissedCount = 0;
+
+    // A timestamp that does not move forward, or is on the other clock,
+    // starts a new run
+    if (lastNs > 0 && sensor == lastSensor && timestampNs > lastNs) {
+        const uint64_t dt = uint64_t(timestampNs - lastNs);
+        const uint64_t p = period();
+        interval.add(dt);
+        if (p > 0 && dt > p + p / 2) {
+            lastMissedCount = (dt + p / 2) / p - 1;
+            missed += lastMissedCount;
+            ++gaps;
+            flags |= LIFI_TRACE_GAP;
+        } else if (p > 0) {
+            jitter.add(dt > p ? dt - p : p - dt);
+        }
+        updateEstimate(dt);
+    }
+    lastNs = timestampNs;
+    lastSensor = sensor;
+
+    const uint64_t b = budget();
+    if (b > 0 && processingNs > 0 && uint64_t(processingNs) > b) {
+        ++late;
+        flags |= LIFI_TRACE_LATE;
+    }
+    return flags;
+}
+
+void FrameCadence::snapshot(lifi_cadence_stats& out) const {
+    out.frames          = frames;
+    out.gaps            = gaps;
+    out.missed_frames   = missed;
+    out.deadline_misses = late;
+    out.period_ns       = period();
+    out.budget_ns       = budget();
+    out.last_missed     = lastMissedCount;
+    interval.snapshot(out.interval);
+    jitter.snapshot(out.jitter);
+}
+
+void FrameCadence::reset() {
+    recentCount = 0;
+    recentNext  = 0;
+    estimate    = 0;
+    lastNs      = 0;
+    interval.reset();
+    jitter.reset();
+    frames = gaps = missed = late = lastMissedCount = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef FRAME_CADENCE_H
+#define FRAME_CADENCE_H
+
+#include "c_plugin.h"
+#include "stage_timing.h"
+#include <cstdint>
+
+// Arrival cadence of one session's frames.
+//
+// Camera streams stall, drop frames and slow down under thermal load, while
+// the decoder groups frames into symbols by position. From the timestamp of
+// each frame this infers how many frames went missing before it, so the
+// decoder can skip that many slots instead of slipping, and it counts the
+// frames whose processing overran the frame budget.
+//
+// The period is either set or the median of the last HISTORY intervals, so
+// it follows rate changes within about half that many frames. An interval
+// of more than 1.5 periods is a gap of round(interval / period) - 1 frames.
+class FrameCadence {
+public:
+    static constexpr int HISTORY = 15;
+
+    // period / budget <= 0: estimate the period, budget = period
+    void configure(int64_t periodNs, int64_t budgetNs) {
+        fixedPeriod = periodNs > 0 ? uint64_t(periodNs) : 0;
+        fixedBudget = budgetNs > 0 ? uint64_t(budgetNs) : 0;
+    }
+
+    // One frame at `timestampNs` that took `processingNs` to decode.
+    // `sensor` says whether the timestamp came from the camera or from our
+    // own clock; switching between the two starts a new run.
+    // Returns LIFI_TRACE_GAP / LIFI_TRACE_LATE flags for its trace record.
+    uint8_t frame(int64_t timestampNs, bool sensor, int64_t processingNs);
+
+    int lastMissed() const { return int(lastMissedCount); }
+
+    void snapshot(lifi_cadence_stats& out) const;
+
+    // Clears the counters and the period estimate; the configuration stays
+    void reset();
+
+private:
+    uint64_t period() const { return fixedPeriod ? fixedPeriod : estimate; }
+    uint64_t budget() const { return fixedBudget ? fixedBudget : period(); }
+    void updateEstimate(uint64_t intervalNs);
+
+    uint64_t fixedPeriod = 0;
+    uint64_t fixedBudget = 0;
+
+    uint64_t recent[HISTORY] = {};
+    int      recentCount = 0;
+    int      recentNext  = 0;
+    uint64_t estimate    = 0;
+    int64_t  lastNs      = 0;
+    bool     lastSensor  = false;
+
+    LatencyStat interval;
+    LatencyStat jitter;
+    uint64_t frames = 0;
+    uint64_t gaps = 0;
+    uint64_t missed = 0;
+    uint64_t late = 0;
+    uint64_t lastMissedCount = 0;
+};
+
+#endif // FRAME_CADENCE_H
@@ -0,0 +1,318 @@
+#include "frame_queue.h"
+#include "lifi_session.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+FrameQueue::FrameQueue(int cap, int maxWidth, int maxHeight, lifi_queue_policy pol, int timeout)
+        : capacity(uint32_t(std::max(1, cap))),
+          maxW(std::max(2, (maxWidth + 1) & ~1)),
+          maxH(std::max(2, (maxHeight + 1) & ~1)),
+          policy(pol),
+          timeoutMs(std::max(0, timeout)),
+          fullRing(capacity),
+          freeRing(capacity + 2) {
+    const size_t lumaBytes = size_t(maxW) * maxH;
+    const size_t chromaBytes = size_t(maxW / 2) * (maxH / 2);
+    const size_t slotBytes = lumaBytes + 2 * chromaBytes;
+    storage.assign(slotBytes * (capacity + 2), 0);
+
+    slots.resize(capacity + 2);
+    for (uint32_t i = 0; i < capacity + 2; ++i) {
+        QueuedFrame& f = slots[i];
+        std::memset(&f, 0, sizeof(f));
+        f.y = storage.data() + slotBytes * i;
+        f.u = f.y + lumaBytes;
+        f.v = f.u + chromaBytes;
+        freeRing[i].store(i, std::memory_order_relaxed);
+    }
+    freeHead.store(capacity + 2, std::memory_order_release);
+}
+
+int FrameQueue::takeFreeSlot() {
+    if (spare >= 0) {
+        int id = spare;
+        spare = -1;
+        return id;
+    }
+    const uint64_t t = freeTail.load(std::memory_order_relaxed);
+    if (t == freeHead.load(std::memory_order_acquire)) return -1;
+    const int id = int(freeRing[t % (capacity + 2)].load(std::memory_order_relaxed));
+    freeTail.store(t + 1, std::memory_order_release);
+    return id;
+}
+
+bool FrameQueue::waitForSpace(uint64_t h) {
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (int spin = 0; h - tail.load(std::memory_order_acquire) >= capacity; ++spin) {
+        if (spin < 64) continue;
+        if (clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+}
+
+QueuedFrame* FrameQueue::claim(int width, int height, int count, int64_t timestampNs,
+                               int x0, int y0, int w, int h) {
+    if (width <= 0 || height <= 0 || claimed >= 0) return nullptr;
+    const uint64_t seq = nextSeq++;
+    const uint64_t hd = head.load(std::memory_order_relaxed);
+
+    // Full: the cheap policies decide before copying anything
+    if (hd - tail.load(std::memory_order_acquire) >= capacity) {
+        if (policy == LIFI_QUEUE_DROP_NEWEST) {
+            droppedNewest.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (policy == LIFI_QUEUE_BLOCK && !waitForSpace(hd)) {
+            timeouts.fetch_add(1, std::memory_order_relaxed);
+            droppedNewest.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+
+    const int id = takeFreeSlot();
+    if (id < 0) {
+        // Cannot happen with capacity + 2 slots; count it rather than crash
+        droppedNewest.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // ROI clamped to the frame, then rounded out to even coordinates so the
+    // chroma grid lines up; at most maxW x maxH is kept
+    x0 = std::min(std::max(0, x0), width - 1);
+    y0 = std::min(std::max(0, y0), height - 1);
+    w = std::min(std::max(1, w), width - x0);
+    h = std::min(std::max(1, h), height - y0);
+    const int cx0 = x0 & ~1, cy0 = y0 & ~1;
+    const int cx1 = std::min({width, (x0 + w + 1) & ~1, cx0 + maxW});
+    const int cy1 = std::min({height, (y0 + h + 1) & ~1, cy0 + maxH});
+
+    QueuedFrame& f = slots[size_t(id)];
+    f.seq = seq;
+    f.enqueueNs = latencyNow();
+    f.sensorNs = timestampNs;
+    f.timestampNs = timestampNs != 0 ? timestampNs : f.enqueueNs;
+    f.count = count;
+    f.originX = cx0;
+    f.originY = cy0;
+    f.width = cx1 - cx0;
+    f.height = cy1 - cy0;
+    f.roiX = x0 - cx0;
+    f.roiY = y0 - cy0;
+    f.roiW = std::min(w, f.width - f.roiX);
+    f.roiH = std::min(h, f.height - f.roiY);
+    claimed = id;
+    return &f;
+}
+
+void FrameQueue::commit() {
+    if (claimed < 0) return;
+    const uint64_t hd = head.load(std::memory_order_relaxed);
+
+    // Drop-oldest: reclaim the head of the full ring. Losing the CAS means
+    // the consumer just popped it, which made room anyway.
+    if (policy == LIFI_QUEUE_DROP_OLDEST) {
+        uint64_t t = tail.load(std::memory_order_acquire);
+        while (hd - t >= capacity) {
+            const uint32_t oldest = fullRing[t % capacity].load(std::memory_order_relaxed);
+            if (tail.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+                spare = int(oldest);
+                droppedOldest.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    }
+
+    fullRing[hd % capacity].store(uint32_t(claimed), std::memory_order_relaxed);
+    head.store(hd + 1, std::memory_order_release);
+    enqueued.fetch_add(1, std::memory_order_relaxed);
+    claimed = -1;
+
+    const uint32_t depth = uint32_t(hd + 1 - tail.load(std::memory_order_relaxed));
+    if (depth > maxDepth.load(std::memory_order_relaxed)) {
+        maxDepth.store(depth, std::memory_order_relaxed);
+    }
+}
+
+bool FrameQueue::push(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                      int width, int height, int yRowStride, int uvRowStride, int uvPixelStride,
+                      int count, int64_t timestampNs, int x0, int y0, int w, int h) {
+    if (!y || !u || !v) return false;
+    QueuedFrame* f = claim(width, height, count, timestampNs, x0, y0, w, h);
+    if (!f) return false;
+
+    const int cx0 = f->originX, cy0 = f->originY;
+    for (int r = 0; r < f->height; ++r) {
+        std::memcpy(f->y + size_t(r) * f->width, y + size_t(cy0 + r) * yRowStride + cx0, size_t(f->width));
+    }
+    const int cw = (f->width + 1) / 2, ch = (f->height + 1) / 2;
+    for (int r = 0; r < ch; ++r) {
+        const size_t row = size_t(cy0 / 2 + r) * uvRowStride;
+        uint8_t* uDst = f->u + size_t(r) * cw;
+        uint8_t* vDst = f->v + size_t(r) * cw;
+        if (uvPixelStride == 1) {
+            std::memcpy(uDst, u + row + cx0 / 2, size_t(cw));
+            std::memcpy(vDst, v + row + cx0 / 2, size_t(cw));
+        } else {
+            for (int c = 0; c < cw; ++c) {
+                const size_t at = row + size_t(cx0 / 2 + c) * uvPixelStride;
+                uDst[c] = u[at];
+                vDst[c] = v[at];
+            }
+        }
+    }
+    commit();
+    return true;
+}
+
+const QueuedFrame* FrameQueue::pop() {
+    release();
+    uint64_t t = tail.load(std::memory_order_acquire);
+    while (t != head.load(std::memory_order_acquire)) {
+        const uint32_t id = fullRing[t % capacity].load(std::memory_order_relaxed);
+        if (tail.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+            held = int(id);
+            dequeued.fetch_add(1, std::memory_order_relaxed);
+            return &slots[id];
+        }
+    }
+    return nullptr;
+}
+
+void FrameQueue::release() {
+    if (held < 0) return;
+    const uint64_t h = freeHead.load(std::memory_order_relaxed);
+    freeRing[h % (capacity + 2)].store(uint32_t(held), std::memory_order_relaxed);
+    freeHead.store(h + 1, std::memory_order_release);
+    held = -1;
+}
+
+void FrameQueue::stats(lifi_queue_stats& out) const {
+    out.enqueued       = enqueued.load(std::memory_order_relaxed);
+    out.dequeued       = dequeued.load(std::memory_order_relaxed);
+    out.dropped_oldest = droppedOldest.load(std::memory_order_relaxed);
+    out.dropped_newest = droppedNewest.load(std::memory_order_relaxed);
+    out.timeouts       = timeouts.load(std::memory_order_relaxed);
+    const uint64_t h = head.load(std::memory_order_acquire);
+    const uint64_t t = tail.load(std::memory_order_acquire);
+    out.depth          = h > t ? uint32_t(h - t) : 0;
+    out.max_depth      = maxDepth.load(std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// C API
+
+struct lifi_frame_queue {
+    FrameQueue queue;
+
+    lifi_frame_queue(int capacity, int maxWidth, int maxHeight, lifi_queue_policy policy, int timeoutMs)
+            : queue(capacity, maxWidth, maxHeight, policy, timeoutMs) {}
+};
+
+extern "C" {
+
+lifi_frame_queue* lifi_queue_create(
+        int32_t capacity,
+        int32_t max_width,
+        int32_t max_height,
+        int32_t policy,
+        int32_t timeout_ms
+) {
+    if (capacity <= 0 || max_width <= 0 || max_height <= 0) return nullptr;
+    if (policy < LIFI_QUEUE_DROP_OLDEST || policy > LIFI_QUEUE_BLOCK) return nullptr;
+    return new lifi_frame_queue(capacity, max_width, max_height,
+                                lifi_queue_policy(policy), timeout_ms);
+}
+
+void lifi_queue_destroy(lifi_frame_queue* q) {
+    delete q;
+}
+
+int32_t lifi_queue_push(
+        lifi_frame_queue* q,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        int32_t count,
+        int64_t timestamp_ns,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h
+) {
+    if (!q) return 0;
+    return q->queue.push(y_plane, u_plane, v_plane, width, height,
+                         y_row_stride, uv_row_stride, uv_pixel_stride,
+                         count, timestamp_ns, x0, y0, w, h) ? 1 : 0;
+}
+
+int32_t lifi_queue_claim(
+        lifi_frame_queue* q,
+        int32_t width,
+        int32_t height,
+        int32_t count,
+        int64_t timestamp_ns,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        lifi_queue_slot* out
+) {
+    if (!q || !out) return 0;
+    QueuedFrame* f = q->queue.claim(width, height, count, timestamp_ns, x0, y0, w, h);
+    if (!f) return 0;
+    out->y = f->y;
+    out->u = f->u;
+    out->v = f->v;
+    out->x0 = f->originX;
+    out->y0 = f->originY;
+    out->width = f->width;
+    out->height = f->height;
+    return 1;
+}
+
+void lifi_queue_commit(lifi_frame_queue* q) {
+    if (q) q->queue.commit();
+}
+
+int32_t lifi_queue_process(
+        lifi_frame_queue* q,
+        lifi_session* session,
+        double* out_values,
+        int64_t* timestamp_ns,
+        uint64_t* seq
+) {
+    if (!q || !out_values) return 0;
+    if (!session) session = &defaultSession();
+    const QueuedFrame* f = q->queue.pop();
+    if (!f) return 0;
+
+    session->latency.stamp(f->sensorNs, f->enqueueNs);
+    lifi_session_process_frame_color(
+            session, f->y, f->u, f->v,
+            f->width, f->height, f->count,
+            f->width, (f->width + 1) / 2, 1,
+            f->roiX, f->roiY, f->roiW, f->roiH,
+            out_values);
+    if (timestamp_ns) *timestamp_ns = f->timestampNs;
+    if (seq) *seq = f->seq;
+    q->queue.release();
+    return 1;
+}
+
+void lifi_queue_get_stats(const lifi_frame_queue* q, lifi_queue_stats* out) {
+    if (!q || !out) return;
+    q->queue.stats(*out);
+}
+
+}
@@ -0,0 +1,106 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include "c_plugin.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounded single-producer / single-consumer queue of camera frames.
+//
+// The producer (camera callback) copies the ROI of each frame into a slot;
+// the consumer (decoder thread) pops slots and runs the pipeline on them.
+// Slots travel between the two sides by index through two lock-free rings:
+//
+//   full ring  producer -> consumer, up to `capacity` frames waiting
+//   free ring  consumer -> producer, slots handed back after decoding
+//
+// With capacity + 2 slots, one can be filling and one decoding while the
+// full ring is full. Dropping the oldest frame means the producer takes the
+// head of the full ring back with a CAS on the read index, the same CAS the
+// consumer pops with, so a slot is never written while it is being read.
+// Blocking is a spin-then-sleep wait on the consumer; nothing takes a mutex.
+//
+// Every offered frame gets a sequence number, so the consumer sees exactly
+// where frames were dropped and can use the timestamps to re-align symbols.
+
+struct QueuedFrame {
+    uint64_t seq;                   // producer sequence, gaps = drops
+    int64_t  timestampNs;           // sensor timestamp, or enqueueNs if none was given
+    int64_t  sensorNs;              // sensor timestamp, 0 if unknown
+    int64_t  enqueueNs;             // latencyNow() at push
+    int32_t  count;                 // Count argument for process_frame_color
+    int32_t  width, height;         // stored crop; Y stride = width
+    int32_t  originX, originY;      // crop position in the camera frame
+    int32_t  roiX, roiY, roiW, roiH;    // ROI inside the crop
+    uint8_t* y;
+    uint8_t* u;                     // planar, (width + 1) / 2 per row
+    uint8_t* v;
+};
+
+class FrameQueue {
+public:
+    FrameQueue(int capacity, int maxWidth, int maxHeight, lifi_queue_policy policy, int timeoutMs);
+
+    FrameQueue(const FrameQueue&) = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+
+    // Producer side. Copies the ROI (rounded out to even coordinates) of one
+    // YUV_420_888 frame. Returns false if this frame was dropped.
+    bool push(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+              int width, int height, int yRowStride, int uvRowStride, int uvPixelStride,
+              int count, int64_t timestampNs, int x0, int y0, int w, int h);
+
+    // Producer side in two steps, for callers that copy the ROI themselves:
+    // claim() reserves a slot for the ROI (same rounding as push) and
+    // returns it with the crop filled in, or nullptr if the frame was
+    // dropped; the caller fills y/u/v and then calls commit().
+    QueuedFrame* claim(int width, int height, int count, int64_t timestampNs,
+                       int x0, int y0, int w, int h);
+    void commit();
+
+    // Consumer side. The frame stays valid until the next pop() or release().
+    const QueuedFrame* pop();
+    void release();
+
+    void stats(lifi_queue_stats& out) const;
+
+private:
+    const uint32_t capacity;
+    const int maxW, maxH;
+    const lifi_queue_policy policy;
+    const int timeoutMs;
+
+    std::vector<uint8_t> storage;
+    std::vector<QueuedFrame> slots;                 // capacity + 2
+    std::vector<std::atomic<uint32_t>> fullRing;    // capacity entries
+    std::vector<std::atomic<uint32_t>> freeRing;    // capacity + 2 entries
+
+    // Full ring indices; tail is advanced by the consumer and, when
+    // dropping the oldest frame, by the producer
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    // Free ring indices
+    alignas(64) std::atomic<uint64_t> freeHead{0};
+    alignas(64) std::atomic<uint64_t> freeTail{0};
+
+    // Producer-owned; atomics only so stats() can read them from anywhere
+    alignas(64) std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> droppedOldest{0};
+    std::atomic<uint64_t> droppedNewest{0};
+    std::atomic<uint64_t> timeouts{0};
+    std::atomic<uint32_t> maxDepth{0};
+    uint64_t nextSeq = 0;
+    int spare = -1;                 // slot reclaimed from a dropped frame
+    int claimed = -1;               // slot handed out by claim()
+
+    // Consumer-owned
+    alignas(64) std::atomic<uint64_t> dequeued{0};
+    int held = -1;                  // slot handed out by pop()
+
+    bool waitForSpace(uint64_t h);
+    int takeFreeSlot();
+};
+
+#endif // FRAME_QUEUE_H
@@ -0,0 +1,99 @@
+#include "integral_image.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define INTEGRAL_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define INTEGRAL_SSE2 1
+#endif
+
+template <bool Count>
+void IntegralImage::buildImpl(const uint8_t* src, int stride, int x0, int y0, int w, int h,
+                              uint8_t threshold) {
+    originX = x0;
+    originY = y0;
+    regionW = std::max(0, w);
+    regionH = std::max(0, h);
+    tableStride = size_t(regionW) + 1;
+
+    // resize() never gives memory back, so steady state does not allocate
+    table.resize(tableStride * (size_t(regionH) + 1));
+    std::fill_n(table.begin(), tableStride, 0u);
+
+    for (int r = 0; r < regionH; ++r) {
+        const uint8_t*  s     = src + size_t(r) * stride;
+        const uint32_t* above = table.data() + size_t(r) * tableStride + 1;
+        uint32_t*       out   = table.data() + size_t(r + 1) * tableStride + 1;
+        out[-1] = 0;
+
+        int c = 0;
+        uint32_t carry = 0;
+
+        // Four pixels at a time: widen to 32-bit, in-register prefix sum
+        // (two shifted adds), add the running row total and the row above.
+#if INTEGRAL_NEON
+        const uint32x4_t zero = vdupq_n_u32(0);
+        const uint32x4_t one  = vdupq_n_u32(1);
+        const uint32x4_t thr  = vdupq_n_u32(threshold);
+        uint32x4_t vcarry = zero;
+        for (; c + 4 <= regionW; c += 4) {
+            uint32_t packed;
+            std::memcpy(&packed, s + c, 4);
+            uint8x8_t  b = vreinterpret_u8_u32(vdup_n_u32(packed));
+            uint32x4_t v = vmovl_u16(vget_low_u16(vmovl_u8(b)));
+            if (Count) v = vandq_u32(vcgtq_u32(v, thr), one);
+            v = vaddq_u32(v, vextq_u32(zero, v, 3));
+            v = vaddq_u32(v, vextq_u32(zero, v, 2));
+            v = vaddq_u32(v, vcarry);
+            vst1q_u32(out + c, vaddq_u32(v, vld1q_u32(above + c)));
+            vcarry = vdupq_n_u32(vgetq_lane_u32(v, 3));
+        }
+        carry = vgetq_lane_u32(vcarry, 0);
+#elif INTEGRAL_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one  = _mm_set1_epi32(1);
+        const __m128i thr  = _mm_set1_epi32(threshold);
+        __m128i vcarry = zero;
+        for (; c + 4 <= regionW; c += 4) {
+            int32_t packed;
+            std::memcpy(&packed, s + c, 4);
+            __m128i v = _mm_cvtsi32_si128(packed);
+            v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, zero), zero);
+            if (Count) v = _mm_and_si128(_mm_cmpgt_epi32(v, thr), one);
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, vcarry);
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(above + c));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + c), _mm_add_epi32(v, a));
+            vcarry = _mm_shuffle_epi32(v, 0xFF);
+        }
+        carry = uint32_t(_mm_cvtsi128_si32(vcarry));
+#endif
+        for (; c < regionW; ++c) {
+            carry += Count ? uint32_t(s[c] > threshold) : uint32_t(s[c]);
+            out[c] = carry + above[c];
+        }
+    }
+}
+
+void IntegralImage::build(const uint8_t* src, int stride, int x0, int y0, int w, int h) {
+    buildImpl<false>(src, stride, x0, y0, w, h, 0);
+}
+
+void IntegralImage::buildCount(const uint8_t* src, int stride, int x0, int y0, int w, int h,
+                               uint8_t threshold) {
+    buildImpl<true>(src, stride, x0, y0, w, h, threshold);
+}
+
+bool IntegralImage::clip(int& x, int& y, int& w, int& h) const {
+    int x1 = std::min(x + w, originX + regionW);
+    int y1 = std::min(y + h, originY + regionH);
+    x = std::max(x, originX);
+    y = std::max(y, originY);
+    w = x1 - x;
+    h = y1 - y;
+    return w > 0 && h > 0;
+}
@@ -0,0 +1,55 @@
+#ifndef INTEGRAL_IMAGE_H
+#define INTEGRAL_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Summed-area table over a rectangular region of an 8-bit plane.
+//
+// Built once per frame, after which the sum (or count) over any rectangle
+// inside the region is four loads. Entries are 32-bit, which holds a full
+// 4K frame of 255s (255 * 3840 * 2160 < 2^32). The table keeps a zero row
+// and column in front so lookups need no edge cases.
+class IntegralImage {
+public:
+    // Sums pixel values of the w x h region starting at `src` (frame
+    // coordinates x0, y0 are only remembered for lookups).
+    void build(const uint8_t* src, int stride, int x0, int y0, int w, int h);
+
+    // Counts pixels strictly above `threshold` instead of summing them,
+    // matching cv::THRESH_BINARY.
+    void buildCount(const uint8_t* src, int stride, int x0, int y0, int w, int h,
+                    uint8_t threshold);
+
+    bool empty() const { return regionW == 0 || regionH == 0; }
+
+    // Clips a frame-space rectangle to the built region. Returns false when
+    // nothing is left.
+    bool clip(int& x, int& y, int& w, int& h) const;
+
+    // Sum over a frame-space rectangle that lies inside the region.
+    uint32_t sum(int x, int y, int w, int h) const {
+        const uint32_t* t = table.data();
+        const int c0 = x - originX, r0 = y - originY;
+        const size_t top = size_t(r0) * tableStride, bot = size_t(r0 + h) * tableStride;
+        return t[bot + c0 + w] - t[bot + c0] - t[top + c0 + w] + t[top + c0];
+    }
+
+    int x() const { return originX; }
+    int y() const { return originY; }
+    int width() const { return regionW; }
+    int height() const { return regionH; }
+
+private:
+    template <bool Count>
+    void buildImpl(const uint8_t* src, int stride, int x0, int y0, int w, int h,
+                   uint8_t threshold);
+
+    std::vector<uint32_t> table;
+    size_t tableStride = 0;
+    int originX = 0, originY = 0;
+    int regionW = 0, regionH = 0;
+};
+
+#endif // INTEGRAL_IMAGE_H
@@ -0,0 +1,143 @@
+#include "latency_tracker.h"
+#include "lifi_session.h"
+#include "trace_ring.h"
+#include <atomic>
+#include <cstring>
+#include <time.h>
+
+static std::atomic<clockid_t> latencyClock{CLOCK_MONOTONIC};
+
+int64_t latencyNow() {
+    timespec ts;
+    clock_gettime(latencyClock.load(std::memory_order_relaxed), &ts);
+    return int64_t(ts.tv_sec) * 1000000000ll + int64_t(ts.tv_nsec);
+}
+
+// ns span -> trace field in µs, saturating; 0 for unknown or negative
+static uint32_t toMicros(int64_t from, int64_t to) {
+    if (from <= 0 || to < from) return 0;
+    const uint64_t us = uint64_t(to - from) / 1000u;
+    return us > UINT32_MAX ? UINT32_MAX : uint32_t(us);
+}
+
+void LatencyTracker::record(int span, int64_t from, int64_t to) {
+    if (from <= 0 || to < from) return;
+    stats[span].add(uint64_t(to - from));
+}
+
+void LatencyTracker::decide(lifi_trace_record& rec) {
+    const int64_t now = latencyNow();
+    record(LIFI_LATENCY_PROCESSING, startNs, now);
+    record(LIFI_LATENCY_SENSOR_TO_DECISION, pendingSensorNs, now);
+    record(LIFI_LATENCY_SENSOR_TO_ENQUEUE, pendingSensorNs, pendingEnqueueNs);
+    record(LIFI_LATENCY_QUEUE_WAIT, pendingEnqueueNs, startNs);
+
+    rec.sensor_ns  = pendingSensorNs;
+    rec.latency_us = toMicros(pendingSensorNs, now);
+    rec.wait_us    = toMicros(pendingEnqueueNs, startNs);
+    rec.flags     |= pendingSensorNs > 0 ? cadence.frame(pendingSensorNs, true, now - startNs)
+                                         : cadence.frame(startNs, false, now - startNs);
+
+    // A stamp covers one frame only
+    pendingSensorNs  = 0;
+    pendingEnqueueNs = 0;
+    lastDecisionNs   = now;
+}
+
+void LatencyTracker::markByte(uint8_t value, int64_t firstSensorNs, int64_t lastSensorNs,
+                              lifi_trace_record& rec) {
+    const int64_t now = latencyNow();
+    record(LIFI_LATENCY_DECISION_TO_BYTE, lastDecisionNs, now);
+    record(LIFI_LATENCY_SENSOR_TO_BYTE, lastSensorNs, now);
+    record(LIFI_LATENCY_CHARACTER, firstSensorNs, now);
+
+    std::memset(&rec, 0, sizeof(rec));
+    rec.frame      = bytes++;
+    rec.sensor_ns  = lastSensorNs;
+    rec.latency_us = toMicros(lastSensorNs, now);
+    rec.wait_us    = toMicros(lastDecisionNs, now);
+    rec.encoded    = value;
+    rec.flags      = LIFI_TRACE_BYTE;
+}
+
+void LatencyTracker::snapshot(lifi_latency_stats& out) const {
+    for (int i = 0; i < LIFI_LATENCY_COUNT; ++i) stats[i].snapshot(out.spans[i]);
+}
+
+void LatencyTracker::reset() {
+    for (LatencyStat& s : stats) s.reset();
+    bytes = 0;
+}
+
+// ---------------------------------------------------------------------------
+// C API
+
+extern "C" {
+
+void lifi_latency_set_clock(int32_t clock) {
+#ifdef CLOCK_BOOTTIME
+    latencyClock.store(clock == LIFI_CLOCK_BOOTTIME ? CLOCK_BOOTTIME : CLOCK_MONOTONIC,
+                       std::memory_order_relaxed);
+#else
+    // macOS host builds: no suspend-aware clock, monotonic is the closest
+    (void)clock;
+    latencyClock.store(CLOCK_MONOTONIC, std::memory_order_relaxed);
+#endif
+}
+
+int64_t lifi_latency_now(void) {
+    return latencyNow();
+}
+
+void lifi_session_stamp_frame(lifi_session* session, int64_t sensor_timestamp_ns) {
+    if (!session) session = &defaultSession();
+    session->latency.stamp(sensor_timestamp_ns);
+}
+
+void lifi_session_mark_byte(
+        lifi_session* session,
+        uint8_t value,
+        int64_t first_sensor_ns,
+        int64_t last_sensor_ns
+) {
+    if (!session) session = &defaultSession();
+    lifi_trace_record rec;
+    session->latency.markByte(value, first_sensor_ns, last_sensor_ns, rec);
+    rec.session = session->id;
+    rec.t_ns    = traceNow();
+    traceRing().push(rec);
+}
+
+void lifi_get_latency_stats(const lifi_session* session, lifi_latency_stats* out) {
+    if (!out) return;
+    if (!session) session = &defaultSession();
+    session->latency.snapshot(*out);
+}
+
+void lifi_reset_latency_stats(lifi_session* session) {
+    if (!session) session = &defaultSession();
+    session->latency.reset();
+}
+
+void lifi_session_set_frame_budget(lifi_session* session, int64_t period_ns, int64_t budget_ns) {
+    if (!session) session = &defaultSession();
+    session->latency.cadence.configure(period_ns, budget_ns);
+}
+
+int32_t lifi_session_frames_missed(const lifi_session* session) {
+    if (!session) session = &defaultSession();
+    return session->latency.cadence.lastMissed();
+}
+
+void lifi_get_cadence_stats(const lifi_session* session, lifi_cadence_stats* out) {
+    if (!out) return;
+    if (!session) session = &defaultSession();
+    session->latency.cadence.snapshot(*out);
+}
+
+void lifi_reset_cadence_stats(lifi_session* session) {
+    if (!session) session = &defaultSession();
+    session->latency.cadence.reset();
+}
+
+}
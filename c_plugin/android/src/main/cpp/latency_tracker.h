@@ -0,0 +1,60 @@
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
+
+#include "c_plugin.h"
+#include "frame_cadence.h"
+#include "stage_timing.h"
+#include <cstdint>
+
+// Current time on the clock chosen with lifi_latency_set_clock, in ns.
+// Sensor timestamps must be on the same clock for the spans to mean
+// anything; Camera2 reports which one in SENSOR_INFO_TIMESTAMP_SOURCE.
+int64_t latencyNow();
+
+// End-to-end latency of one session, from the sensor timestamp of a frame
+// to the byte it ends up in.
+//
+//   stamp()    sensor timestamp (and enqueue time) of the next frame
+//   begin()    processing of that frame starts
+//   decide()   symbol decision made; fills the frame's trace record
+//   markByte() the decoder above us emitted a byte
+//
+// Each boundary feeds one LatencyStat, indexed by lifi_latency_span. A frame
+// without a sensor timestamp only counts towards PROCESSING. Negative spans
+// (timestamps on the wrong clock) are dropped rather than wrapped.
+//
+// decide() also feeds `cadence`, with the sensor timestamp or, for frames
+// without one, the time processing started.
+class LatencyTracker {
+public:
+    FrameCadence cadence;
+
+    void stamp(int64_t sensorNs, int64_t enqueueNs = 0) {
+        pendingSensorNs  = sensorNs;
+        pendingEnqueueNs = enqueueNs;
+    }
+
+    void begin() { startNs = latencyNow(); }
+
+    // Records the spans of the frame in progress and fills sensor_ns,
+    // latency_us, wait_us and the cadence flags of its trace record.
+    void decide(lifi_trace_record& rec);
+
+    // Records a byte and fills `rec` as a LIFI_TRACE_BYTE record.
+    void markByte(uint8_t value, int64_t firstSensorNs, int64_t lastSensorNs, lifi_trace_record& rec);
+
+    void snapshot(lifi_latency_stats& out) const;
+    void reset();
+
+private:
+    void record(int span, int64_t from, int64_t to);
+
+    LatencyStat stats[LIFI_LATENCY_COUNT];
+    int64_t  pendingSensorNs  = 0;
+    int64_t  pendingEnqueueNs = 0;
+    int64_t  startNs          = 0;
+    int64_t  lastDecisionNs   = 0;
+    uint32_t bytes            = 0;
+};
+
+#endif // LATENCY_TRACKER_H
@@ -0,0 +1,15 @@
+#ifndef LIFI_LOG_H
+#define LIFI_LOG_H
+
+// Logging that also builds off-device: logcat on Android, stderr elsewhere
+// (host tools and benchmarks).
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LIFI_LOGI(tag, ...) __android_log_print(ANDROID_LOG_INFO, tag, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LIFI_LOGI(tag, ...) \
+    (std::fprintf(stderr, "I/%s: ", tag), std::fprintf(stderr, __VA_ARGS__), std::fputc('\n', stderr))
+#endif
+
+#endif // LIFI_LOG_H
@@ -0,0 +1,154 @@
+#include "c_plugin.h"
+#include "lifi_session.h"
+#include <algorithm>
+#include <atomic>
+
+void lifi_session::configure(int w, int h) {
+    maxWidth  = std::max(1, w);
+    maxHeight = std::max(1, h);
+    roi.configure(maxWidth, blockSize);
+    blockSize = roi.blockSize();
+    frameMatrix.configure(maxHeight / blockSize, maxWidth / blockSize);
+}
+
+void lifi_session::setBlockSize(int size) {
+    blockSize = size;
+    configure(maxWidth, maxHeight);
+    ambient.reset();
+    luma.reset();
+}
+
+void lifi_session::reset() {
+    for (int i = 0; i < LIFI_WINDOW; ++i) {
+        history[i] = 0.0;
+        ledOnOffHistory[i] = 1.0;
+    }
+    idx = 0;
+    full = false;
+    ledOn = false;
+    color = -1;
+    frameIndex = 0;
+    firstTimeToggle = false;
+    ambient.reset();
+    luma.reset();
+}
+
+int32_t checkFrame(const lifi_frame_desc* frame) {
+    if (!frame || !frame->y_plane) return LIFI_ERR_ARGUMENT;
+    if (frame->roi_count > 0 && !frame->rois) return LIFI_ERR_ARGUMENT;
+    if (frame->version != LIFI_ABI_VERSION) return LIFI_ERR_VERSION;
+    if (frame->width <= 0 || frame->height <= 0 || frame->y_row_stride < 0) return LIFI_ERR_ARGUMENT;
+    switch (frame->format) {
+        case LIFI_FORMAT_YUV_420_888:
+            if (!frame->u_plane || !frame->v_plane) return LIFI_ERR_ARGUMENT;
+            return frame->uv_row_stride > 0 && frame->uv_pixel_stride > 0 ? 0 : LIFI_ERR_ARGUMENT;
+        case LIFI_FORMAT_NV21:
+        case LIFI_FORMAT_NV12:
+        case LIFI_FORMAT_I420:
+            return 0;
+        default:
+            return LIFI_ERR_FORMAT;
+    }
+}
+
+lifi_frame_desc framePlanes(const lifi_frame_desc& frame) {
+    lifi_frame_desc planes = frame;
+    if (planes.y_row_stride == 0) planes.y_row_stride = frame.width;
+    if (frame.format == LIFI_FORMAT_YUV_420_888) return planes;
+
+    planes.format = LIFI_FORMAT_YUV_420_888;
+    const uint8_t* chroma = frame.y_plane + size_t(planes.y_row_stride) * frame.height;
+
+    if (frame.format == LIFI_FORMAT_I420) {
+        if (planes.uv_row_stride <= 0) planes.uv_row_stride = (planes.y_row_stride + 1) / 2;
+        planes.uv_pixel_stride = 1;
+        planes.u_plane = chroma;
+        planes.v_plane = chroma + size_t(planes.uv_row_stride) * ((frame.height + 1) / 2);
+    } else {
+        if (planes.uv_row_stride <= 0) planes.uv_row_stride = planes.y_row_stride;
+        planes.uv_pixel_stride = 2;
+        const bool vFirst = frame.format == LIFI_FORMAT_NV21;
+        planes.u_plane = vFirst ? chroma + 1 : chroma;
+        planes.v_plane = vFirst ? chroma : chroma + 1;
+    }
+    return planes;
+}
+
+lifi_session& defaultSession() {
+    static lifi_session session;
+    return session;
+}
+
+extern "C" {
+
+lifi_session* lifi_session_create(int32_t max_width, int32_t max_height) {
+    static std::atomic<uint32_t> nextId{1};
+    lifi_session* session = new lifi_session();
+    session->id = nextId.fetch_add(1, std::memory_order_relaxed);
+    session->configure(max_width, max_height);
+    return session;
+}
+
+void lifi_session_destroy(lifi_session* session) {
+    delete session;
+}
+
+void lifi_session_set_block_size(lifi_session* session, int32_t block_size) {
+    if (!session) return;
+    session->setBlockSize(block_size);
+}
+
+void lifi_session_set_ambient_rejection(
+        lifi_session* session,
+        int32_t background_ring,
+        int32_t filter_type,
+        double fps,
+        double freq_hz,
+        double q
+) {
+    if (!session) return;
+    AmbientConfig cfg;
+    cfg.ringBlocks = background_ring;
+    cfg.filterType = filter_type;
+    cfg.fps        = fps;
+    cfg.freqHz     = freq_hz;
+    cfg.q          = q;
+    session->ambient.configure(cfg);
+}
+
+void lifi_session_set_luma_estimator(lifi_session* session, int32_t mode, int32_t change_threshold) {
+    if (!session) return;
+    session->luma.configure(mode, change_threshold);
+}
+
+int32_t lifi_get_stage_stats(const lifi_session* session, lifi_stage_stats* out) {
+    if (!out) return 0;
+    if (!session) session = &defaultSession();
+    session->timing.snapshot(*out);
+    return out->enabled;
+}
+
+void lifi_reset_stage_stats(lifi_session* session) {
+    if (!session) session = &defaultSession();
+    session->timing.reset();
+}
+
+void set_ambient_rejection(
+        int32_t background_ring,
+        int32_t filter_type,
+        double fps,
+        double freq_hz,
+        double q
+) {
+    lifi_session_set_ambient_rejection(&defaultSession(), background_ring, filter_type, fps, freq_hz, q);
+}
+
+void set_luma_estimator(int32_t mode, int32_t change_threshold) {
+    lifi_session_set_luma_estimator(&defaultSession(), mode, change_threshold);
+}
+
+void set_block_size(int32_t block_size) {
+    lifi_session_set_block_size(&defaultSession(), block_size);
+}
+
+}
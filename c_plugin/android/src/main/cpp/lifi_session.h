@@ -0,0 +1,87 @@
+#ifndef LIFI_SESSION_H
+#define LIFI_SESSION_H
+
+#include "ambient_filter.h"
+#include "block_grid.h"
+#include "latency_tracker.h"
+#include "luma_estimator.h"
+#include "result_block.h"
+#include "roi_pipeline.h"
+#include "scratch_arena.h"
+#include "stage_timing.h"
+#include <cstdint>
+#include <limits>
+
+// Frames in the dynamic-threshold window and in the block grid history.
+constexpr int LIFI_WINDOW = 5;
+
+// Default block size of the downsampled grid.
+constexpr int LIFI_BLOCK_SIZE = 10;
+
+// Per-stream decoder state.
+//
+// Everything process_frame_color used to keep in function statics lives
+// here, so independent streams do not share history, and every buffer is
+// sized once in configure() instead of being fixed at 256x256.
+struct lifi_session {
+    uint32_t id = 0;    // trace id; 0 for the default session
+
+    int maxWidth  = 0;
+    int maxHeight = 0;
+    int blockSize = LIFI_BLOCK_SIZE;
+
+    // Dynamic threshold window
+    double history[LIFI_WINDOW] = {};
+    double ledOnOffHistory[LIFI_WINDOW] = {1.0, 1.0, 1.0, 1.0, 1.0};
+    int  idx   = 0;
+    bool full  = false;
+    bool ledOn = false;
+    bool firstTimeToggle = true;
+    int  color = -1;    // classify_hsv_color code of the last frame, -1 after a reset
+
+    // Running brightness range of process_frame
+    double lumaMin = std::numeric_limits<double>::infinity();
+    double lumaMax = -std::numeric_limits<double>::infinity();
+
+    // Downsampled block grid of the last LIFI_WINDOW frames
+    BlockGridRing<LIFI_WINDOW> frameMatrix;
+    int frameIndex = 0;
+    int frameCount = 0;
+
+    RoiPipeline   roi;
+    AmbientFilter ambient;
+    LumaEstimator luma;
+    StageTiming   timing;
+    LatencyTracker latency;     // kept across count == 0 resets
+    ResultBlock   shared;       // latest decision, for readers that must not block us
+
+    // Per-frame temporaries, reset at the start of every frame
+    ScratchArena  scratch;
+
+    // Sizes the ROI buffers and the grid history for frames up to
+    // maxWidth x maxHeight at the current block size. Filter and estimator
+    // settings are kept.
+    void configure(int maxWidth, int maxHeight);
+
+    // Changes the block size and re-sizes the buffers. The grid history is
+    // dropped since old grids no longer line up.
+    void setBlockSize(int blockSize);
+
+    // Clears the decoding history (process_frame_color with count == 0).
+    void reset();
+};
+
+// 0 if lifi_session_decode / lifi_decode can read the frame, else the
+// LIFI_ERR_* code to return.
+int32_t checkFrame(const lifi_frame_desc* frame);
+
+// A checked frame as YUV_420_888 planes with y_row_stride 0 made the width:
+// the packed formats get the plane pointers and strides of the chroma
+// stored after their Y rows.
+lifi_frame_desc framePlanes(const lifi_frame_desc& frame);
+
+// Session used by the session-less entry points. Grows to the frame size on
+// first use.
+lifi_session& defaultSession();
+
+#endif // LIFI_SESSION_H
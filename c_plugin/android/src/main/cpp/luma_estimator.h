@@ -0,0 +1,94 @@
+#ifndef LUMA_ESTIMATOR_H
+#define LUMA_ESTIMATOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// How process_frame_color turns the downsampled block grid into one Y value.
+enum LumaEstimatorMode {
+    LUMA_ESTIMATOR_MEAN              = 0,  // plain mean of all blocks
+    LUMA_ESTIMATOR_TEMPORAL_VARIANCE = 1,  // blocks weighted by their max-min over the last 3 frames
+};
+
+// Luma estimator over the block grid history.
+//
+// In temporal-variance mode every block is weighted by how much it changed
+// across the last three frames, so the modulating LED pixels dominate and the
+// static background drops out. The 3-frame min/max is kept incrementally: we
+// store min/max of the previous two frames per block, so each new frame costs
+// one compare per block instead of a rescan of the history.
+class LumaEstimator {
+public:
+    void configure(int mode_, int changeThreshold_) {
+        mode = mode_;
+        changeThreshold = std::max(0, changeThreshold_);
+        reset();
+    }
+    int  currentMode() const { return mode; }
+    void reset() { framesSeen = 0; gridH = gridW = 0; }
+
+    // `cur` and `prev` are the current and previous grids (`g[r][c]`), the
+    // estimate covers blocks [r0,r1) x [c0,c1). `prev` is ignored until a
+    // second frame of the same geometry has been seen.
+    template <typename Grid>
+    double estimate(const Grid& cur, const Grid& prev, int h, int w,
+                    int r0, int c0, int r1, int c1) {
+        if (h != gridH || w != gridW) {
+            gridH = h;
+            gridW = w;
+            pairMin.assign(size_t(h) * w, 0);
+            pairMax.assign(size_t(h) * w, 0);
+            framesSeen = 0;
+        }
+
+        uint64_t sumY = 0, weightSum = 0;
+        uint64_t plainSum = 0;
+        const bool weighted = mode == LUMA_ESTIMATOR_TEMPORAL_VARIANCE && framesSeen >= 2;
+
+        for (int r = r0; r < r1; ++r) {
+            uint8_t* pMin = pairMin.data() + size_t(r) * w;
+            uint8_t* pMax = pairMax.data() + size_t(r) * w;
+            for (int c = c0; c < c1; ++c) {
+                int v = cur[r][c];
+                plainSum += v;
+                if (weighted) {
+                    int diff = std::max<int>(pMax[c], v) - std::min<int>(pMin[c], v);
+                    if (diff > changeThreshold) {
+                        sumY += uint64_t(v) * diff;
+                        weightSum += diff;
+                    }
+                }
+            }
+        }
+
+        // Roll the pair window forward: it now holds {prev, cur}
+        if (mode == LUMA_ESTIMATOR_TEMPORAL_VARIANCE) {
+            for (int r = 0; r < h; ++r) {
+                uint8_t* pMin = pairMin.data() + size_t(r) * w;
+                uint8_t* pMax = pairMax.data() + size_t(r) * w;
+                for (int c = 0; c < w; ++c) {
+                    uint8_t v = cur[r][c];
+                    uint8_t p = framesSeen >= 1 ? uint8_t(prev[r][c]) : v;
+                    pMin[c] = std::min(v, p);
+                    pMax[c] = std::max(v, p);
+                }
+            }
+        }
+        ++framesSeen;
+
+        if (weighted && weightSum > 0) return double(sumY) / weightSum;
+
+        const int n = (r1 - r0) * (c1 - c0);
+        return n > 0 ? double(plainSum) / n : 0.0;
+    }
+
+private:
+    int mode = LUMA_ESTIMATOR_MEAN;
+    int changeThreshold = 0;
+    int framesSeen = 0;
+    int gridH = 0, gridW = 0;
+    std::vector<uint8_t> pairMin, pairMax;
+};
+
+#endif // LUMA_ESTIMATOR_H
@@ -0,0 +1,67 @@
+#include "luma_histogram.h"
+#include <algorithm>
+#include <cstring>
+
+void lumaHistogram(const uint8_t* src, int stride, int w, int h, uint32_t hist[256]) {
+    uint32_t bank[4][256];
+    std::memset(bank, 0, sizeof(bank));
+
+    for (int r = 0; r < h; ++r) {
+        const uint8_t* row = src + size_t(r) * stride;
+        int c = 0;
+        for (; c + 8 <= w; c += 8) {
+            uint64_t px;
+            std::memcpy(&px, row + c, sizeof(px));
+            ++bank[0][px & 0xFF];
+            ++bank[1][(px >> 8) & 0xFF];
+            ++bank[2][(px >> 16) & 0xFF];
+            ++bank[3][(px >> 24) & 0xFF];
+            ++bank[0][(px >> 32) & 0xFF];
+            ++bank[1][(px >> 40) & 0xFF];
+            ++bank[2][(px >> 48) & 0xFF];
+            ++bank[3][px >> 56];
+        }
+        for (; c < w; ++c) ++bank[c & 3][row[c]];
+    }
+
+    for (int v = 0; v < 256; ++v) {
+        hist[v] = bank[0][v] + bank[1][v] + bank[2][v] + bank[3][v];
+    }
+}
+
+LumaStats lumaStats(const uint32_t hist[256]) {
+    LumaStats s;
+    int total = 0;
+    for (int v = 0; v < 256; ++v) total += int(hist[v]);
+    s.total = total;
+    if (total == 0) return s;
+
+    const int mid     = total / 2;
+    const int lowCut  = total / 10;
+    const int highCut = total - lowCut;
+
+    double sum = 0.0, trimSum = 0.0;
+    int  cum = 0;
+    bool haveMedian = false;
+    for (int v = 0; v < 256; ++v) {
+        const int count = int(hist[v]);
+        const int before = cum;
+        cum += count;
+
+        sum += double(v) * count;
+
+        // Median: first bin where the running count reaches half
+        if (!haveMedian && cum >= mid) {
+            s.median = v;
+            haveMedian = true;
+        }
+
+        // Trimmed mean: the part of this bin inside [lowCut, highCut)
+        const int used = std::min(cum, highCut) - std::max(before, lowCut);
+        if (used > 0) trimSum += double(v) * used;
+    }
+
+    s.mean    = sum / total;
+    s.trimmed = trimSum / double(highCut - lowCut);
+    return s;
+}
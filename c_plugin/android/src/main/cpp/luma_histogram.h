@@ -0,0 +1,24 @@
+#ifndef LUMA_HISTOGRAM_H
+#define LUMA_HISTOGRAM_H
+
+#include <cstdint>
+
+// Brightness statistics of one ROI, as blended by process_frame.
+struct LumaStats {
+    double mean    = 0.0;
+    double median  = 0.0;
+    double trimmed = 0.0;   // mean without the lowest and highest 10%
+    int    total   = 0;
+};
+
+// 256-bin histogram of the w x h region at `src`.
+//
+// Pixels are read eight at a time and spread over four sub-histograms, so
+// runs of equal values do not serialise on one counter; the banks are
+// summed into `hist` at the end.
+void lumaHistogram(const uint8_t* src, int stride, int w, int h, uint32_t hist[256]);
+
+// Mean, median and trimmed mean from one cumulative pass over `hist`.
+LumaStats lumaStats(const uint32_t hist[256]);
+
+#endif // LUMA_HISTOGRAM_H
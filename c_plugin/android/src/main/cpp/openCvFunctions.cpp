@@ -1,114 +1,95 @@
 #include "c_plugin.h"
+#include "chroma_layout.h"
+#include "integral_image.h"
+#include "lifi_session.h"
+#include "luma_histogram.h"
+#include "lifi_log.h"
+#include "trace_ring.h"
+#include "worker_pool.h"
+
+// Host builds (tools/) may not have OpenCV; only detect_bright_regions needs it
+#ifndef LIFI_HAVE_OPENCV
+#define LIFI_HAVE_OPENCV 1
+#endif
+#if LIFI_HAVE_OPENCV
 #include <opencv2/opencv.hpp>
+#endif
 #include <cmath>
 #include <vector>
 #include <limits>
 #include <cstdint>
+#include <cstring>
 #include <algorithm>
-#include <android/log.h>
 #include <iomanip>
 #include <sstream>
 #include <numeric>
 
 #define LOG_TAG "NativeDebug"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) LIFI_LOGI(LOG_TAG, __VA_ARGS__)
 
 
 
+#if LIFI_HAVE_OPENCV
 using namespace cv;
-constexpr int MAX_H = 256;
-constexpr int MAX_W = 256;
-uint8_t filtered_matrix[MAX_H][MAX_W];
+#endif
 
-int frame_count= 0;
-bool firstTimeToggle = true;
+// Per-frame integral images of the Y plane (see lifi_integral_build). One
+// set per thread, so sessions and pool workers never share a table.
+static thread_local IntegralImage frameIntegral;
+static thread_local IntegralImage frameCountIntegral;
+static thread_local IntegralImage ledPollIntegral;
+
+// Clamp an LED ROI to the frame the same way detect_led_on always has
+static inline void clampRoi(int width, int height, int& x, int& y, int& w, int& h) {
+    x = std::max(0, std::min(x, width-1));
+    y = std::max(0, std::min(y, height-1));
+    w = std::max(1, std::min(w, width - x));
+    h = std::max(1, std::min(h, height - y));
+}
 inline uint8_t median3(uint8_t a, uint8_t b, uint8_t c) {
     return a > b ? (b > c ? b : (a > c ? c : a))
                  : (a > c ? a : (b > c ? b : c));
 }
-std::vector<std::vector<uint8_t>> downsampleMatrix10x10(
-        const uint8_t matrix[MAX_H][MAX_W],
-        int height,
-        int width
-) {
-    const int blockSize = 10;
-    const int newH = height / blockSize;
-    const int newW = width  / blockSize;
-
-    std::vector<std::vector<uint8_t>> downsampled(newH, std::vector<uint8_t>(newW, 0));
-
-    for (int r = 0; r < newH; ++r) {
-        for (int c = 0; c < newW; ++c) {
-            int sum = 0;
-            int count = 0;
-
-            for (int i = 0; i < blockSize; ++i) {
-                for (int j = 0; j < blockSize; ++j) {
-                    int origR = r * blockSize + i;
-                    int origC = c * blockSize + j;
-
-                    if (origR < height && origC < width) {
-                        sum += matrix[origR][origC];
-                        count++;
-                    }
-                }
-            }
-
-            downsampled[r][c] = static_cast<uint8_t>(sum / count);
-        }
-    }
-
-    return downsampled;
-}
 extern "C" {
 
 double color_hsv[3];
 
 
-//static uint8_t frame_matrix[3][MAX_H][MAX_W];
-static std::vector<std::vector<uint8_t>> frame_matrix[3];
-bool threeFramesCaptured = false;
-static int frame_index = 0;
 //std::vector<std::vector<uint8_t>> brightness_matrix(h, std::vector<uint8_t>(w));
 // Returns a pointer to a NUL-terminated const char* of the form "4.5.2"
 
-void debugPrintVectorMatrix(const std::vector<std::vector<uint8_t>>& mat) {
-    LOGI("Downsampled Matrix: %d x %d", static_cast<int>(mat[0].size()), static_cast<int>(mat.size()));
-    for (const auto& row : mat) {
-        std::string line;
-        for (const auto& val : row) {
-            line += std::to_string(val) + " ";
-        }
-        LOGI("%s", line.c_str());
-    }
-}
-
-
 
-
-void detect_bright_regions(
-        const uint8_t* nv21_data,
+#if LIFI_HAVE_OPENCV
+// Bright blobs in a Y plane of `stride` bytes per row, largest first
+static int bright_regions(
+        const uint8_t* y_plane,
+        int stride,
         int width,
         int height,
         uint8_t threshold,
         int max_regions,
-        int* bbox_out,
-        int* count_out
+        int* bbox_out
 ) {
-    // Wrap NV21 data
-    cv::Mat yuv(height + height/2, width, CV_8UC1, const_cast<uint8_t*>(nv21_data));
-    cv::Mat gray;
-    cv::cvtColor(yuv, gray, cv::COLOR_YUV2GRAY_NV21);
+    // Wrap the Y plane in place: this is exactly what COLOR_YUV2GRAY_NV21
+    // would copy out, and the row step covers padded planes
+    cv::Mat gray(height, width, CV_8UC1, const_cast<uint8_t*>(y_plane), size_t(stride));
+
+    // Per-frame images live in an arena so steady state does not allocate
+    static thread_local ScratchArena scratch;
+    scratch.reset();
+    cv::Mat bin(height, width, CV_8UC1, scratch.alloc(size_t(width) * height));
+    cv::Mat eroded(height, width, CV_8UC1, scratch.alloc(size_t(width) * height));
 
     // Threshold
-    cv::Mat bin;
     cv::threshold(gray, bin, threshold, 255, cv::THRESH_BINARY);
-    // Clean
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, {3,3});
-    cv::morphologyEx(bin, bin, cv::MORPH_OPEN, kernel);
-
-    // Find contours
-    std::vector<std::vector<cv::Point>> contours;
+    // Clean: MORPH_OPEN spelled out so the intermediate is ours
+    static const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, {3,3});
+    cv::erode(bin, eroded, kernel);
+    cv::dilate(eroded, bin, kernel);
+
+    // Find contours; the vectors keep their capacity between frames.
+    // findContours still uses OpenCV's own storage internally.
+    static thread_local std::vector<std::vector<cv::Point>> contours;
     cv::findContours(bin, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
     // Sort by area desc
     std::sort(contours.begin(), contours.end(), [](auto &a, auto &b) {
@@ -127,39 +108,182 @@ void detect_bright_regions(
         bbox_out[idx + 3] = r.height;
         found++;
     }
-    *count_out = found;
+    return found;
 }
 
-uint8_t detect_led_on(
+void detect_bright_regions(
         const uint8_t* nv21_data,
         int width,
         int height,
         uint8_t threshold,
+        int max_regions,
+        int* bbox_out,
+        int* count_out
+) {
+    // NV21 starts with the full-resolution Y plane
+    *count_out = bright_regions(nv21_data, width, width, height, threshold, max_regions, bbox_out);
+}
+#endif
+
+// LED ROI (x, y, w, h) of a Y plane with `stride` bytes per row
+static uint8_t led_on(
+        const uint8_t* y_plane,
+        int stride,
+        int width,
+        int height,
+        uint8_t threshold,
         int x,
         int y,
         int w,
         int h
 ) {
-    cv::Mat yuv(height + height/2, width, CV_8UC1, const_cast<uint8_t*>(nv21_data));
-    cv::Mat gray;
-    cv::cvtColor(yuv, gray, cv::COLOR_YUV2GRAY_NV21);
-
-    // Crop ROI, clamp
-    x = std::max(0, std::min(x, width-1));
-    y = std::max(0, std::min(y, height-1));
-    w = std::max(1, std::min(w, width - x));
-    h = std::max(1, std::min(h, height - y));
-    cv::Mat patch = gray(cv::Rect(x, y, w, h));
+    // Threshold the Y plane in place instead of converting the whole frame
+    // to gray first.
+    clampRoi(width, height, x, y, w, h);
 
-    // Threshold and count
-    cv::Mat bin;
-    cv::threshold(patch, bin, threshold, 255, cv::THRESH_BINARY);
-    int bright = cv::countNonZero(bin);
-    int total = patch.rows * patch.cols;
+    int bright = 0;
+    for (int r = 0; r < h; ++r) {
+        const uint8_t* row = y_plane + (y + r) * stride + x;
+        for (int c = 0; c < w; ++c) {
+            bright += row[c] > threshold;
+        }
+    }
+    int total = w * h;
     // ON if >5% bright
     return (bright * 100 > total * 5) ? 1 : 0;
 }
-void process_frame(
+
+// roi_count ROIs as (x, y, w, h) quadruples
+static void leds_on(
+        const uint8_t* y_plane,
+        int stride,
+        int width,
+        int height,
+        uint8_t threshold,
+        const int* rois,
+        int roi_count,
+        uint8_t* out_on
+) {
+    if (roi_count <= 0) return;
+    if (roi_count == 1) {
+        out_on[0] = led_on(y_plane, stride, width, height, threshold,
+                           rois[0], rois[1], rois[2], rois[3]);
+        return;
+    }
+
+    // One count table over the bounding box of every LED, then 4 loads per LED
+    int bx0 = width, by0 = height, bx1 = 0, by1 = 0;
+    for (int i = 0; i < roi_count; ++i) {
+        int x = rois[i*4 + 0], y = rois[i*4 + 1], w = rois[i*4 + 2], h = rois[i*4 + 3];
+        clampRoi(width, height, x, y, w, h);
+        bx0 = std::min(bx0, x);     by0 = std::min(by0, y);
+        bx1 = std::max(bx1, x + w); by1 = std::max(by1, y + h);
+    }
+    ledPollIntegral.buildCount(y_plane + by0 * stride + bx0, stride,
+                               bx0, by0, bx1 - bx0, by1 - by0, threshold);
+
+    for (int i = 0; i < roi_count; ++i) {
+        int x = rois[i*4 + 0], y = rois[i*4 + 1], w = rois[i*4 + 2], h = rois[i*4 + 3];
+        clampRoi(width, height, x, y, w, h);
+        int bright = int(ledPollIntegral.sum(x, y, w, h));
+        out_on[i] = (bright * 100 > w * h * 5) ? 1 : 0;
+    }
+}
+
+uint8_t detect_led_on(
+        const uint8_t* nv21_data,
+        int width,
+        int height,
+        uint8_t threshold,
+        int x,
+        int y,
+        int w,
+        int h
+) {
+    // NV21 starts with the full-resolution Y plane
+    return led_on(nv21_data, width, width, height, threshold, x, y, w, h);
+}
+
+void detect_leds_on(
+        const uint8_t* nv21_data,
+        int width,
+        int height,
+        uint8_t threshold,
+        const int* rois,
+        int roi_count,
+        uint8_t* out_on
+) {
+    leds_on(nv21_data, width, width, height, threshold, rois, roi_count, out_on);
+}
+
+static_assert(sizeof(lifi_roi) == 4 * sizeof(int), "lifi_roi is an (x, y, w, h) quadruple");
+
+int32_t lifi_detect_leds_on(const lifi_frame_desc* frame, uint8_t threshold, uint8_t* out_on) {
+    if (!out_on) return LIFI_ERR_ARGUMENT;
+    const int32_t status = checkFrame(frame);
+    if (status != 0) return status;
+
+    const lifi_frame_desc planes = framePlanes(*frame);
+    const lifi_roi whole{0, 0, planes.width, planes.height};
+    const lifi_roi* rois = planes.roi_count > 0 ? planes.rois : &whole;
+    const int n = std::max(1, planes.roi_count);
+    leds_on(planes.y_plane, planes.y_row_stride, planes.width, planes.height, threshold,
+            &rois->x, n, out_on);
+    return n;
+}
+
+#if LIFI_HAVE_OPENCV
+int32_t lifi_detect_bright_regions(
+        const lifi_frame_desc* frame, uint8_t threshold, int32_t max_regions, int32_t* bbox_out) {
+    if (!bbox_out) return LIFI_ERR_ARGUMENT;
+    const int32_t status = checkFrame(frame);
+    if (status != 0) return status;
+
+    const lifi_frame_desc planes = framePlanes(*frame);
+    return bright_regions(planes.y_plane, planes.y_row_stride, planes.width, planes.height,
+                          threshold, max_regions, bbox_out);
+}
+#endif
+
+int32_t lifi_integral_build(
+        const uint8_t* y_plane,
+        int32_t width,
+        int32_t height,
+        int32_t row_stride,
+        int32_t x,
+        int32_t y,
+        int32_t w,
+        int32_t h,
+        int32_t count_threshold
+) {
+    x = std::max(0, std::min(x, width));
+    y = std::max(0, std::min(y, height));
+    w = std::max(0, std::min(w, width - x));
+    h = std::max(0, std::min(h, height - y));
+
+    const uint8_t* origin = y_plane + y * row_stride + x;
+    frameIntegral.build(origin, row_stride, x, y, w, h);
+    if (count_threshold >= 0) {
+        frameCountIntegral.buildCount(origin, row_stride, x, y, w, h,
+                                      uint8_t(std::min(count_threshold, 255)));
+    } else {
+        frameCountIntegral.build(origin, row_stride, x, y, 0, 0);
+    }
+    return (w > 0 && h > 0) ? 1 : 0;
+}
+
+double lifi_integral_mean(int32_t x, int32_t y, int32_t w, int32_t h) {
+    if (frameIntegral.empty() || !frameIntegral.clip(x, y, w, h)) return 0.0;
+    return double(frameIntegral.sum(x, y, w, h)) / (double(w) * h);
+}
+
+double lifi_integral_fraction_above(int32_t x, int32_t y, int32_t w, int32_t h) {
+    if (frameCountIntegral.empty() || !frameCountIntegral.clip(x, y, w, h)) return 0.0;
+    return double(frameCountIntegral.sum(x, y, w, h)) / (double(w) * h);
+}
+
+void lifi_session_process_frame(
+        lifi_session* session,
         const uint8_t* y_plane,
         int32_t width,
         int32_t height,
@@ -170,249 +294,126 @@ void process_frame(
         int32_t h,
         double* out_values
 ) {
-    // Sum up Y values in the ROI
-    static double minValue = std::numeric_limits<double>::infinity();
-    static double maxValue = -std::numeric_limits<double>::infinity();
-
-    // 1) Decide ROI vs centre patch
-
-    int32_t roiX = x0,    roiY = y0;
-    int32_t roiW = w,     roiH = h;
+    if (!session) session = &defaultSession();
 
+    // 1) Keep the ROI inside the frame
+    clampRoi(width, height, x0, y0, w, h);
 
     // 2) Build 256-bin histogram
-    std::array<int,256> hist = {};
-    int total = 0;
-    for (int r = 0; r < roiH; ++r) {
-        const uint8_t* rowPtr = y_plane + (roiY + r)*row_stride + roiX;
-        for (int c = 0; c < roiW; ++c) {
-            ++hist[rowPtr[c]];
-            ++total;
-        }
-    }
-
-    // 3) Compute mean
-    double sumVal = 0.0;
-    for (int v = 0; v < 256; ++v) {
-        sumVal += double(v) * hist[v];
-    }
-    double mean = sumVal / total;
-
-    // 4) Compute median
-    int cum=0, mid = total/2;
-    double median = 0;
-    for (int v = 0; v < 256; ++v) {
-        cum += hist[v];
-        if (cum >= mid) { median = v; break; }
-    }
+    uint32_t hist[256];
+    lumaHistogram(y_plane + y0 * row_stride + x0, row_stride, w, h, hist);
 
-    // 5) Compute trimmed‐mean (drop 10% low/high)
-    int trim = total / 10;
-    int lowCut=trim, highCut=total-trim;
-    int running=0;
-    double trimSum=0;
-    for (int v=0; v<256; ++v) {
-        int count = hist[v];
-        if (running + count <= lowCut) {
-            running += count;
-            continue;
-        }
-        if (running >= highCut) break;
-        // some or all of this bin
-        int start = std::max(0, lowCut - running);
-        int   end = std::min(count, highCut - running);
-        int used = end - start;
-        trimSum += double(v) * used;
-        running += count;
-    }
-    double trimmed = trimSum / double(highCut - lowCut);
+    // 3-5) Mean, median and trimmed mean (drop 10% low/high) in one scan
+    LumaStats stats = lumaStats(hist);
 
     // 6) Blend for a robust current value
-    double currentValue = (mean + median + trimmed) / 3.0;
+    double currentValue = (stats.mean + stats.median + stats.trimmed) / 3.0;
 
     // 7) Update running min/max
-    if      (currentValue < minValue) minValue = currentValue;
-    else if (currentValue > maxValue) maxValue = currentValue;
+    if (currentValue < session->lumaMin) session->lumaMin = currentValue;
+    if (currentValue > session->lumaMax) session->lumaMax = currentValue;
 
     // 8) Output
     out_values[0] = currentValue;
-    out_values[1] = minValue;
-    out_values[2] = maxValue;
+    out_values[1] = session->lumaMin;
+    out_values[2] = session->lumaMax;
 }
-void debugPrintMatrix(double y) {
-    LOGI("brightness values : yValue = %f", y);
 
-//    for (int r = 0; r < h; ++r) {
-//        std::ostringstream oss;
-//        oss << "Row " << std::setw(2) << r << ": ";
-//
-//        for (int c = 0; c < w; ++c) {
-//            oss << std::setw(3) << static_cast<int>(matrix[r][c]) << " ";
-//        }
-//
-//        LOGI("%s", oss.str().c_str());  // one row per log line
-//    }
-}
-
-
-
-void process_frame_color(
+void process_frame(
         const uint8_t* y_plane,
-        const uint8_t* u_plane,
-        const uint8_t* v_plane,
         int32_t width,
         int32_t height,
-        int32_t Count,
-        int32_t y_row_stride,
-        int32_t uv_row_stride,
-        int32_t uv_pixel_stride,
+        int32_t row_stride,
         int32_t x0,
         int32_t y0,
         int32_t w,
         int32_t h,
-        double* out_values  // [Y, minY, maxY, hue, sat, colorCode, ledOn]
+        double* out_values
 ) {
-    constexpr int WINDOW = 5;
-    static double history[WINDOW];
-    static double ledOnOffHistory[WINDOW] = {1.0,1.0,1.0,1.0,1.0};
-    static int idx = 0;
+    lifi_session_process_frame(&defaultSession(), y_plane, width, height, row_stride,
+                               x0, y0, w, h, out_values);
+}
+
+static void frame_color_histogram(
+        ChromaLayout layout,
+        const uint8_t* y_plane, const uint8_t* u_plane, const uint8_t* v_plane,
+        int32_t y_row_stride, int32_t uv_row_stride, int32_t uv_pixel_stride,
+        int32_t x0, int32_t y0, int32_t w, int32_t h,
+        ScratchArena& scratch, double* out_color_values);
+
+// One ROI of one frame through the whole pipeline: the body of every
+// process_frame_color entry point. The descriptor has passed checkFrame()
+// and is in YUV_420_888 planes.
+static void decode_roi(
+        lifi_session* session,
+        const lifi_frame_desc& frame,
+        lifi_roi roi,
+        lifi_result& out
+) {
+    const uint8_t* y_plane = frame.y_plane;
+    const uint8_t* u_plane = frame.u_plane;
+    const uint8_t* v_plane = frame.v_plane;
+    const int32_t y_row_stride    = frame.y_row_stride;
+    const int32_t uv_row_stride   = frame.uv_row_stride;
+    const int32_t uv_pixel_stride = frame.uv_pixel_stride;
+    const int32_t Count = frame.count;
+    int32_t x0 = roi.x, y0 = roi.y, w = roi.w, h = roi.h;
+
+    constexpr int WINDOW = LIFI_WINDOW;
+    auto& history         = session->history;
+    auto& ledOnOffHistory = session->ledOnOffHistory;
+    auto& idx             = session->idx;
+    auto& full            = session->full;
+    auto& ledOn           = session->ledOn;
+    auto& firstTimeToggle = session->firstTimeToggle;
+    auto& frame_matrix    = session->frameMatrix;
+    auto& frame_index     = session->frameIndex;
+    auto& ambientFilter   = session->ambient;
+    auto& lumaEstimator   = session->luma;
     int encoded = 0;
-    static bool full = false;
-    static bool ledOn = false;
-    const double HYSTFRAC = 0.1;
-    const int pixel_change_threshold = 0;
     double Y = 0.0;
 
-    // Frame buffer history for downsampled matrices
-    static std::vector<std::vector<uint8_t>> frame_matrix[5];
-    static int frame_index = 0;
-    static uint8_t temp_matrix[MAX_H][MAX_W];
-
     if (Count == 0) {
-        // Reset history values
-        for (int i = 0; i < WINDOW; ++i) {
-            history[i] = 0.0;
-            ledOnOffHistory[i] = 1.0;
-
-        }
-        for (int i = 0; i < 5; ++i) {
-            frame_matrix[i].clear();
-
-        }
-
-
-        // Reset other variables
-        idx = 0;
-        full = false;
-        ledOn = false;
-        frame_index = 0;
-        firstTimeToggle = false;
-
-        // Clear temp_matrix
-        for (int i = 0; i < MAX_H; ++i) {
-            for (int j = 0; j < MAX_W; ++j) {
-                temp_matrix[i][j] = 0;
-            }
-        }
+        session->reset();
     }
 
+    // Chroma kernel for this frame's plane geometry: a few pointer compares,
+    // so callers that hand over differently laid out buffers stay correct
+    const ChromaLayout chroma = chromaLayout(u_plane, v_plane, uv_pixel_stride);
 
+    // Keep the ROI inside the frame and inside the buffers sized at configure time
+    clampRoi(frame.width, frame.height, x0, y0, w, h);
+    w = std::min(w, session->maxWidth);
+    h = std::min(h, session->maxHeight);
 
-    // Step 1: Fill temporary full-resolution matrix from ROI
-
-    for (int r = 0; r < h; ++r) {
-        const uint8_t* yp = y_plane + (y0 + r) * y_row_stride + x0;
-        for (int c = 0; c < w; ++c) {
-            temp_matrix[r][c] = yp[c];
-        }
-    }
-
-    for (int r = 1; r < h - 1; ++r) {
-        for (int c = 1; c < w - 1; ++c) {
-            std::vector<uint8_t> kernel = {
-                    temp_matrix[r-1][c-1], temp_matrix[r-1][c], temp_matrix[r-1][c+1],
-                    temp_matrix[r][c-1],   temp_matrix[r][c],   temp_matrix[r][c+1],
-                    temp_matrix[r+1][c-1], temp_matrix[r+1][c], temp_matrix[r+1][c+1]
-            };
-            std::nth_element(kernel.begin(), kernel.begin() + 4, kernel.end());
-            filtered_matrix[r][c] = kernel[4];  // median
-        }
-    }
+    session->scratch.reset();
+    session->latency.begin();
+    StageLap lap(session->timing);
 
-    // Step 2: Downsample and store current matrix
-    frame_matrix[frame_index] = downsampleMatrix10x10(filtered_matrix, h, w);
-    auto& f2 = frame_matrix[(frame_index + 2) % 5];
-    auto& f1 = frame_matrix[(frame_index + 1) % 5];
-    auto& f3 = frame_matrix[(frame_index+3)%5];
-    auto& f4 = frame_matrix[(frame_index + 4) % 5];
-    auto& f5 = frame_matrix[(frame_index ) % 5];
+    // Step 1-2: Median filter and downsample the ROI, streamed in block-row tiles
+    int downH = 0, downW = 0;
+    session->roi.run(y_plane + y0 * y_row_stride + x0, y_row_stride, w, h,
+                     frame_matrix.data(frame_index), downH, downW, &lap);
+    frame_matrix.setShape(frame_index, downH, downW);
+    BlockGridView cur  = frame_matrix.view(frame_index);
+    BlockGridView prev = frame_matrix.view((frame_index + WINDOW - 1) % WINDOW);
 
+    // Step 3: Estimate the LED brightness from the block grid
 
+    // With ambient rejection on, the LED is measured inside the background ring only
+    int r0, c0, r1, c1;
+    bool hasRing = ambientFilter.innerRect(downH, downW, r0, c0, r1, c1);
 
-    // Step 3: Compare frames to detect changed pixels
-    uint64_t sumY = 0;
-    int weightSum = 0;
-    int downH = frame_matrix[frame_index].size();
-    int downW = frame_matrix[frame_index][0].size();
-    weightSum = 0;
-    for (int r = 0; r < downH; ++r) {
-        for (int c = 0; c < downW; ++c) {
-            int v3 = f5[r][c];
-            sumY += v3 ;
-            weightSum = weightSum+1;
+    Y = lumaEstimator.estimate(cur, prev, downH, downW, r0, c0, r1, c1);
 
-        }
+    // Step 3b: Ambient-light and mains-flicker rejection
+    if (hasRing) {
+        Y -= ambientFilter.backgroundMean(cur, downH, downW);
     }
-
-    Y = sumY/weightSum;
-
-//    if (!f1.empty() && !f2.empty() && !f3.empty()) {
-//        threeFramesCaptured = true;
-//        int downH = f3.size();
-//        int downW = f3[0].size();
-//        weightSum = 0;
-//
-//        for (int r = 0; r < downH; ++r) {
-//            for (int c = 0; c < downW; ++c) {
-//                int v1 = f1[r][c];
-//                int v2 = f2[r][c];
-//                int v3 = f3[r][c];
-//
-//                int minV = std::min({v1, v2, v3});
-//                int maxV = std::max({v1, v2, v3});
-//                int diff = maxV - minV;
-//
-//                if (diff > pixel_change_threshold) {
-//                    sumY += v3 * diff;
-//                    weightSum += diff;
-//                }
-//
-//            }
-//        }
-//        Y = (weightSum > 0) ? double(sumY) / weightSum : 0.0;
-//    }else{
-//        threeFramesCaptured = false;
-//        int downH = frame_matrix[frame_index].size();
-//        int downW = frame_matrix[frame_index][0].size();
-//        weightSum = 0;
-//        for (int r = 0; r < downH; ++r) {
-//            for (int c = 0; c < downW; ++c) {
-//                int v3 = f3[r][c];
-//                sumY += v3 ;
-//                weightSum = weightSum+1;
-//
-//            }
-//        }
-//
-//        Y = sumY/weightSum;
-//
-//    }
-
-
+    Y = ambientFilter.filter(Y);
 
     // Step 4: Store in circular buffer for dynamic threshold
     history[idx] = Y;
-    debugPrintMatrix(Y);
     idx = (idx + 1) % WINDOW;
     if (idx == 0) full = true;
 
@@ -441,6 +442,7 @@ void process_frame_color(
 //        ledOn = false;
 //    }
 
+    const bool wasOn = ledOn;
     if (Y >= mid) {
         ledOn = true;
     } else if (Y < mid) {
@@ -477,34 +479,186 @@ void process_frame_color(
     for (int i = 0; i < 5; ++i) {
         encoded |= (ledOnOffHistory[i]== 1.0 ? 1 : 0) << (4 - i);  // MSB to LSB
     }
-    double result = static_cast<double>(encoded);
+    lap.mark(LIFI_STAGE_THRESHOLD);
 
     // Step 6: Estimate HSV color
     double color_hsv[3];
-    detect_frame_color_precise(
+    frame_color_histogram(
+            chroma,
             y_plane, u_plane, v_plane,
-            width, height,
             y_row_stride, uv_row_stride, uv_pixel_stride,
             x0, y0, w, h,
+            session->scratch,
             color_hsv
     );
 
     double hue = color_hsv[0];
     double sat = color_hsv[1];
     double val = color_hsv[2];
-    double colorCode = (double)classify_hsv_color(hue, sat, val);
-
-    frame_index = (frame_index + 1) % 5;
-    frame_count ++;
+    lap.mark(LIFI_STAGE_COLOR_HISTOGRAM);
+    int colorCode = classify_hsv_color(hue, sat, val);
+    lap.mark(LIFI_STAGE_CLASSIFY);
+    lap.commit();
+
+    // Step 6b: Trace the decision (replaces the per-frame logcat line)
+    lifi_trace_record rec;
+    rec.frame   = uint32_t(session->frameCount);
+    rec.session = session->id;
+    rec.t_ns    = traceNow();
+    rec.y       = float(Y);
+    rec.dyn_min = float(dynMin);
+    rec.dyn_max = float(dynMax);
+    rec.led_on  = ledOn ? 1 : 0;
+    rec.encoded = uint8_t(encoded);
+    rec.color   = uint8_t(colorCode);
+    rec.flags   = (Count == 0 ? LIFI_TRACE_RESET : 0) | (hasRing ? LIFI_TRACE_AMBIENT_RING : 0);
+    session->latency.decide(rec);
+    traceRing().push(rec);
+
+    frame_index = (frame_index + 1) % WINDOW;
+    session->frameCount++;
 
     // Step 7: Output results
-    out_values[0] = Y;
-    out_values[1] = dynMin;
-    out_values[2] = dynMax;
-    out_values[3] = hue;
-    out_values[4] = sat;
-    out_values[5] = colorCode;
-    out_values[6] = result;
+    std::memset(&out, 0, sizeof(out));
+    out.version    = LIFI_ABI_VERSION;
+    out.frame      = rec.frame;
+    out.sensor_ns  = rec.sensor_ns;
+    out.y          = Y;
+    out.dyn_min    = dynMin;
+    out.dyn_max    = dynMax;
+    out.hue        = hue;
+    out.sat        = sat;
+    out.val        = val;
+    out.color      = colorCode;
+    out.led_on     = ledOn ? 1 : 0;
+    out.encoded    = encoded;
+    out.flags      = rec.flags;
+    out.latency_us = rec.latency_us;
+
+    auto event = [&out](int32_t type, int32_t value) {
+        if (out.event_count < LIFI_MAX_EVENTS) out.events[out.event_count++] = lifi_event{type, value};
+    };
+    if (Count == 0) event(LIFI_EVENT_RESET, 0);
+    if (rec.flags & LIFI_TRACE_GAP) event(LIFI_EVENT_GAP, session->latency.cadence.lastMissed());
+    if (ledOn != wasOn) event(ledOn ? LIFI_EVENT_LED_ON : LIFI_EVENT_LED_OFF, 0);
+    if (colorCode != session->color) event(LIFI_EVENT_COLOR, colorCode);
+    if (rec.flags & LIFI_TRACE_LATE) event(LIFI_EVENT_LATE, 0);
+    session->color = colorCode;
+
+    // Step 8: Publish for the UI
+    session->shared.publish(out, rec.t_ns, session->latency.cadence.lastMissed());
+}
+
+void lifi_session_process_frame_color(
+        lifi_session* session,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t Count,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        double* out_values  // [Y, minY, maxY, hue, sat, colorCode, encoded]
+) {
+    if (!session) {
+        process_frame_color(y_plane, u_plane, v_plane, width, height, Count,
+                            y_row_stride, uv_row_stride, uv_pixel_stride,
+                            x0, y0, w, h, out_values);
+        return;
+    }
+
+    lifi_frame_desc frame = {};
+    frame.version         = LIFI_ABI_VERSION;
+    frame.format          = LIFI_FORMAT_YUV_420_888;
+    frame.y_plane         = y_plane;
+    frame.u_plane         = u_plane;
+    frame.v_plane         = v_plane;
+    frame.width           = width;
+    frame.height          = height;
+    frame.y_row_stride    = y_row_stride;
+    frame.uv_row_stride   = uv_row_stride;
+    frame.uv_pixel_stride = uv_pixel_stride;
+    frame.count           = Count;
+
+    lifi_result r;
+    decode_roi(session, frame, lifi_roi{x0, y0, w, h}, r);
+
+    out_values[0] = r.y;
+    out_values[1] = r.dyn_min;
+    out_values[2] = r.dyn_max;
+    out_values[3] = r.hue;
+    out_values[4] = r.sat;
+    out_values[5] = r.color;
+    out_values[6] = r.encoded;
+}
+
+int32_t lifi_session_decode(lifi_session* session, const lifi_frame_desc* frame, lifi_result* out) {
+    if (!out) return LIFI_ERR_ARGUMENT;
+    const int32_t status = checkFrame(frame);
+    if (status != 0) return status;
+
+    if (!session) {
+        session = &defaultSession();
+        if (session->maxWidth < frame->width || session->maxHeight < frame->height) {
+            session->configure(frame->width, frame->height);
+        }
+    }
+    if (frame->timestamp_ns != 0) session->latency.stamp(frame->timestamp_ns);
+
+    const lifi_roi roi = frame->roi_count > 0 ? frame->rois[0]
+                                              : lifi_roi{0, 0, frame->width, frame->height};
+    decode_roi(session, framePlanes(*frame), roi, *out);
+    return 1;
+}
+
+void lifi_get_capabilities(lifi_capabilities* out) {
+    if (!out) return;
+    std::memset(out, 0, sizeof(*out));
+    out->abi_version  = LIFI_ABI_VERSION;
+    out->formats      = 1u << LIFI_FORMAT_YUV_420_888 | 1u << LIFI_FORMAT_NV21 |
+                        1u << LIFI_FORMAT_NV12 | 1u << LIFI_FORMAT_I420;
+    out->features     = LIFI_HAVE_OPENCV ? LIFI_FEATURE_OPENCV : 0;
+#ifdef LIFI_STAGE_TIMING
+    out->features    |= LIFI_FEATURE_STAGE_TIMING;
+#endif
+    out->max_events   = LIFI_MAX_EVENTS;
+    out->pool_threads = lifi_pool_threads();
+}
+
+void process_frame_color(
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t Count,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        double* out_values
+) {
+    lifi_session& session = defaultSession();
+    if (session.maxWidth < width || session.maxHeight < height) {
+        session.configure(width, height);
+    }
+    lifi_session_process_frame_color(
+            &session,
+            y_plane, u_plane, v_plane,
+            width, height, Count,
+            y_row_stride, uv_row_stride, uv_pixel_stride,
+            x0, y0, w, h,
+            out_values
+    );
 }
 
 
@@ -583,30 +737,47 @@ void yuvpixel_to_hsv_c(
     *out_val = v;
 }
 
-// --------------------------------------------------------------------------------
-// Precisely detect the dominant color in a YUV₂₁₀ ROI by building a hue histogram.
-//
-// Parameters:
-//   y_plane, u_plane, v_plane    : pointers to the full image's Y, U, V planes.
-//   width, height                : full image dimensions.
-//   y_row_stride                 : number of bytes per row in Y plane.
-//   uv_row_stride                : number of bytes per row in U/V planes.
-//   uv_pixel_stride              : between-column stride in U/V (usually 1 or 2).
-//   x0, y0, w, h                 : top-left corner (x0,y0) and size (w,h) of the ROI.
-//   out_color_values             : length-3 array where we will write [hue, sat, val]:
-//       out_color_values[0] = dominant hue (deg 0..360)
-//       out_color_values[1] = average saturation of all pixels in that hue bin (0..1)
-//       out_color_values[2] = average value   of all pixels in that hue bin (0..1)
-//
-// Usage: Allocate out_color_values[3] before calling. After call, you’ll have the
-//        single “most frequent hue” plus its mean saturation/value in the ROI.
-// --------------------------------------------------------------------------------
-void detect_frame_color_precise(
+} // extern "C"
+
+// One pixel of the ROI as the hue histogram samples it: Y at `yp[c]`,
+// chroma for frame column x0 + c. Returns false for pixels too gray to count.
+template <ChromaLayout L>
+static inline bool roi_pixel_hsv(
+        const uint8_t*     yp,
+        const ChromaRow<L>& chroma,
+        int32_t            x0,
+        int                c,
+        double&            hue,
+        double&            sat,
+        double&            val
+) {
+    // Threshold: ignore pixels with very low saturation (close to gray/no color).
+    const double SAT_THRESHOLD = 0.05;
+
+    // Convert this single pixel to HSV:
+    YUVPixel_to_HSV(yp[c], chroma.U(x0 + c), chroma.V(x0 + c), hue, sat, val);
+    return sat >= SAT_THRESHOLD;
+}
+
+// Number of bins (one per degree). Feel free to reduce (e.g. 180 or 90 bins) if speed is critical.
+static constexpr int HUE_BINS = 360;
+
+// Pixels of a banded histogram that did not count
+static constexpr uint16_t HUE_SKIPPED = 0xFFFF;
+
+// Partial results of one row band of detect_frame_color_precise
+struct HueBand {
+    uint32_t hist[HUE_BINS];
+    uint64_t sumY;
+};
+
+// detect_frame_color_precise for one chroma layout, with the band buffers
+// taken from `scratch`
+template <ChromaLayout L>
+static void color_histogram(
         const uint8_t* y_plane,
         const uint8_t* u_plane,
         const uint8_t* v_plane,
-        int32_t        width,
-        int32_t        height,
         int32_t        y_row_stride,
         int32_t        uv_row_stride,
         int32_t        uv_pixel_stride,
@@ -614,11 +785,9 @@ void detect_frame_color_precise(
         int32_t        y0,
         int32_t        w,
         int32_t        h,
-        double*        out_color_values  // length = 3: [hue, sat, val]
+        ScratchArena&  scratch,
+        double*        out_color_values
 ) {
-    // Number of bins (one per degree). Feel free to reduce (e.g. 180 or 90 bins) if speed is critical.
-    constexpr int HUE_BINS = 360;
-
     // Histogram for counting how many pixels fall into each hue bin.
     // We only count pixels whose saturation is above a small threshold (ignore near-gray).
     uint32_t hue_hist[HUE_BINS];
@@ -631,41 +800,70 @@ void detect_frame_color_precise(
     std::fill_n(sat_accum, HUE_BINS, 0.0);
     std::fill_n(val_accum, HUE_BINS, 0.0);
 
-    // Threshold: ignore pixels with very low saturation (close to gray/no color).
-    const double SAT_THRESHOLD = 0.05;
-
-    // Iterate over every pixel in the ROI:
-    for (int r = 0; r < h; ++r) {
+    auto rowPointers = [&](int r, const uint8_t*& yp, ChromaRow<L>& chroma) {
         // Y pointer at (x0, y0 + r)
-        const uint8_t* yp = y_plane + (y0 + r) * y_row_stride + x0;
+        yp = y_plane + (y0 + r) * y_row_stride + x0;
         // U and V are subsampled by 2 in each dimension (YUV420).
         int uv_row = (y0 + r) >> 1;         // integer division by 2
-        const uint8_t* up = u_plane + uv_row * uv_row_stride + (x0 >> 1) * uv_pixel_stride;
-        const uint8_t* vp = v_plane + uv_row * uv_row_stride + (x0 >> 1) * uv_pixel_stride;
-
-        int uv_col_stride = uv_pixel_stride; // often 1, but could be 2 in certain formats
-
-        for (int c = 0; c < w; ++c) {
-            uint8_t Yval = yp[c];
-            // For U/V, use integer division by 2 on column index:
-            int u_index = (x0 + c) >> 1;
-            int v_index = u_index;
-            uint8_t Uval = *(up + (u_index & ~((uv_pixel_stride>1? (uv_pixel_stride-1):0))));
-            uint8_t Vval = *(vp + (v_index & ~((uv_pixel_stride>1? (uv_pixel_stride-1):0))));
-            // Above bit-trick only matters if uv_pixel_stride>1; otherwise it's just up[u_index], vp[v_index].
-
-            // Convert this single pixel to HSV:
-            double hue, sat, val;
-            yuvpixel_to_hsv_c(Yval, Uval, Vval, &hue, &sat, &val);
-
-            // Skip very low-saturation pixels:
-            if (sat < SAT_THRESHOLD) continue;
-
-            // Bin the hue (0..360) into one of 360 integer bins:
-            int bin = static_cast<int>(std::floor(hue)) % HUE_BINS;
-            ++hue_hist[bin];
-            sat_accum[bin] += sat;
-            val_accum[bin] += val;
+        chroma = ChromaRow<L>{u_plane + uv_row * uv_row_stride,
+                              v_plane + uv_row * uv_row_stride,
+                              uv_pixel_stride};
+    };
+
+    // Large ROIs: row bands build partial counts in parallel and note each
+    // pixel's bin; the sat/val sums of the winning bin are then added up in
+    // the same row-major order as below, so the result is bit-identical.
+    const int bands = w * h >= LIFI_BAND_MIN_PIXELS ? bandCount(h, 16) : 1;
+    const bool banded = bands > 1;
+    uint64_t bandSumY = 0;
+    uint16_t* pixelBins = nullptr;
+
+    if (banded) {
+        pixelBins = scratch.allocArray<uint16_t>(size_t(w) * h);
+        HueBand* partials = scratch.allocArray<HueBand>(size_t(bands));
+        forEachBand(bands, h, [&](int b, int first, int last, ScratchArena&) {
+            HueBand& part = partials[b];
+            std::fill_n(part.hist, HUE_BINS, 0);
+            part.sumY = 0;
+            for (int r = first; r < last; ++r) {
+                const uint8_t* yp;
+                ChromaRow<L> chroma;
+                rowPointers(r, yp, chroma);
+                uint16_t* bins = pixelBins + size_t(r) * w;
+                for (int c = 0; c < w; ++c) {
+                    part.sumY += yp[c];
+                    double hue, sat, val;
+                    if (!roi_pixel_hsv(yp, chroma, x0, c, hue, sat, val)) {
+                        bins[c] = HUE_SKIPPED;
+                        continue;
+                    }
+                    int bin = static_cast<int>(std::floor(hue)) % HUE_BINS;
+                    bins[c] = uint16_t(bin);
+                    ++part.hist[bin];
+                }
+            }
+        });
+        for (int b = 0; b < bands; ++b) {
+            for (int i = 0; i < HUE_BINS; ++i) hue_hist[i] += partials[b].hist[i];
+            bandSumY += partials[b].sumY;
+        }
+    } else {
+        // Iterate over every pixel in the ROI:
+        for (int r = 0; r < h; ++r) {
+            const uint8_t* yp;
+            ChromaRow<L> chroma;
+            rowPointers(r, yp, chroma);
+
+            for (int c = 0; c < w; ++c) {
+                double hue, sat, val;
+                if (!roi_pixel_hsv(yp, chroma, x0, c, hue, sat, val)) continue;
+
+                // Bin the hue (0..360) into one of 360 integer bins:
+                int bin = static_cast<int>(std::floor(hue)) % HUE_BINS;
+                ++hue_hist[bin];
+                sat_accum[bin] += sat;
+                val_accum[bin] += val;
+            }
         }
     }
 
@@ -682,8 +880,8 @@ void detect_frame_color_precise(
     // If we never saw any sufficiently saturated pixel, just return hue=0, sat=0, val=average grayscale:
     if (max_count == 0) {
         // Compute a fallback: average Y over ROI and map to V (value), hue/sat = 0.
-        uint64_t sumY = 0;
-        for (int rr = 0; rr < h; ++rr) {
+        uint64_t sumY = bandSumY;
+        for (int rr = 0; !banded && rr < h; ++rr) {
             const uint8_t* yp_fallback = y_plane + (y0 + rr) * y_row_stride + x0;
             for (int cc = 0; cc < w; ++cc) {
                 sumY += yp_fallback[cc];
@@ -696,6 +894,22 @@ void detect_frame_color_precise(
         return;
     }
 
+    if (banded) {
+        for (int r = 0; r < h; ++r) {
+            const uint8_t* yp;
+            ChromaRow<L> chroma;
+            rowPointers(r, yp, chroma);
+            const uint16_t* bins = pixelBins + size_t(r) * w;
+            for (int c = 0; c < w; ++c) {
+                if (bins[c] != best_bin) continue;
+                double hue, sat, val;
+                roi_pixel_hsv(yp, chroma, x0, c, hue, sat, val);
+                sat_accum[best_bin] += sat;
+                val_accum[best_bin] += val;
+            }
+        }
+    }
+
     // 2) Compute average saturation/value for the winning hue bin:
     double avg_sat = sat_accum[best_bin] / static_cast<double>(max_count);
     double avg_val = val_accum[best_bin] / static_cast<double>(max_count);
@@ -709,6 +923,77 @@ void detect_frame_color_precise(
     out_color_values[2] = avg_val;
 }
 
+using ColorHistogramFn = void (*)(
+        const uint8_t*, const uint8_t*, const uint8_t*, int32_t, int32_t, int32_t,
+        int32_t, int32_t, int32_t, int32_t, ScratchArena&, double*);
+
+static const ColorHistogramFn colorHistogramKernels[CHROMA_LAYOUT_COUNT] = {
+        color_histogram<CHROMA_PLANAR>,
+        color_histogram<CHROMA_NV12>,
+        color_histogram<CHROMA_NV21>,
+        color_histogram<CHROMA_STRIDED>,
+};
+
+extern "C" {
+
+static void frame_color_histogram(
+        ChromaLayout layout,
+        const uint8_t* y_plane, const uint8_t* u_plane, const uint8_t* v_plane,
+        int32_t y_row_stride, int32_t uv_row_stride, int32_t uv_pixel_stride,
+        int32_t x0, int32_t y0, int32_t w, int32_t h,
+        ScratchArena& scratch, double* out_color_values) {
+    colorHistogramKernels[layout](y_plane, u_plane, v_plane,
+                                  y_row_stride, uv_row_stride, uv_pixel_stride,
+                                  x0, y0, w, h, scratch, out_color_values);
+}
+
+// --------------------------------------------------------------------------------
+// Precisely detect the dominant color in a YUV₂₁₀ ROI by building a hue histogram.
+//
+// Parameters:
+//   y_plane, u_plane, v_plane    : pointers to the full image's Y, U, V planes.
+//   width, height                : full image dimensions.
+//   y_row_stride                 : number of bytes per row in Y plane.
+//   uv_row_stride                : number of bytes per row in U/V planes.
+//   uv_pixel_stride              : between-column stride in U/V (usually 1 or 2).
+//   x0, y0, w, h                 : top-left corner (x0,y0) and size (w,h) of the ROI.
+//   out_color_values             : length-3 array where we will write [hue, sat, val]:
+//       out_color_values[0] = dominant hue (deg 0..360)
+//       out_color_values[1] = average saturation of all pixels in that hue bin (0..1)
+//       out_color_values[2] = average value   of all pixels in that hue bin (0..1)
+//
+// Usage: Allocate out_color_values[3] before calling. After call, you’ll have the
+//        single “most frequent hue” plus its mean saturation/value in the ROI.
+// --------------------------------------------------------------------------------
+void detect_frame_color_precise(
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t        width,
+        int32_t        height,
+        int32_t        y_row_stride,
+        int32_t        uv_row_stride,
+        int32_t        uv_pixel_stride,
+        int32_t        x0,
+        int32_t        y0,
+        int32_t        w,
+        int32_t        h,
+        double*        out_color_values  // length = 3: [hue, sat, val]
+) {
+    (void)width;
+    (void)height;
+    static thread_local ScratchArena scratch;
+    scratch.reset();
+    frame_color_histogram(
+            chromaLayout(u_plane, v_plane, uv_pixel_stride),
+            y_plane, u_plane, v_plane,
+            y_row_stride, uv_row_stride, uv_pixel_stride,
+            x0, y0, w, h,
+            scratch,
+            out_color_values
+    );
+}
+
 int classify_hsv_color(double hue, double sat, double val) {
     // 1) If brightness (value) is very low, treat as "black"
     if (val < 0.05) {
@@ -0,0 +1,31 @@
+#include "c_plugin.h"
+#include "lifi_protocol.h"
+#include <algorithm>
+#include <cstring>
+
+// lifi_protocol.h lives with the firmware (esp32Codenew/fully_working); the
+// app reads it through here so both ends decode the same layout.
+
+// ---------------------------------------------------------------------------
+// C API
+
+extern "C" {
+
+void lifi_get_protocol(lifi_protocol* out) {
+    if (!out) return;
+    std::memset(out, 0, sizeof(*out));
+    out->marker_pulses = LIFI_MARKER_PULSES;
+    std::copy(LIFI_MARKER, LIFI_MARKER + LIFI_MARKER_PULSES, out->marker);
+    out->bit_color[0] = LIFI_BIT_COLOR[0];
+    out->bit_color[1] = LIFI_BIT_COLOR[1];
+    out->slots_per_pulse = LIFI_SLOTS_PER_PULSE;
+    out->payload_bits = LIFI_PAYLOAD_BITS;
+    out->gap_slots = LIFI_GAP_SLOTS;
+    out->slots_per_char = LIFI_SLOTS_PER_CHAR;
+    out->payload_slots = LIFI_PAYLOAD_SLOTS;
+    out->default_interval_ms = LIFI_DEFAULT_INTERVAL_MS;
+    out->min_interval_ms = LIFI_MIN_INTERVAL_MS;
+    out->frames_per_slot = LIFI_FRAMES_PER_SLOT;
+}
+
+}
@@ -0,0 +1,73 @@
+#include "result_block.h"
+#include "lifi_session.h"
+#include <cstring>
+
+void ResultBlock::publish(const lifi_result& r, uint64_t tNs, int framesMissed) {
+    if (r.led_on != lastOn) {
+        edgeFrame = r.frame;
+        lastOn = r.led_on;
+    }
+
+    lifi_shared_result s;
+    std::memset(&s, 0, sizeof(s));
+    s.frame         = r.frame;
+    s.edge_frame    = edgeFrame;
+    s.sensor_ns     = r.sensor_ns;
+    s.t_ns          = tNs;
+    s.y             = r.y;
+    s.dyn_min       = r.dyn_min;
+    s.dyn_max       = r.dyn_max;
+    s.hue           = r.hue;
+    s.sat           = r.sat;
+    s.val           = r.val;
+    s.color         = r.color;
+    s.led_on        = r.led_on;
+    s.encoded       = r.encoded;
+    s.flags         = r.flags;
+    s.frames_missed = framesMissed;
+    s.latency_us    = r.latency_us;
+
+    uint64_t w[WORDS];
+    std::memcpy(w, &s, sizeof(w));
+
+    const uint64_t seq = words[0].load(std::memory_order_relaxed);
+    words[0].store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 1; i < WORDS; ++i) words[i].store(w[i], std::memory_order_relaxed);
+    words[0].store(seq + 2, std::memory_order_release);
+}
+
+bool ResultBlock::read(lifi_shared_result& out) const {
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        const uint64_t s1 = words[0].load(std::memory_order_acquire);
+        if (s1 & 1) continue;
+
+        uint64_t w[WORDS];
+        w[0] = s1;
+        for (int i = 1; i < WORDS; ++i) w[i] = words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (words[0].load(std::memory_order_relaxed) != s1) continue;
+
+        std::memcpy(&out, w, sizeof(w));
+        return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// C API
+
+extern "C" {
+
+const lifi_shared_result* lifi_session_shared_result(const lifi_session* session) {
+    if (!session) session = &defaultSession();
+    return session->shared.data();
+}
+
+int32_t lifi_read_shared_result(const lifi_session* session, lifi_shared_result* out) {
+    if (!out) return 0;
+    if (!session) session = &defaultSession();
+    return session->shared.read(*out) ? 1 : 0;
+}
+
+}
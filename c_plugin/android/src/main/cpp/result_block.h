@@ -0,0 +1,43 @@
+#ifndef RESULT_BLOCK_H
+#define RESULT_BLOCK_H
+
+#include "c_plugin.h"
+#include <atomic>
+#include <cstdint>
+
+static_assert(sizeof(lifi_shared_result) % sizeof(uint64_t) == 0, "shared result must be whole words");
+
+// Latest decision of one session in a fixed block that readers look at in
+// place: the UI maps it as a Pointer<lifi_shared_result> and polls its
+// seq at display rate, calling into the library only when it has moved.
+//
+// A seqlock with the decode thread as the only writer: seq goes odd, the
+// payload words are stored, seq goes even again. A reader copies the
+// payload between two reads of seq and keeps the copy if both are the same
+// even value. The writer never waits for readers. The check only holds if
+// the reader orders its loads: acquire on the first seq read and a fence
+// before the second, as read() does. Plain loads (Dart FFI) may be
+// reordered on ARM64 and pass the check with a mix of two publishes, so
+// such readers only peek at seq and take the copy through read().
+class ResultBlock {
+public:
+    // Decode thread, once per frame
+    void publish(const lifi_result& r, uint64_t tNs, int framesMissed);
+
+    // Consistent copy for C callers; false if a write kept getting in the way
+    bool read(lifi_shared_result& out) const;
+
+    const lifi_shared_result* data() const {
+        return reinterpret_cast<const lifi_shared_result*>(words);
+    }
+
+private:
+    static constexpr int WORDS = sizeof(lifi_shared_result) / sizeof(uint64_t);
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "atomic words must overlay the struct");
+
+    alignas(64) std::atomic<uint64_t> words[WORDS] = {};    // words[0] is seq
+    uint32_t edgeFrame = 0;
+    int32_t  lastOn = -1;
+};
+
+#endif // RESULT_BLOCK_H
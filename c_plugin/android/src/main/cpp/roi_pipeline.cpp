@@ -0,0 +1,200 @@
+#include "roi_pipeline.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ROI_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ROI_SSE2 1
+#endif
+
+namespace {
+
+// Compare-exchange for the median network, for scalars and 16-byte vectors
+inline void sortPair(uint8_t& a, uint8_t& b) {
+    uint8_t lo = std::min(a, b);
+    b = std::max(a, b);
+    a = lo;
+}
+#if ROI_NEON
+inline void sortPair(uint8x16_t& a, uint8x16_t& b) {
+    uint8x16_t lo = vminq_u8(a, b);
+    b = vmaxq_u8(a, b);
+    a = lo;
+}
+#elif ROI_SSE2
+inline void sortPair(__m128i& a, __m128i& b) {
+    __m128i lo = _mm_min_epu8(a, b);
+    b = _mm_max_epu8(a, b);
+    a = lo;
+}
+#endif
+
+// 19-exchange median-of-9 network (Paeth); p[4] ends up as the median.
+template <typename T>
+inline T median9(T p[9]) {
+    sortPair(p[1], p[2]); sortPair(p[4], p[5]); sortPair(p[7], p[8]);
+    sortPair(p[0], p[1]); sortPair(p[3], p[4]); sortPair(p[6], p[7]);
+    sortPair(p[1], p[2]); sortPair(p[4], p[5]); sortPair(p[7], p[8]);
+    sortPair(p[0], p[3]); sortPair(p[5], p[8]); sortPair(p[4], p[7]);
+    sortPair(p[3], p[6]); sortPair(p[1], p[4]); sortPair(p[2], p[5]);
+    sortPair(p[4], p[7]); sortPair(p[4], p[2]); sortPair(p[6], p[4]);
+    sortPair(p[4], p[2]);
+    return p[4];
+}
+
+} // namespace
+
+void RoiPipeline::configure(int maxWidth, int blockSize) {
+    maxW = std::max(1, maxWidth);
+    bs   = std::min(std::max(1, blockSize), ROI_MAX_BLOCK_SIZE);
+    input.assign(size_t(bs + 2) * maxW, 0);
+    filtered.assign(size_t(bs) * maxW, 0);
+    colSum.assign(maxW + 16, 0);
+}
+
+void RoiPipeline::copyTile(Tile& tile, const uint8_t* roi, int stride, int r0, int h, int cw) const {
+    for (int t = 0; t < bs + 2; ++t) {
+        int r = std::min(std::max(r0 - 1 + t, 0), h - 1);
+        std::memcpy(tile.input + size_t(t) * maxW, roi + size_t(r) * stride, cw);
+    }
+}
+
+void RoiPipeline::medianTile(Tile& tile, int r0, int h, int w, int cols) const {
+    // Interior columns get the median, the ROI's last column passes through
+    const int lastCol = std::min(cols, w - 1);
+
+    for (int t = 0; t < bs; ++t) {
+        const int r = r0 + t;
+        const uint8_t* above = tile.input + size_t(t) * maxW;
+        const uint8_t* mid   = above + maxW;
+        const uint8_t* below = mid + maxW;
+        uint8_t* out = tile.filtered + size_t(t) * maxW;
+
+        if (r == 0 || r == h - 1) {
+            std::memcpy(out, mid, cols);
+            continue;
+        }
+
+        out[0] = mid[0];
+        int c = 1;
+#if ROI_NEON
+        for (; c + 16 <= lastCol; c += 16) {
+            uint8x16_t p[9] = {
+                vld1q_u8(above + c - 1), vld1q_u8(above + c), vld1q_u8(above + c + 1),
+                vld1q_u8(mid   + c - 1), vld1q_u8(mid   + c), vld1q_u8(mid   + c + 1),
+                vld1q_u8(below + c - 1), vld1q_u8(below + c), vld1q_u8(below + c + 1),
+            };
+            vst1q_u8(out + c, median9(p));
+        }
+#elif ROI_SSE2
+        for (; c + 16 <= lastCol; c += 16) {
+            auto ld = [](const uint8_t* q) {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+            };
+            __m128i p[9] = {
+                ld(above + c - 1), ld(above + c), ld(above + c + 1),
+                ld(mid   + c - 1), ld(mid   + c), ld(mid   + c + 1),
+                ld(below + c - 1), ld(below + c), ld(below + c + 1),
+            };
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + c), median9(p));
+        }
+#endif
+        for (; c < lastCol; ++c) {
+            uint8_t p[9] = {
+                above[c-1], above[c], above[c+1],
+                mid[c-1],   mid[c],   mid[c+1],
+                below[c-1], below[c], below[c+1],
+            };
+            out[c] = median9(p);
+        }
+        for (; c < cols; ++c) out[c] = mid[c];
+    }
+}
+
+void RoiPipeline::downsampleTile(Tile& tile, uint8_t* out, int blocksW) const {
+    const int cols = blocksW * bs;
+    uint16_t* acc = tile.colSum;
+    std::fill_n(acc, cols, uint16_t(0));
+
+    // Vertical pass: widen and add each tile row into 16-bit column sums
+    for (int t = 0; t < bs; ++t) {
+        const uint8_t* row = tile.filtered + size_t(t) * maxW;
+        int c = 0;
+#if ROI_NEON
+        for (; c + 16 <= cols; c += 16) {
+            uint8x16_t v = vld1q_u8(row + c);
+            vst1q_u16(acc + c,     vaddw_u8(vld1q_u16(acc + c),     vget_low_u8(v)));
+            vst1q_u16(acc + c + 8, vaddw_u8(vld1q_u16(acc + c + 8), vget_high_u8(v)));
+        }
+#elif ROI_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; c + 16 <= cols; c += 16) {
+            __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + c));
+            __m128i* a0 = reinterpret_cast<__m128i*>(acc + c);
+            __m128i* a1 = reinterpret_cast<__m128i*>(acc + c + 8);
+            _mm_storeu_si128(a0, _mm_add_epi16(_mm_loadu_si128(a0), _mm_unpacklo_epi8(v, zero)));
+            _mm_storeu_si128(a1, _mm_add_epi16(_mm_loadu_si128(a1), _mm_unpackhi_epi8(v, zero)));
+        }
+#endif
+        for (; c < cols; ++c) acc[c] += row[c];
+    }
+
+    // Horizontal pass: bs column sums per block
+    const int n = bs * bs;
+    for (int b = 0; b < blocksW; ++b) {
+        const uint16_t* s = acc + b * bs;
+        uint32_t sum = 0;
+        for (int j = 0; j < bs; ++j) sum += s[j];
+        out[b] = static_cast<uint8_t>(sum / n);
+    }
+}
+
+bool RoiPipeline::run(const uint8_t* roi, int stride, int w, int h,
+                      uint8_t* grid, int& rows, int& cols, StageLap* lap) {
+    rows = cols = 0;
+    if (w > maxW) return false;
+
+    const int blocksH = h / bs;
+    const int blocksW = w / bs;
+    rows = blocksH;
+    cols = blocksW;
+    if (blocksH == 0 || blocksW == 0) return true;
+
+    // The median of the last used column looks one pixel to the right
+    const int used = blocksW * bs;
+    const int cw   = std::min(w, used + 1);
+
+    const int bands = w * h >= LIFI_BAND_MIN_PIXELS ? bandCount(blocksH, 1) : 1;
+    if (bands > 1) {
+        forEachBand(bands, blocksH, [&](int, int first, int last, ScratchArena& scratch) {
+            Tile tile;
+            tile.input    = static_cast<uint8_t*>(scratch.alloc(input.size()));
+            tile.filtered = static_cast<uint8_t*>(scratch.alloc(filtered.size()));
+            tile.colSum   = static_cast<uint16_t*>(scratch.alloc(colSum.size() * sizeof(uint16_t)));
+            for (int br = first; br < last; ++br) {
+                const int r0 = br * bs;
+                copyTile(tile, roi, stride, r0, h, cw);
+                medianTile(tile, r0, h, w, used);
+                downsampleTile(tile, grid + size_t(br) * blocksW, blocksW);
+            }
+        });
+        if (lap) lap->mark(LIFI_STAGE_MEDIAN);
+        return true;
+    }
+
+    Tile tile{input.data(), filtered.data(), colSum.data()};
+    for (int br = 0; br < blocksH; ++br) {
+        const int r0 = br * bs;
+        copyTile(tile, roi, stride, r0, h, cw);
+        if (lap) lap->mark(LIFI_STAGE_ROI_COPY);
+        medianTile(tile, r0, h, w, used);
+        if (lap) lap->mark(LIFI_STAGE_MEDIAN);
+        downsampleTile(tile, grid + size_t(br) * blocksW, blocksW);
+        if (lap) lap->mark(LIFI_STAGE_DOWNSAMPLE);
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef ROI_PIPELINE_H
+#define ROI_PIPELINE_H
+
+#include "stage_timing.h"
+#include <cstdint>
+#include <vector>
+
+// Largest supported block size; keeps per-column sums inside 16 bits.
+constexpr int ROI_MAX_BLOCK_SIZE = 64;
+
+// Median + block-downsample front end of process_frame_color.
+//
+// The ROI is streamed in tiles of one block row (blockSize rows) plus one
+// halo row above and below for the 3x3 median, so memory depends only on
+// the configured maximum width, not on the ROI height. All buffers are
+// allocated by configure(); run() never allocates.
+//
+// ROIs of LIFI_BAND_MIN_PIXELS and up are split into bands of block rows
+// that run on the shared worker pool, each with its own tile buffers from
+// the worker's scratch arena. Every block row is still computed from the
+// same tile, halo rows included, so the grid is identical to the serial one.
+class RoiPipeline {
+public:
+    void configure(int maxWidth, int blockSize);
+    int  maxWidth() const { return maxW; }
+    int  blockSize() const { return bs; }
+
+    // Processes the w x h ROI at `roi` (row stride `stride`) into `grid`,
+    // a rows x cols row-major array with one entry per full block.
+    // Rows/columns past the last full block are ignored, as before.
+    // Returns false if the ROI is wider than configured. With `lap`, the
+    // copy, median and downsample steps are charged to their stages; when
+    // split into bands they overlap, and all of it goes to the median.
+    bool run(const uint8_t* roi, int stride, int w, int h,
+             uint8_t* grid, int& rows, int& cols, StageLap* lap = nullptr);
+
+private:
+    // Working buffers for one block row, laid out like the members below
+    struct Tile {
+        uint8_t*  input;
+        uint8_t*  filtered;
+        uint16_t* colSum;
+    };
+
+    // Copies tile rows [r0 - 1, r0 + bs] (clamped to the ROI) into `input`.
+    void copyTile(Tile& t, const uint8_t* roi, int stride, int r0, int h, int cw) const;
+    // 3x3 median of the first `cols` columns of the tile rows into
+    // `filtered`; ROI border pixels pass through unfiltered.
+    void medianTile(Tile& t, int r0, int h, int w, int cols) const;
+    // Block sums of the filtered tile into one grid row.
+    void downsampleTile(Tile& t, uint8_t* out, int blocksW) const;
+
+    int maxW = 0;
+    int bs = 10;
+    std::vector<uint8_t>  input;     // (bs + 2) rows x maxW
+    std::vector<uint8_t>  filtered;  // bs rows x maxW
+    std::vector<uint16_t> colSum;    // maxW per-column sums of the filtered tile
+};
+
+#endif // ROI_PIPELINE_H
@@ -0,0 +1,43 @@
+#include "scratch_arena.h"
+#include <algorithm>
+
+void* ScratchArena::alloc(size_t bytes, size_t align) {
+    if (align == 0 || (align & (align - 1))) align = 64;
+    if (!blocks.empty()) {
+        Block& b = blocks.back();
+        const uintptr_t p = reinterpret_cast<uintptr_t>(b.data.get()) + offset;
+        const size_t pad = size_t(-p & (align - 1));
+        if (offset + pad + bytes <= b.size) {
+            offset += pad + bytes;
+            usedBytes += bytes;
+            return b.data.get() + offset - bytes;
+        }
+    }
+
+    // New block, at least double the last so a growing frame settles quickly
+    const size_t last = blocks.empty() ? 0 : blocks.back().size;
+    const size_t size = std::max({bytes + align, 2 * last, size_t(64 * 1024)});
+    blocks.push_back(Block{std::unique_ptr<uint8_t[]>(new uint8_t[size]), size});
+    const uintptr_t p = reinterpret_cast<uintptr_t>(blocks.back().data.get());
+    const size_t pad = size_t(-p & (align - 1));
+    offset = pad + bytes;
+    usedBytes += bytes;
+    return blocks.back().data.get() + pad;
+}
+
+void ScratchArena::reset() {
+    // Fold overflow blocks into one so the next round fits in a single block
+    if (blocks.size() > 1) {
+        const size_t total = capacity();
+        blocks.clear();
+        blocks.push_back(Block{std::unique_ptr<uint8_t[]>(new uint8_t[total]), total});
+    }
+    offset = 0;
+    usedBytes = 0;
+}
+
+size_t ScratchArena::capacity() const {
+    size_t total = 0;
+    for (const Block& b : blocks) total += b.size;
+    return total;
+}
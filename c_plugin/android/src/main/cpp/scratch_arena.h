@@ -0,0 +1,39 @@
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator for per-frame and per-task temporaries.
+//
+// alloc() hands out memory until reset(), which keeps it for the next
+// round. When a round overflowed into extra blocks, reset() folds them into
+// one block of the combined size, so after a warm-up frame or two a
+// workload that needs the same amount every frame allocates nothing.
+// Memory is not cleared and no destructors run: plain data only.
+class ScratchArena {
+public:
+    void* alloc(size_t bytes, size_t align = 64);
+    void reset();
+
+    template <typename T>
+    T* allocArray(size_t n) {
+        return static_cast<T*>(alloc(n * sizeof(T), alignof(T) > 64 ? alignof(T) : 64));
+    }
+
+    size_t used() const { return usedBytes; }
+    size_t capacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+    };
+    std::vector<Block> blocks;
+    size_t offset = 0;          // in blocks.back()
+    size_t usedBytes = 0;
+};
+
+#endif // SCRATCH_ARENA_H
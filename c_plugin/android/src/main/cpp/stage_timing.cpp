@@ -0,0 +1,69 @@
+#include "stage_timing.h"
+#include <algorithm>
+#include <cstring>
+
+int LatencyStat::bucketOf(uint64_t ns) {
+    if (ns < 4) return int(ns);
+    int octave = 63 - __builtin_clzll(ns);
+    int sub    = int(ns >> (octave - 2)) & 3;
+    return std::min((octave - 1) * 4 + sub, BUCKETS - 1);
+}
+
+uint64_t LatencyStat::bucketMid(int bucket) {
+    if (bucket < 4) return uint64_t(bucket);
+    int octave = bucket / 4 + 1;
+    uint64_t width = 1ull << (octave - 2);
+    uint64_t lower = uint64_t(4 + bucket % 4) << (octave - 2);
+    return lower + width / 2;
+}
+
+uint64_t LatencyStat::percentile(double p) const {
+    if (count == 0) return 0;
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(p * double(count) + 0.5));
+    uint64_t cum = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        cum += buckets[b];
+        if (cum >= rank) return std::min(std::max(bucketMid(b), min), max);
+    }
+    return max;
+}
+
+void LatencyStat::add(uint64_t ns) {
+    if (count == 0 || ns < min) min = ns;
+    if (ns > max) max = ns;
+    total += ns;
+    ++count;
+    ++buckets[bucketOf(ns)];
+}
+
+void LatencyStat::snapshot(lifi_stage_stat& out) const {
+    out.count    = count;
+    out.total_ns = total;
+    out.min_ns   = min;
+    out.max_ns   = max;
+    out.p50_ns   = percentile(0.50);
+    out.p99_ns   = percentile(0.99);
+}
+
+void StageTiming::commit() {
+    for (int i = 0; i < LIFI_STAGE_COUNT; ++i) {
+        if (!(touched & (1u << i))) continue;
+        stats[i].add(frameNs[i]);
+        frameNs[i] = 0;
+    }
+    touched = 0;
+}
+
+void StageTiming::reset() {
+    for (LatencyStat& s : stats) s.reset();
+    std::memset(frameNs, 0, sizeof(frameNs));
+    touched = 0;
+}
+
+void StageTiming::snapshot(lifi_stage_stats& out) const {
+    std::memset(&out, 0, sizeof(out));
+#ifdef LIFI_STAGE_TIMING
+    out.enabled = 1;
+#endif
+    for (int i = 0; i < LIFI_STAGE_COUNT; ++i) stats[i].snapshot(out.stages[i]);
+}
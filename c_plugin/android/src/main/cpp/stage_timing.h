@@ -0,0 +1,94 @@
+#ifndef STAGE_TIMING_H
+#define STAGE_TIMING_H
+
+#include "c_plugin.h"
+#include <cstdint>
+#ifdef LIFI_STAGE_TIMING
+#include <time.h>
+#endif
+
+// Latency distribution of one measurement point: count/total/min/max plus
+// a log-bucket histogram with four buckets per power of two for the
+// percentiles.
+class LatencyStat {
+public:
+    static constexpr int BUCKETS = 128;   // 4 per octave, up to ~8.6 s
+
+    void add(uint64_t ns);
+    void reset() { *this = LatencyStat(); }
+    uint64_t samples() const { return count; }
+
+    // count, total, min, max, p50, p99
+    void snapshot(lifi_stage_stat& out) const;
+
+private:
+    static int bucketOf(uint64_t ns);
+    static uint64_t bucketMid(int bucket);
+    uint64_t percentile(double p) const;
+
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t min   = 0;
+    uint64_t max   = 0;
+    uint32_t buckets[BUCKETS] = {};
+};
+
+// Per-stage latency counters for process_frame_color.
+//
+// Only compiled in with -DLIFI_STAGE_TIMING; otherwise StageLap is empty and
+// every call below folds away. Each stage gets one sample per frame (tiles
+// are summed first).
+class StageTiming {
+public:
+    // Adds `ns` to `stage` for the frame in progress.
+    void add(int stage, uint64_t ns) {
+        frameNs[stage] += ns;
+        touched |= 1u << stage;
+    }
+
+    // Records the frame in progress: one sample per stage that ran.
+    void commit();
+
+    void reset();
+
+    // Fills `out` (count, total, min, max, p50, p99 per stage).
+    void snapshot(lifi_stage_stats& out) const;
+
+private:
+    LatencyStat stats[LIFI_STAGE_COUNT];
+    uint64_t frameNs[LIFI_STAGE_COUNT] = {};
+    uint32_t touched = 0;
+};
+
+// Lap timer over one frame: mark(stage) charges the time since the previous
+// mark to `stage`, commit() closes the frame.
+class StageLap {
+public:
+#ifdef LIFI_STAGE_TIMING
+    explicit StageLap(StageTiming& t) : timing(t), last(now()) {}
+
+    void mark(int stage) {
+        uint64_t t = now();
+        timing.add(stage, t - last);
+        last = t;
+    }
+
+    void commit() { timing.commit(); }
+
+private:
+    static uint64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+    }
+
+    StageTiming& timing;
+    uint64_t last;
+#else
+    explicit StageLap(StageTiming&) {}
+    void mark(int) {}
+    void commit() {}
+#endif
+};
+
+#endif // STAGE_TIMING_H
@@ -0,0 +1,101 @@
+#include "trace_ring.h"
+#include <cstdio>
+#include <cstring>
+
+void TraceRing::push(const lifi_trace_record& rec) {
+    if (!enabled.load(std::memory_order_relaxed)) return;
+
+    const uint64_t pos = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[pos & (CAPACITY - 1)];
+
+    uint64_t w[WORDS];
+    std::memcpy(w, &rec, sizeof(w));
+
+    slot.seq.store(2 * pos + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < WORDS; ++i) slot.words[i].store(w[i], std::memory_order_relaxed);
+    slot.seq.store(2 * pos + 2, std::memory_order_release);
+}
+
+int TraceRing::drain(lifi_trace_record* out, int max) {
+    std::lock_guard<std::mutex> guard(drainLock);
+
+    const uint64_t h = head.load(std::memory_order_acquire);
+    if (h - tail > CAPACITY) {
+        lost.fetch_add(h - tail - CAPACITY, std::memory_order_relaxed);
+        tail = h - CAPACITY;
+    }
+
+    int n = 0;
+    while (n < max && tail < h) {
+        Slot& slot = slots[tail & (CAPACITY - 1)];
+        const uint64_t want = 2 * tail + 2;
+
+        uint64_t s1 = slot.seq.load(std::memory_order_acquire);
+        if (s1 < want) break;                  // writer still busy; next drain
+        if (s1 > want) {                       // already overwritten
+            lost.fetch_add(1, std::memory_order_relaxed);
+            ++tail;
+            continue;
+        }
+
+        uint64_t w[WORDS];
+        for (int i = 0; i < WORDS; ++i) w[i] = slot.words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != s1) {
+            lost.fetch_add(1, std::memory_order_relaxed);
+            ++tail;
+            continue;
+        }
+
+        std::memcpy(&out[n++], w, sizeof(w));
+        ++tail;
+    }
+    return n;
+}
+
+TraceRing& traceRing() {
+    static TraceRing ring;
+    return ring;
+}
+
+extern "C" {
+
+void lifi_trace_enable(int32_t on) {
+    traceRing().setEnabled(on != 0);
+}
+
+int32_t lifi_trace_drain(lifi_trace_record* out, int32_t max_records) {
+    if (!out || max_records <= 0) return 0;
+    return traceRing().drain(out, max_records);
+}
+
+uint64_t lifi_trace_dropped(void) {
+    return traceRing().dropped();
+}
+
+int32_t lifi_trace_dump(const char* path) {
+    if (!path) return -1;
+    FILE* f = std::fopen(path, "wb");
+    if (!f) return -1;
+
+    TraceFileHeader header = {{'L', 'T', 'R', 'C'}, TRACE_FILE_VERSION,
+                              uint32_t(sizeof(lifi_trace_record)), 0};
+    std::fwrite(&header, sizeof(header), 1, f);
+
+    lifi_trace_record chunk[256];
+    int n;
+    do {    // stop once caught up, even if frames keep arriving
+        n = traceRing().drain(chunk, 256);
+        std::fwrite(chunk, sizeof(lifi_trace_record), size_t(n), f);
+        header.count += uint32_t(n);
+    } while (n == 256);
+
+    std::fseek(f, 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, f);
+    const bool ok = std::ferror(f) == 0;
+    std::fclose(f);
+    return ok ? int32_t(header.count) : -1;
+}
+
+}
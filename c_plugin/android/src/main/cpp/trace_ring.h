@@ -0,0 +1,71 @@
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include "c_plugin.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <time.h>
+
+// Header of a lifi_trace_dump() file, followed by `count` records.
+struct TraceFileHeader {
+    char     magic[4];      // "LTRC"
+    uint32_t version;
+    uint32_t recordSize;    // sizeof(lifi_trace_record)
+    uint32_t count;
+};
+
+constexpr uint32_t TRACE_FILE_VERSION = 2;   // 2: 48-byte records with latencies
+
+static_assert(sizeof(lifi_trace_record) == 48, "trace record layout changed");
+
+// Fixed-size binary trace of per-frame decisions, replacing logcat in the
+// frame loop.
+//
+// push() is lock-free and never blocks: it claims a slot with one
+// fetch_add and overwrites the oldest record once the ring is full. Each
+// slot carries a sequence number (odd while being written), so drain() can
+// tell complete records from torn or overwritten ones and count the losses.
+// drain() is meant for a background thread and takes a mutex.
+class TraceRing {
+public:
+    static constexpr uint32_t CAPACITY = 4096;   // records, power of two
+
+    void push(const lifi_trace_record& rec);
+
+    // Copies up to `max` records, oldest first. Returns the count.
+    int drain(lifi_trace_record* out, int max);
+
+    // Records overwritten before they could be drained.
+    uint64_t dropped() const { return lost.load(std::memory_order_relaxed); }
+
+    void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int WORDS = sizeof(lifi_trace_record) / sizeof(uint64_t);
+
+    struct Slot {
+        std::atomic<uint64_t> seq{0};    // 2*pos+1 writing, 2*pos+2 done
+        std::atomic<uint64_t> words[WORDS];
+    };
+
+    Slot slots[CAPACITY];
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> lost{0};
+    std::atomic<bool> enabled{true};
+
+    std::mutex drainLock;
+    uint64_t tail = 0;
+};
+
+// Process-wide trace shared by all sessions.
+TraceRing& traceRing();
+
+inline uint64_t traceNow() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+}
+
+#endif // TRACE_RING_H
@@ -0,0 +1,288 @@
+#include "worker_pool.h"
+#include "c_plugin.h"
+#include "lifi_session.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// WorkerPool
+
+namespace {
+thread_local bool insidePool = false;
+}
+
+bool WorkerPool::inTask() {
+    return insidePool;
+}
+
+std::vector<int> WorkerPool::bigCores() {
+    const int n = std::max(1, int(std::thread::hardware_concurrency()));
+    std::vector<int> all(static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) all[size_t(i)] = i;
+
+    std::vector<long> freq(size_t(n), 0);
+    for (int i = 0; i < n; ++i) {
+        char path[96];
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", i);
+        FILE* f = std::fopen(path, "r");
+        if (!f) return all;
+        if (std::fscanf(f, "%ld", &freq[size_t(i)]) != 1) freq[size_t(i)] = 0;
+        std::fclose(f);
+        if (freq[size_t(i)] <= 0) return all;
+    }
+
+    const long slowest = *std::min_element(freq.begin(), freq.end());
+    std::vector<int> big;
+    for (int i = 0; i < n; ++i) {
+        if (freq[size_t(i)] > slowest) big.push_back(i);
+    }
+    return big.empty() ? all : big;
+}
+
+WorkerPool::WorkerPool(int threads) {
+    const std::vector<int> big = bigCores();
+    if (threads <= 0) threads = int(big.size());
+
+    // Keep the workers off the little cores when they all fit on big ones
+    std::vector<int> pin;
+    if (threads <= int(big.size()) && big.size() < std::thread::hardware_concurrency()) pin = big;
+
+    arenas.resize(size_t(threads));
+    for (int w = 1; w < threads; ++w) {
+        workers.emplace_back(&WorkerPool::workerLoop, this, w, pin);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) t.join();
+}
+
+void WorkerPool::drain(int worker) {
+    for (int t = nextTask.fetch_add(1, std::memory_order_relaxed); t < jobTasks;
+         t = nextTask.fetch_add(1, std::memory_order_relaxed)) {
+        (*job)(t, worker);
+    }
+}
+
+void WorkerPool::workerLoop(int worker, std::vector<int> cpus) {
+#if defined(__linux__)
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cpus) CPU_SET(c, &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+#else
+    (void)cpus;
+#endif
+
+    insidePool = true;
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        wake.wait(guard, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+
+        guard.unlock();
+        drain(worker);
+        guard.lock();
+        if (--pending == 0) finished.notify_one();
+    }
+}
+
+void WorkerPool::run(int tasks, FunctionRef<void(int, int)> fn) {
+    if (tasks <= 0) return;
+    std::lock_guard<std::mutex> batch(runLock);
+    for (PaddedArena& a : arenas) a.arena.reset();
+
+    const bool outer = insidePool;
+    insidePool = true;
+
+    // Nothing to fan out: skip the wake-up round trip
+    if (tasks == 1 || workers.empty()) {
+        for (int t = 0; t < tasks; ++t) fn(t, 0);
+        insidePool = outer;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job = &fn;
+        jobTasks = tasks;
+        nextTask.store(0, std::memory_order_relaxed);
+        pending = int(workers.size());
+        ++generation;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [&] { return pending == 0; });
+    job = nullptr;
+    insidePool = outer;
+}
+
+// ---------------------------------------------------------------------------
+// C API
+
+namespace {
+
+std::mutex poolLock;
+std::unique_ptr<WorkerPool> pool;
+
+WorkerPool& sharedPool() {
+    if (!pool) pool.reset(new WorkerPool());
+    return *pool;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Row bands
+
+int bandCount(int rows, int minRows) {
+    if (WorkerPool::inTask() || rows <= 0) return 1;
+    // A batch holding the pool would leave the bands to run here anyway:
+    // do not wait for it to finish
+    int threads;
+    {
+        std::unique_lock<std::mutex> guard(poolLock, std::try_to_lock);
+        if (!guard.owns_lock()) return 1;
+        threads = sharedPool().size();
+    }
+    return std::max(1, std::min(threads, rows / std::max(1, minRows)));
+}
+
+void forEachBand(int bands, int rows,
+                 FunctionRef<void(int, int, int, ScratchArena&)> fn) {
+    bands = std::max(1, std::min(bands, rows));
+    auto bounds = [&](int b, int& first, int& last) {
+        first = int(int64_t(rows) * b / bands);
+        last  = int(int64_t(rows) * (b + 1) / bands);
+    };
+
+    // Already on the pool, or someone else has it: do the bands here
+    std::unique_lock<std::mutex> guard(poolLock, std::defer_lock);
+    if (bands == 1 || WorkerPool::inTask() || !guard.try_lock()) {
+        static thread_local ScratchArena local;
+        for (int b = 0; b < bands; ++b) {
+            int first, last;
+            bounds(b, first, last);
+            local.reset();
+            fn(b, first, last, local);
+        }
+        return;
+    }
+
+    WorkerPool& p = sharedPool();
+    p.run(bands, [&](int b, int worker) {
+        int first, last;
+        bounds(b, first, last);
+        fn(b, first, last, p.scratch(worker));
+    });
+}
+
+extern "C" {
+
+int32_t lifi_pool_set_threads(int32_t threads) {
+    std::lock_guard<std::mutex> guard(poolLock);
+    pool.reset();
+    pool.reset(new WorkerPool(threads));
+    return pool->size();
+}
+
+int32_t lifi_pool_threads(void) {
+    std::lock_guard<std::mutex> guard(poolLock);
+    return sharedPool().size();
+}
+
+int32_t lifi_process_frame_color_multi(
+        lifi_session* const* sessions,
+        int32_t n,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t count,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        const int32_t* rois,
+        double* out_values
+) {
+    if (!sessions || n <= 0 || !rois || !out_values) return LIFI_ERR_ARGUMENT;
+
+    // NULL is the default session, as everywhere else; only one ROI can
+    // have it
+    int defaults = 0;
+    for (int i = 0; i < n; ++i) defaults += !sessions[i];
+    if (defaults > 1) return LIFI_ERR_ARGUMENT;
+
+    auto process = [&](int i) {
+        const int32_t* roi = rois + 4 * i;
+        lifi_session_process_frame_color(
+                sessions[i], y_plane, u_plane, v_plane,
+                width, height, count,
+                y_row_stride, uv_row_stride, uv_pixel_stride,
+                roi[0], roi[1], roi[2], roi[3],
+                out_values + 7 * i);
+    };
+
+    // A single ROI keeps the pool free for its own row bands
+    if (n == 1) {
+        process(0);
+        return 1;
+    }
+
+    std::lock_guard<std::mutex> guard(poolLock);
+    sharedPool().run(n, [&](int i, int) { process(i); });
+    return n;
+}
+
+int32_t lifi_decode(lifi_session* const* sessions, const lifi_frame_desc* frame, lifi_result* results) {
+    if (!sessions || !results) return LIFI_ERR_ARGUMENT;
+    const int32_t status = checkFrame(frame);
+    if (status != 0) return status;
+    const int n = std::max(1, frame->roi_count);
+
+    // NULL is the default session, like in lifi_session_decode; it can only
+    // take one ROI of the batch
+    int defaults = 0;
+    for (int i = 0; i < n; ++i) defaults += !sessions[i];
+    if (defaults > 1) return LIFI_ERR_ARGUMENT;
+
+    // ROI i as a one-ROI frame for lifi_session_decode
+    auto decode = [&](int i) {
+        lifi_frame_desc one = *frame;
+        if (frame->roi_count > 0) {
+            one.rois = frame->rois + i;
+            one.roi_count = 1;
+        }
+        lifi_session_decode(sessions[i], &one, &results[i]);
+    };
+
+    // A single ROI keeps the pool free for its own row bands
+    if (n == 1) {
+        decode(0);
+        return 1;
+    }
+
+    std::lock_guard<std::mutex> guard(poolLock);
+    sharedPool().run(n, [&](int i, int) { decode(i); });
+    return n;
+}
+
+}
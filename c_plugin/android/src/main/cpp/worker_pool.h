@@ -0,0 +1,112 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "scratch_arena.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Non-owning reference to a callable. std::function would copy a capturing
+// lambda to the heap on every batch; the callable here only has to outlive
+// the call it is passed to, which run() and forEachBand() guarantee.
+template <typename Sig>
+class FunctionRef;
+
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+public:
+    template <typename F, typename = std::enable_if_t<
+            !std::is_same<std::decay_t<F>, FunctionRef>::value>>
+    FunctionRef(F&& f)
+            : obj(const_cast<void*>(static_cast<const void*>(&f))),
+              fn([](void* o, Args... args) -> R {
+                  return (*static_cast<std::remove_reference_t<F>*>(o))(std::forward<Args>(args)...);
+              }) {}
+
+    R operator()(Args... args) const { return fn(obj, std::forward<Args>(args)...); }
+
+private:
+    void* obj;
+    R (*fn)(void*, Args...);
+};
+
+// Fixed pool of decode threads. run() fans a batch of independent tasks
+// (one per ROI or transmitter) out over the workers and the calling thread,
+// and returns once all of them are done, so results are emitted in task
+// order no matter which core produced them.
+class WorkerPool {
+public:
+    // threads <= 0: one thread per big core (see bigCores()).
+    explicit WorkerPool(int threads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Threads taking part in run(), the caller included
+    int size() const { return int(workers.size()) + 1; }
+
+    // Calls fn(task, worker) for every task in [0, tasks). `worker` is in
+    // [0, size()) and picks the scratch arena; the caller is worker 0.
+    // Arenas are reset before the batch starts.
+    void run(int tasks, FunctionRef<void(int task, int worker)> fn);
+
+    ScratchArena& scratch(int worker) { return arenas[size_t(worker)].arena; }
+
+    // True on a pool thread, or on the caller while it runs a batch
+    static bool inTask();
+
+    // CPUs of the fastest clusters: every core whose max frequency is above
+    // the slowest cluster's, or all of them on a symmetric or unknown SoC.
+    static std::vector<int> bigCores();
+
+private:
+    struct alignas(64) PaddedArena {
+        ScratchArena arena;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<PaddedArena> arenas;
+
+    std::mutex runLock;                 // one batch at a time
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    uint64_t generation = 0;
+    bool stopping = false;
+    int pending = 0;                    // workers still in the current batch
+
+    const FunctionRef<void(int, int)>* job = nullptr;
+    int jobTasks = 0;
+    alignas(64) std::atomic<int> nextTask{0};
+
+    void workerLoop(int worker, std::vector<int> cpus);
+    void drain(int worker);
+};
+
+// Row-band splitting of one large ROI over the shared pool (the one behind
+// lifi_pool_set_threads). Bands are contiguous row ranges, so per-row work
+// lands in the same place whatever the band count; callers merge per-band
+// partials in band order.
+
+// Smallest ROI, in pixels, that is worth splitting
+constexpr int LIFI_BAND_MIN_PIXELS = 256 * 256;
+
+// Bands forEachBand() should use for `rows` rows of at least `minRows`
+// each: 1 for small jobs or when already running on the pool.
+int bandCount(int rows, int minRows);
+
+// Calls fn(band, first, last, scratch) for `bands` contiguous bands of
+// [0, rows). Runs on the shared pool if it is idle and inline, in band
+// order, if it is busy; the results are the same either way.
+void forEachBand(int bands, int rows,
+                 FunctionRef<void(int band, int first, int last, ScratchArena& scratch)> fn);
+
+#endif // WORKER_POOL_H
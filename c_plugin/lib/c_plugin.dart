@@ -32,30 +32,31 @@ int sum(int a, int b) => _bindings.sum(a, b);
 /// Calls the native `const char* get_opencv_version()` function
 /// and converts the returned C string to a Dart `String`.
 
+/// Bright blobs in the Y rows at the start of [nv21], largest first.
+/// [rowStride] is the Y plane's bytes per row when the rows are padded
+/// (0 = [width]); only the Y rows are read, so `CameraImage.planes[0]` of
+/// any YUV format can be passed as is.
 List<Rect> findBrightRegions(
     Uint8List nv21,
     int width,
     int height,
     int threshold,
-    int maxRegions,
-    ) {
+    int maxRegions, {
+    int rowStride = 0,
+    }) {
   final dataPtr = calloc<Uint8>(nv21.length);
   dataPtr.asTypedList(nv21.length).setAll(0, nv21);
 
-  final bboxPtr  = calloc<Int>(maxRegions * 4);
-  final countPtr = calloc<Int>();
+  final bboxPtr = calloc<Int32>(maxRegions * 4);
+  final frame = _lumaFrame(dataPtr, width, height, rowStride, nullptr, 0);
 
-  _bindings.detect_bright_regions(
-    dataPtr,
-    width,
-    height,
+  final count = _bindings.lifi_detect_bright_regions(
+    frame,
     threshold,
     maxRegions,
     bboxPtr,
-    countPtr,
   );
 
-  final count = countPtr.value;
   final regions = <Rect>[];
   for (var i = 0; i < count; i++) {
     final x = bboxPtr[i * 4 + 0];
@@ -72,36 +73,126 @@ List<Rect> findBrightRegions(
 
   calloc.free(dataPtr);
   calloc.free(bboxPtr);
-  calloc.free(countPtr);
+  calloc.free(frame);
 
+  if (count < 0) throw ArgumentError('native detector refused the frame ($count)');
   return regions;
 }
 
-/// Checks if the LED in [roi] is ON (>5% bright pixels).
+/// Checks if the LED in [roi] is ON (>5% bright pixels). [rowStride] as
+/// for [findBrightRegions].
 bool checkLedOn(
     Uint8List nv21,
     int width,
     int height,
     int threshold,
-    Rect roi,
-    ) {
+    Rect roi, {
+    int rowStride = 0,
+    }) {
+  return checkLedsOn(nv21, width, height, threshold, [roi], rowStride: rowStride).single;
+}
+/// Checks several LEDs in one call. Builds one count table over the bounding
+/// box of [rois], so each extra LED is nearly free. [rowStride] as for
+/// [findBrightRegions].
+List<bool> checkLedsOn(
+    Uint8List nv21,
+    int width,
+    int height,
+    int threshold,
+    List<Rect> rois, {
+    int rowStride = 0,
+    }) {
+  if (rois.isEmpty) return const [];
+
   final dataPtr = calloc<Uint8>(nv21.length);
   dataPtr.asTypedList(nv21.length).setAll(0, nv21);
 
-  final result = _bindings.detect_led_on(
-    dataPtr,
+  final roiPtr = calloc<lifi_roi>(rois.length);
+  for (var i = 0; i < rois.length; i++) {
+    roiPtr[i]
+      ..x = rois[i].left.toInt()
+      ..y = rois[i].top.toInt()
+      ..w = rois[i].width.toInt()
+      ..h = rois[i].height.toInt();
+  }
+  final outPtr = calloc<Uint8>(rois.length);
+  final frame = _lumaFrame(dataPtr, width, height, rowStride, roiPtr, rois.length);
+
+  final status = _bindings.lifi_detect_leds_on(frame, threshold, outPtr);
+  final result = List<bool>.generate(rois.length, (i) => outPtr[i] == 1);
+
+  calloc.free(dataPtr);
+  calloc.free(roiPtr);
+  calloc.free(outPtr);
+  calloc.free(frame);
+
+  if (status < 0) throw ArgumentError('native detector refused the frame ($status)');
+  return result;
+}
+
+// A packed NV21 descriptor over the Y rows at [data] for the Y-only
+// detectors; the chroma after them is never read.
+Pointer<lifi_frame_desc> _lumaFrame(
+  Pointer<Uint8> data,
+  int width,
+  int height,
+  int rowStride,
+  Pointer<lifi_roi> rois,
+  int roiCount,
+) {
+  final frame = calloc<lifi_frame_desc>();
+  frame.ref
+    ..version = LIFI_ABI_VERSION
+    ..format = lifi_pixel_format.LIFI_FORMAT_NV21.value
+    ..y_plane = data
+    ..width = width
+    ..height = height
+    ..y_row_stride = rowStride
+    ..rois = rois
+    ..roi_count = roiCount;
+  return frame;
+}
+
+/// Builds the integral image of [yPlane] over [region] for this frame.
+/// Afterwards [integralMean] and [integralFractionAbove] cost four loads per
+/// rectangle. Pass [countThreshold] >= 0 to enable [integralFractionAbove].
+/// The table is per native thread, and an isolate can change threads
+/// between events, so query it without awaiting in between.
+bool buildIntegralImage(
+    Uint8List yPlane,
+    int width,
+    int height,
+    int rowStride,
+    Rect region, {
+    int countThreshold = -1,
+    }) {
+  final ptr = calloc<Uint8>(yPlane.length);
+  ptr.asTypedList(yPlane.length).setAll(0, yPlane);
+
+  final ok = _bindings.lifi_integral_build(
+    ptr,
     width,
     height,
-    threshold,
-    roi.left.toInt(),
-    roi.top.toInt(),
-    roi.width.toInt(),
-    roi.height.toInt(),
+    rowStride,
+    region.left.toInt(),
+    region.top.toInt(),
+    region.width.toInt(),
+    region.height.toInt(),
+    countThreshold,
   );
 
-  calloc.free(dataPtr);
-  return result == 1;
+  calloc.free(ptr);
+  return ok == 1;
 }
+
+/// Mean Y inside [rect], from the last [buildIntegralImage].
+double integralMean(Rect rect) => _bindings.lifi_integral_mean(
+    rect.left.toInt(), rect.top.toInt(), rect.width.toInt(), rect.height.toInt());
+
+/// Fraction of pixels above the count threshold inside [rect].
+double integralFractionAbove(Rect rect) => _bindings.lifi_integral_fraction_above(
+    rect.left.toInt(), rect.top.toInt(), rect.width.toInt(), rect.height.toInt());
+
 List<double> processFrameBrightness(
     Uint8List yPlane,
     int width,
@@ -179,6 +270,1392 @@ List<double> processFrameColor({
   return results;
 }
 
+/// Ambient-light filter applied to the luma series of [processFrameColor].
+enum AmbientFilter { none, highPass, notch }
+
+/// Configures ambient-light and mains-flicker rejection for [processFrameColor].
+///
+/// [backgroundRing] is the width (in 10x10 blocks) of the ROI border used as
+/// the background reference; 0 disables the subtraction. For
+/// [AmbientFilter.notch], [freqHz] is the mains flicker frequency (100 or
+/// 120 Hz) and is folded to its alias at [fps]; for [AmbientFilter.highPass]
+/// it is the cutoff frequency.
+void setAmbientRejection({
+  int backgroundRing = 0,
+  AmbientFilter filter = AmbientFilter.none,
+  double fps = 30.0,
+  double freqHz = 100.0,
+  double q = 0.707,
+}) {
+  _bindings.set_ambient_rejection(
+    backgroundRing,
+    filter.index,
+    fps,
+    freqHz,
+    q,
+  );
+}
+
+/// How [processFrameColor] reduces the block grid to one brightness value.
+enum LumaEstimator { mean, temporalVariance }
+
+/// Selects the luma estimator used by [processFrameColor].
+///
+/// [LumaEstimator.temporalVariance] weights each block by its max-min change
+/// over the last three frames, so the blinking LED dominates the background.
+/// Blocks that change by [changeThreshold] or less get no weight.
+void setLumaEstimator(LumaEstimator mode, {int changeThreshold = 0}) {
+  _bindings.set_luma_estimator(mode.index, changeThreshold);
+}
+
+/// Sets the block size (pixels per side, 1..64) of the grid
+/// [processFrameColor] downsamples the ROI into. Defaults to 10.
+void setBlockSize(int blockSize) {
+  _bindings.set_block_size(blockSize);
+}
+
+/// A native decoder session: its own history, filters and ROI buffers.
+///
+/// Buffers are sized once for frames up to [maxWidth] x [maxHeight], so any
+/// ROI inside such a frame works without per-frame allocation. The top-level
+/// [processFrameColor] uses a shared default session instead.
+class LifiSession {
+  LifiSession(int maxWidth, int maxHeight)
+      : _ptr = _bindings.lifi_session_create(maxWidth, maxHeight);
+
+  final Pointer<lifi_session> _ptr;
+  bool _disposed = false;
+
+  // Chroma plane layout of the frames decoded on this session
+  final _chromaLayout = _ChromaLayout();
+
+  /// Native handle, for passing to other session-aware calls.
+  Pointer<lifi_session> get pointer => _ptr;
+
+  void setAmbientRejection({
+    int backgroundRing = 0,
+    AmbientFilter filter = AmbientFilter.none,
+    double fps = 30.0,
+    double freqHz = 100.0,
+    double q = 0.707,
+  }) {
+    _bindings.lifi_session_set_ambient_rejection(
+      _ptr,
+      backgroundRing,
+      filter.index,
+      fps,
+      freqHz,
+      q,
+    );
+  }
+
+  void setLumaEstimator(LumaEstimator mode, {int changeThreshold = 0}) {
+    _bindings.lifi_session_set_luma_estimator(_ptr, mode.index, changeThreshold);
+  }
+
+  void setBlockSize(int blockSize) {
+    _bindings.lifi_session_set_block_size(_ptr, blockSize);
+  }
+
+  /// Same as the top-level [processFrameBrightness], with this session's
+  /// running min/max.
+  List<double> processFrameBrightness(
+    Uint8List yPlane,
+    int width,
+    int height,
+    int rowStride,
+    Rect roi,
+  ) {
+    final yPtr = calloc<Uint8>(yPlane.length)..asTypedList(yPlane.length).setAll(0, yPlane);
+    final outPtr = calloc<Double>(3);
+
+    _bindings.lifi_session_process_frame(
+      _ptr,
+      yPtr,
+      width,
+      height,
+      rowStride,
+      roi.left.toInt(),
+      roi.top.toInt(),
+      roi.width.toInt(),
+      roi.height.toInt(),
+      outPtr,
+    );
+
+    final results = [outPtr[0], outPtr[1], outPtr[2]];
+
+    calloc.free(yPtr);
+    calloc.free(outPtr);
+
+    return results;
+  }
+
+  /// Same as the top-level [processFrameColor], on this session.
+  List<double> processFrameColor({
+    required Uint8List yPlane,
+    required Uint8List uPlane,
+    required Uint8List vPlane,
+    required int width,
+    required int height,
+    required int count,
+    required int yRowStride,
+    required int uvRowStride,
+    required int uvPixelStride,
+    required Rect roi,
+  }) {
+    final yPtr = calloc<Uint8>(yPlane.length)..asTypedList(yPlane.length).setAll(0, yPlane);
+    final uPtr = calloc<Uint8>(uPlane.length)..asTypedList(uPlane.length).setAll(0, uPlane);
+    final vPtr = calloc<Uint8>(vPlane.length)..asTypedList(vPlane.length).setAll(0, vPlane);
+    final outPtr = calloc<Double>(7);
+
+    _bindings.lifi_session_process_frame_color(
+      _ptr,
+      yPtr, uPtr, vPtr,
+      width, height, count,
+      yRowStride, uvRowStride, uvPixelStride,
+      roi.left.toInt(), roi.top.toInt(),
+      roi.width.toInt(), roi.height.toInt(),
+      outPtr,
+    );
+
+    final results = List<double>.generate(7, (i) => outPtr[i]);
+
+    calloc.free(yPtr);
+    calloc.free(uPtr);
+    calloc.free(vPtr);
+    calloc.free(outPtr);
+
+    return results;
+  }
+
+  /// [processFrameColor] through the struct ABI: decodes the first of
+  /// [rois] (the whole frame if empty) and stamps the session with
+  /// [timestampNs] if it is set. A packed [format] takes the whole buffer
+  /// in [yPlane] and needs no other plane or chroma stride.
+  FrameResult decode({
+    required Uint8List yPlane,
+    Uint8List? uPlane,
+    Uint8List? vPlane,
+    required int width,
+    required int height,
+    required int count,
+    required int yRowStride,
+    int uvRowStride = 0,
+    int uvPixelStride = 0,
+    int timestampNs = 0,
+    List<Rect> rois = const [],
+    PixelFormat format = PixelFormat.yuv420,
+  }) {
+    return _decode(
+      [this], format, yPlane, uPlane, vPlane, width, height, count,
+      yRowStride, uvRowStride, uvPixelStride, timestampNs,
+      rois.take(1).toList(),
+    ).single;
+  }
+
+  /// Sensor timestamp (on the [LatencyClock]) of the frame the next
+  /// [processFrameColor] call decodes.
+  void stampFrame(int sensorTimestampNs) {
+    _bindings.lifi_session_stamp_frame(_ptr, sensorTimestampNs);
+  }
+
+  /// Reports a decoded byte; see the top-level [markByte].
+  void markByte(int value, {int firstSensorNs = 0, int lastSensorNs = 0}) {
+    _bindings.lifi_session_mark_byte(_ptr, value, firstSensorNs, lastSensorNs);
+  }
+
+  void dispose() {
+    if (_disposed) return;
+    _disposed = true;
+    _bindings.lifi_session_destroy(_ptr);
+  }
+}
+
+/// Stages of [processFrameColor] timed by the native library.
+enum PipelineStage {
+  roiCopy,
+  median,
+  downsample,
+  threshold,
+  colorHistogram,
+  classify,
+}
+
+/// Latency of one pipeline stage, one sample per frame.
+class StageStat {
+  const StageStat({
+    required this.count,
+    required this.total,
+    required this.min,
+    required this.max,
+    required this.p50,
+    required this.p99,
+  });
+
+  StageStat._from(lifi_stage_stat s)
+      : count = s.count,
+        total = _ns(s.total_ns),
+        min = _ns(s.min_ns),
+        max = _ns(s.max_ns),
+        p50 = _ns(s.p50_ns),
+        p99 = _ns(s.p99_ns);
+
+  final int count;
+  final Duration total;
+  final Duration min;
+  final Duration max;
+  final Duration p50;
+  final Duration p99;
+
+  Duration get mean =>
+      count == 0 ? Duration.zero : Duration(microseconds: total.inMicroseconds ~/ count);
+}
+
+Duration _ns(int ns) => Duration(microseconds: ns ~/ 1000);
+
+/// Per-stage timings of [session], or of the default session used by the
+/// top-level [processFrameColor]. Empty unless the native library was built
+/// with `-DLIFI_STAGE_TIMING=ON`.
+Map<PipelineStage, StageStat> getStageStats([LifiSession? session]) {
+  final out = calloc<lifi_stage_stats>();
+  final enabled = _bindings.lifi_get_stage_stats(session?.pointer ?? nullptr, out);
+
+  final stats = <PipelineStage, StageStat>{};
+  if (enabled == 1) {
+    for (final stage in PipelineStage.values) {
+      stats[stage] = StageStat._from(out.ref.stages[stage.index]);
+    }
+  }
+
+  calloc.free(out);
+  return stats;
+}
+
+/// Clears the per-stage timings of [session] (or the default session).
+void resetStageStats([LifiSession? session]) {
+  _bindings.lifi_reset_stage_stats(session?.pointer ?? nullptr);
+}
+
+/// Stage boundaries of the end-to-end latency histograms.
+enum LatencySpan {
+  sensorToEnqueue,
+  queueWait,
+  processing,
+  sensorToDecision,
+  decisionToByte,
+  sensorToByte,
+  character,
+}
+
+/// Clock the camera's sensor timestamps are on
+/// (`SENSOR_INFO_TIMESTAMP_SOURCE`): [monotonic] for UNKNOWN, [boottime] for
+/// REALTIME.
+enum LatencyClock { monotonic, boottime }
+
+/// Selects the clock sensor timestamps, and so all latencies, are on.
+void setLatencyClock(LatencyClock clock) => _bindings.lifi_latency_set_clock(clock.index);
+
+/// Current time on the latency clock, in nanoseconds.
+int latencyNow() => _bindings.lifi_latency_now();
+
+/// Sensor timestamp of the frame the next top-level [processFrameColor]
+/// call decodes. Frames that are never stamped only count towards
+/// [LatencySpan.processing].
+void stampFrame(int sensorTimestampNs) =>
+    _bindings.lifi_session_stamp_frame(nullptr, sensorTimestampNs);
+
+/// Reports that the decoder emitted [value], built from the frames with
+/// sensor timestamps [firstSensorNs] to [lastSensorNs]. Feeds the
+/// byte-level spans and adds a byte record to the trace.
+void markByte(int value, {int firstSensorNs = 0, int lastSensorNs = 0}) =>
+    _bindings.lifi_session_mark_byte(nullptr, value, firstSensorNs, lastSensorNs);
+
+/// End-to-end latency histograms of [session], or of the default session.
+/// The decode thread updates them without locking: call this, and
+/// [resetLatencyStats], from the isolate that decodes the session.
+Map<LatencySpan, StageStat> getLatencyStats([LifiSession? session]) {
+  final out = calloc<lifi_latency_stats>();
+  _bindings.lifi_get_latency_stats(session?.pointer ?? nullptr, out);
+
+  final stats = <LatencySpan, StageStat>{};
+  for (final span in LatencySpan.values) {
+    stats[span] = StageStat._from(out.ref.spans[span.index]);
+  }
+
+  calloc.free(out);
+  return stats;
+}
+
+/// Clears the latency histograms of [session] (or the default session).
+void resetLatencyStats([LifiSession? session]) {
+  _bindings.lifi_reset_latency_stats(session?.pointer ?? nullptr);
+}
+
+/// Arrival cadence of a session's frames: see [getCadenceStats].
+class CadenceStats {
+  const CadenceStats({
+    required this.frames,
+    required this.gaps,
+    required this.missedFrames,
+    required this.deadlineMisses,
+    required this.period,
+    required this.budget,
+    required this.lastMissed,
+    required this.interval,
+    required this.jitter,
+  });
+
+  final int frames;
+
+  /// Intervals with frames missing, and the frames missing in all of them.
+  final int gaps;
+  final int missedFrames;
+
+  /// Frames whose processing took longer than [budget].
+  final int deadlineMisses;
+
+  /// Frame period, set with [setFrameBudget] or estimated; zero until known.
+  final Duration period;
+  final Duration budget;
+
+  /// Frames missing right before the last frame; see [framesMissed].
+  final int lastMissed;
+
+  /// Time between frames, gaps included.
+  final StageStat interval;
+
+  /// Distance of each gap-free interval from [period].
+  final StageStat jitter;
+}
+
+/// Sets the frame period and per-frame processing budget of [session] (or
+/// the default session). Without a [period] it is estimated from recent
+/// frame intervals; without a [budget] it equals the period.
+void setFrameBudget({Duration? period, Duration? budget, LifiSession? session}) {
+  _bindings.lifi_session_set_frame_budget(
+    session?.pointer ?? nullptr,
+    (period?.inMicroseconds ?? 0) * 1000,
+    (budget?.inMicroseconds ?? 0) * 1000,
+  );
+}
+
+/// Frames missing right before the last frame [session] (or the default
+/// session) decoded, inferred from the frame timestamps. Skip this many
+/// slots when grouping frames into symbols to stay aligned after a gap.
+int framesMissed([LifiSession? session]) =>
+    _bindings.lifi_session_frames_missed(session?.pointer ?? nullptr);
+
+/// Frame intervals, gaps and deadline misses of [session], or of the
+/// default session. Like [getLatencyStats], call it (and
+/// [resetCadenceStats]) from the isolate that decodes the session.
+CadenceStats getCadenceStats([LifiSession? session]) {
+  final out = calloc<lifi_cadence_stats>();
+  _bindings.lifi_get_cadence_stats(session?.pointer ?? nullptr, out);
+
+  final c = out.ref;
+  final stats = CadenceStats(
+    frames: c.frames,
+    gaps: c.gaps,
+    missedFrames: c.missed_frames,
+    deadlineMisses: c.deadline_misses,
+    period: _ns(c.period_ns),
+    budget: _ns(c.budget_ns),
+    lastMissed: c.last_missed,
+    interval: StageStat._from(c.interval),
+    jitter: StageStat._from(c.jitter),
+  );
+
+  calloc.free(out);
+  return stats;
+}
+
+/// Clears the cadence counters and period estimate of [session] (or the
+/// default session).
+void resetCadenceStats([LifiSession? session]) {
+  _bindings.lifi_reset_cadence_stats(session?.pointer ?? nullptr);
+}
+
+/// One [processFrameColor] decision, or one [markByte] call, from the
+/// native trace ring.
+class TraceRecord {
+  const TraceRecord({
+    required this.session,
+    required this.frame,
+    required this.timestampNs,
+    required this.sensorNs,
+    required this.latency,
+    required this.wait,
+    required this.y,
+    required this.dynMin,
+    required this.dynMax,
+    required this.ledOn,
+    required this.encoded,
+    required this.color,
+    required this.flags,
+  });
+
+  final int session;
+  final int frame;
+  final int timestampNs;
+
+  /// Sensor timestamp of the frame (of the byte's last frame), 0 if unknown.
+  final int sensorNs;
+
+  /// Sensor to decision, or sensor to byte for [isByte].
+  final Duration latency;
+
+  /// Queued to processing, or last decision to byte for [isByte].
+  final Duration wait;
+
+  final double y;
+  final double dynMin;
+  final double dynMax;
+  final bool ledOn;
+  final int encoded;
+  final int color;
+  final int flags;
+
+  bool get isReset => flags & LIFI_TRACE_RESET != 0;
+
+  /// A [markByte] record: [frame] is the byte index, [encoded] the byte.
+  bool get isByte => flags & LIFI_TRACE_BYTE != 0;
+
+  /// Frames were missing right before this one.
+  bool get isGap => flags & LIFI_TRACE_GAP != 0;
+
+  /// Processing overran the frame budget.
+  bool get isLate => flags & LIFI_TRACE_LATE != 0;
+}
+
+/// Turns the per-frame native trace on or off (on by default).
+void setTraceEnabled(bool enabled) => _bindings.lifi_trace_enable(enabled ? 1 : 0);
+
+/// Records overwritten in the trace ring before they were drained.
+int get traceDropped => _bindings.lifi_trace_dropped();
+
+/// Takes up to [maxRecords] records from the trace ring, oldest first.
+List<TraceRecord> drainTrace({int maxRecords = 1024}) {
+  final buf = calloc<lifi_trace_record>(maxRecords);
+  final n = _bindings.lifi_trace_drain(buf, maxRecords);
+
+  final records = List<TraceRecord>.generate(n, (i) {
+    final r = buf[i];
+    return TraceRecord(
+      session: r.session,
+      frame: r.frame,
+      timestampNs: r.t_ns,
+      sensorNs: r.sensor_ns,
+      latency: Duration(microseconds: r.latency_us),
+      wait: Duration(microseconds: r.wait_us),
+      y: r.y,
+      dynMin: r.dyn_min,
+      dynMax: r.dyn_max,
+      ledOn: r.led_on != 0,
+      encoded: r.encoded,
+      color: r.color,
+      flags: r.flags,
+    );
+  });
+
+  calloc.free(buf);
+  return records;
+}
+
+/// Drains the trace ring into [path] for `tools/lifi_trace2csv`.
+/// Returns the number of records written, or -1 on error.
+int dumpTrace(String path) {
+  final cPath = path.toNativeUtf8();
+  final n = _bindings.lifi_trace_dump(cPath.cast<Char>());
+  malloc.free(cPath);
+  return n;
+}
+
+/// Records camera frames to a `.lfc` capture for offline replay
+/// (`tools/lifi_replay`).
+///
+/// With [cropMargin] >= 0 only the ROI grown by that many pixels is kept,
+/// which is far smaller than full frames; pass a negative margin to keep the
+/// planes exactly as the camera delivered them.
+class FrameRecorder {
+  FrameRecorder._(this._ptr, this.cropMargin);
+
+  /// Opens [path] for writing, or returns null if it cannot be created.
+  static FrameRecorder? open(String path, {int cropMargin = 32}) {
+    final cPath = path.toNativeUtf8();
+    final ptr = _bindings.lifi_recorder_open(cPath.cast<Char>());
+    malloc.free(cPath);
+    return ptr == nullptr ? null : FrameRecorder._(ptr, cropMargin);
+  }
+
+  final Pointer<lifi_recorder> _ptr;
+  final int cropMargin;
+  bool _closed = false;
+
+  // Native copies of the planes handed to write, kept between frames
+  final _staging = List<Pointer<Uint8>>.filled(3, nullptr);
+  final _stagingSize = List<int>.filled(3, 0);
+
+  Pointer<Uint8> _stage(int i, Uint8List plane) {
+    if (_stagingSize[i] < plane.length) {
+      if (_staging[i] != nullptr) calloc.free(_staging[i]);
+      _staging[i] = calloc<Uint8>(plane.length);
+      _stagingSize[i] = plane.length;
+    }
+    _staging[i].asTypedList(plane.length).setAll(0, plane);
+    return _staging[i];
+  }
+
+  /// Appends one frame with the [count] and [roi] given to [processFrameColor].
+  /// [timestampNs] is the sensor timestamp on the [LatencyClock]; without
+  /// one the frame is stamped with [latencyNow], so recordings line up with
+  /// latency traces either way.
+  bool write({
+    required Uint8List yPlane,
+    required Uint8List uPlane,
+    required Uint8List vPlane,
+    required int width,
+    required int height,
+    required int count,
+    required int yRowStride,
+    required int uvRowStride,
+    required int uvPixelStride,
+    required Rect roi,
+    int? timestampNs,
+  }) {
+    if (_closed) return false;
+    final ok = _bindings.lifi_recorder_write(
+      _ptr,
+      _stage(0, yPlane), _stage(1, uPlane), _stage(2, vPlane),
+      width, height,
+      yRowStride, uvRowStride, uvPixelStride,
+      count,
+      timestampNs ?? latencyNow(),
+      roi.left.toInt(), roi.top.toInt(),
+      roi.width.toInt(), roi.height.toInt(),
+      cropMargin,
+    );
+    return ok == 1;
+  }
+
+  /// Finishes the file. Returns the number of frames written, or -1.
+  int close() {
+    if (_closed) return -1;
+    _closed = true;
+    for (var i = 0; i < _staging.length; i++) {
+      if (_staging[i] != nullptr) calloc.free(_staging[i]);
+      _staging[i] = nullptr;
+    }
+    return _bindings.lifi_recorder_close(_ptr);
+  }
+}
+
+/// What [FrameQueue.push] does with a frame when the queue is full.
+/// [block] waits in native code for up to the queue's timeout, so it is
+/// only for producers off the UI isolate; a camera callback on the UI
+/// isolate uses one of the drop policies.
+enum QueuePolicy { dropOldest, dropNewest, block }
+
+/// One frame decoded by [FrameQueue.process].
+class QueuedResult {
+  const QueuedResult(this.values, this.timestampNs, this.seq);
+
+  /// Same layout as [processFrameColor].
+  final List<double> values;
+  final int timestampNs;
+
+  /// Producer sequence number; a jump means frames were dropped.
+  final int seq;
+}
+
+/// Counters of a [FrameQueue] since it was created.
+class QueueStats {
+  const QueueStats({
+    required this.enqueued,
+    required this.dequeued,
+    required this.droppedOldest,
+    required this.droppedNewest,
+    required this.timeouts,
+    required this.depth,
+    required this.maxDepth,
+  });
+
+  final int enqueued;
+  final int dequeued;
+  final int droppedOldest;
+  final int droppedNewest;
+  final int timeouts;
+  final int depth;
+  final int maxDepth;
+
+  int get dropped => droppedOldest + droppedNewest;
+}
+
+/// Bounded camera-to-decoder queue. The camera callback [push]es frames
+/// (only the ROI is copied) and a decoder, typically on another isolate
+/// using [pointer], [process]es them. Unlike skipping frames while busy,
+/// every drop is counted and shows up as a gap in [QueuedResult.seq].
+class FrameQueue {
+  FrameQueue(
+    int capacity,
+    int maxWidth,
+    int maxHeight, {
+    QueuePolicy policy = QueuePolicy.dropOldest,
+    Duration timeout = const Duration(milliseconds: 30),
+  }) : _ptr = _bindings.lifi_queue_create(
+          capacity,
+          maxWidth,
+          maxHeight,
+          policy.index,
+          timeout.inMilliseconds,
+        ),
+        _owned = true {
+    if (_ptr == nullptr) {
+      throw ArgumentError('invalid frame queue size');
+    }
+  }
+
+  /// Wraps a queue created elsewhere, e.g. passed to a decoder isolate by
+  /// address. The creator keeps ownership; [dispose] only frees this
+  /// wrapper's buffers.
+  FrameQueue.fromAddress(int address)
+      : _ptr = Pointer<lifi_frame_queue>.fromAddress(address),
+        _owned = false;
+
+  final Pointer<lifi_frame_queue> _ptr;
+  final bool _owned;
+  bool _disposed = false;
+
+  // Native out-parameters of claim and process, kept between frames
+  final Pointer<lifi_queue_slot> _slot = calloc<lifi_queue_slot>();
+  final Pointer<Double> _out = calloc<Double>(7);
+  final Pointer<Int64> _ts = calloc<Int64>();
+  final Pointer<Uint64> _seq = calloc<Uint64>();
+
+  Pointer<lifi_frame_queue> get pointer => _ptr;
+
+  /// Producer side. Returns false if the frame was dropped. The ROI is
+  /// copied straight from the planes into a queue slot, nothing else.
+  /// [timestampNs] is the sensor timestamp on the [LatencyClock]; without
+  /// one the frame is stamped when it is queued.
+  bool push({
+    required Uint8List yPlane,
+    required Uint8List uPlane,
+    required Uint8List vPlane,
+    required int width,
+    required int height,
+    required int count,
+    required int yRowStride,
+    required int uvRowStride,
+    required int uvPixelStride,
+    required Rect roi,
+    int? timestampNs,
+  }) {
+    if (_disposed) return false;
+    final claimed = _bindings.lifi_queue_claim(
+      _ptr,
+      width, height,
+      count,
+      timestampNs ?? 0,
+      roi.left.toInt(), roi.top.toInt(),
+      roi.width.toInt(), roi.height.toInt(),
+      _slot,
+    );
+    if (claimed != 1) return false;
+
+    // A claimed slot must be committed, or the producer side stays stuck
+    try {
+      final s = _slot.ref;
+      final w = s.width, h = s.height;
+      final y = s.y.asTypedList(w * h);
+      for (var r = 0; r < h; r++) {
+        y.setRange(r * w, r * w + w, yPlane, (s.y0 + r) * yRowStride + s.x0);
+      }
+      final cw = (w + 1) ~/ 2, ch = (h + 1) ~/ 2;
+      final u = s.u.asTypedList(cw * ch);
+      final v = s.v.asTypedList(cw * ch);
+      for (var r = 0; r < ch; r++) {
+        final row = (s.y0 ~/ 2 + r) * uvRowStride + (s.x0 ~/ 2) * uvPixelStride;
+        if (uvPixelStride == 1) {
+          u.setRange(r * cw, r * cw + cw, uPlane, row);
+          v.setRange(r * cw, r * cw + cw, vPlane, row);
+        } else {
+          for (var c = 0; c < cw; c++) {
+            u[r * cw + c] = uPlane[row + c * uvPixelStride];
+            v[r * cw + c] = vPlane[row + c * uvPixelStride];
+          }
+        }
+      }
+    } finally {
+      _bindings.lifi_queue_commit(_ptr);
+    }
+    return true;
+  }
+
+  /// Consumer side: decodes the oldest queued frame on [session], or
+  /// returns null if the queue is empty.
+  QueuedResult? process(LifiSession session) {
+    if (_disposed) return null;
+    if (_bindings.lifi_queue_process(_ptr, session.pointer, _out, _ts, _seq) != 1) {
+      return null;
+    }
+    return QueuedResult(
+      List<double>.from(_out.asTypedList(7)),
+      _ts.value,
+      _seq.value,
+    );
+  }
+
+  QueueStats get stats {
+    final out = calloc<lifi_queue_stats>();
+    _bindings.lifi_queue_get_stats(_ptr, out);
+    final s = out.ref;
+    final stats = QueueStats(
+      enqueued: s.enqueued,
+      dequeued: s.dequeued,
+      droppedOldest: s.dropped_oldest,
+      droppedNewest: s.dropped_newest,
+      timeouts: s.timeouts,
+      depth: s.depth,
+      maxDepth: s.max_depth,
+    );
+    calloc.free(out);
+    return stats;
+  }
+
+  /// Frees this wrapper's buffers, and the queue itself if it was created
+  /// here rather than wrapped with [FrameQueue.fromAddress].
+  void dispose() {
+    if (_disposed) return;
+    _disposed = true;
+    calloc.free(_slot);
+    calloc.free(_out);
+    calloc.free(_ts);
+    calloc.free(_seq);
+    if (_owned) _bindings.lifi_queue_destroy(_ptr);
+  }
+}
+
+/// Resizes the native decode pool used by [processFrameColorMulti].
+/// [threads] <= 0 gives one thread per big core. Returns the new size.
+int setDecodeThreads(int threads) => _bindings.lifi_pool_set_threads(threads);
+
+/// Threads taking part in [processFrameColorMulti], the caller included.
+int get decodeThreads => _bindings.lifi_pool_threads();
+
+/// Runs [LifiSession.processFrameColor] for every ROI of one frame on the
+/// decode pool: `rois[i]` is decoded on `sessions[i]`. The planes are copied
+/// once for all ROIs. Returns one 7-value list per ROI, in [rois] order.
+List<List<double>> processFrameColorMulti({
+  required List<LifiSession> sessions,
+  required Uint8List yPlane,
+  required Uint8List uPlane,
+  required Uint8List vPlane,
+  required int width,
+  required int height,
+  required int count,
+  required int yRowStride,
+  required int uvRowStride,
+  required int uvPixelStride,
+  required List<Rect> rois,
+}) {
+  if (sessions.length != rois.length) {
+    throw ArgumentError('one session per ROI');
+  }
+  final n = rois.length;
+  if (n == 0) return const [];
+
+  final yPtr = calloc<Uint8>(yPlane.length)..asTypedList(yPlane.length).setAll(0, yPlane);
+  final uPtr = calloc<Uint8>(uPlane.length)..asTypedList(uPlane.length).setAll(0, uPlane);
+  final vPtr = calloc<Uint8>(vPlane.length)..asTypedList(vPlane.length).setAll(0, vPlane);
+  final sessionPtr = calloc<Pointer<lifi_session>>(n);
+  final roiPtr = calloc<Int32>(n * 4);
+  for (var i = 0; i < n; i++) {
+    sessionPtr[i] = sessions[i].pointer;
+    roiPtr[i * 4 + 0] = rois[i].left.toInt();
+    roiPtr[i * 4 + 1] = rois[i].top.toInt();
+    roiPtr[i * 4 + 2] = rois[i].width.toInt();
+    roiPtr[i * 4 + 3] = rois[i].height.toInt();
+  }
+  final outPtr = calloc<Double>(n * 7);
+
+  _bindings.lifi_process_frame_color_multi(
+    sessionPtr, n,
+    yPtr, uPtr, vPtr,
+    width, height, count,
+    yRowStride, uvRowStride, uvPixelStride,
+    roiPtr,
+    outPtr,
+  );
+
+  final out = outPtr.asTypedList(n * 7);
+  final results = List<List<double>>.generate(
+    n,
+    (i) => List<double>.from(out.sublist(i * 7, i * 7 + 7)),
+  );
+
+  calloc.free(yPtr);
+  calloc.free(uPtr);
+  calloc.free(vPtr);
+  calloc.free(sessionPtr);
+  calloc.free(roiPtr);
+  calloc.free(outPtr);
+  return results;
+}
+
+/// Pixel layout of a frame for [decodeFrame], [LifiSession.decode] and
+/// [decodeFrameMulti]; [LifiCapabilities.supports] tells which ones the
+/// library takes.
+enum PixelFormat {
+  /// `CameraImage` YUV_420_888: Y, U and V planes with their own strides.
+  yuv420,
+
+  /// One packed buffer in `yPlane`: Y rows, then interleaved V,U rows.
+  nv21,
+
+  /// One packed buffer: Y rows, then interleaved U,V rows.
+  nv12,
+
+  /// One packed buffer: Y rows, then the U plane and the V plane.
+  i420,
+}
+
+/// Per-frame events of a [FrameResult].
+enum FrameEventType {
+  /// History cleared (count == 0).
+  reset,
+  ledOn,
+  ledOff,
+
+  /// Colour class changed; the value is the new [classifyHsvColor] code.
+  color,
+
+  /// The value is the number of frames missing right before this one.
+  gap,
+
+  /// Processing overran the frame budget.
+  late,
+}
+
+class FrameEvent {
+  const FrameEvent(this.type, this.value);
+
+  final FrameEventType type;
+  final int value;
+}
+
+/// The decision for one ROI of one frame, from [decodeFrame],
+/// [LifiSession.decode] or [decodeFrameMulti].
+class FrameResult {
+  const FrameResult({
+    required this.frame,
+    required this.sensorNs,
+    required this.y,
+    required this.dynMin,
+    required this.dynMax,
+    required this.hue,
+    required this.sat,
+    required this.val,
+    required this.color,
+    required this.ledOn,
+    required this.encoded,
+    required this.flags,
+    required this.latency,
+    required this.events,
+  });
+
+  factory FrameResult._from(lifi_result r) => FrameResult(
+        frame: r.frame,
+        sensorNs: r.sensor_ns,
+        y: r.y,
+        dynMin: r.dyn_min,
+        dynMax: r.dyn_max,
+        hue: r.hue,
+        sat: r.sat,
+        val: r.val,
+        color: r.color,
+        ledOn: r.led_on != 0,
+        encoded: r.encoded,
+        flags: r.flags,
+        latency: Duration(microseconds: r.latency_us),
+        events: List.unmodifiable(List.generate(
+          r.event_count,
+          (i) => FrameEvent(
+            FrameEventType.values[r.events[i].type - LIFI_EVENT_RESET],
+            r.events[i].value,
+          ),
+        )),
+      );
+
+  /// Frames the session had decoded before this one.
+  final int frame;
+
+  /// Sensor timestamp of the frame, 0 if unknown.
+  final int sensorNs;
+
+  final double y;
+  final double dynMin;
+  final double dynMax;
+  final double hue;
+  final double sat;
+  final double val;
+
+  /// [classifyHsvColor] code.
+  final int color;
+  final bool ledOn;
+
+  /// 5-frame on/off bitmask.
+  final int encoded;
+
+  /// LIFI_TRACE_* flags, as in [TraceRecord].
+  final int flags;
+
+  /// Sensor to decision, zero if the frame had no timestamp.
+  final Duration latency;
+  final List<FrameEvent> events;
+
+  /// The 7 values [processFrameColor] returns for the same frame.
+  List<double> get values =>
+      [y, dynMin, dynMax, hue, sat, color.toDouble(), encoded.toDouble()];
+}
+
+/// What the loaded native library supports: see [getCapabilities].
+class LifiCapabilities {
+  const LifiCapabilities({
+    required this.abiVersion,
+    required this.formats,
+    required this.features,
+    required this.maxEvents,
+    required this.poolThreads,
+  });
+
+  final int abiVersion;
+
+  /// Bit `1 << f` for each supported lifi_pixel_format `f`.
+  final int formats;
+
+  /// LIFI_FEATURE_* bits.
+  final int features;
+  final int maxEvents;
+  final int poolThreads;
+
+  /// The library speaks the struct ABI these bindings were generated for.
+  bool get compatible => abiVersion == LIFI_ABI_VERSION;
+
+  bool supports(PixelFormat format) => formats & (1 << format.index) != 0;
+
+  bool get hasOpenCv => features & LIFI_FEATURE_OPENCV != 0;
+  bool get hasStageTiming => features & LIFI_FEATURE_STAGE_TIMING != 0;
+}
+
+LifiCapabilities getCapabilities() {
+  final out = calloc<lifi_capabilities>();
+  _bindings.lifi_get_capabilities(out);
+
+  final c = out.ref;
+  final result = LifiCapabilities(
+    abiVersion: c.abi_version,
+    formats: c.formats,
+    features: c.features,
+    maxEvents: c.max_events,
+    poolThreads: c.pool_threads,
+  );
+
+  calloc.free(out);
+  return result;
+}
+
+/// [processFrameColor] on the default session through the struct ABI; see
+/// [LifiSession.decode].
+FrameResult decodeFrame({
+  required Uint8List yPlane,
+  Uint8List? uPlane,
+  Uint8List? vPlane,
+  required int width,
+  required int height,
+  required int count,
+  required int yRowStride,
+  int uvRowStride = 0,
+  int uvPixelStride = 0,
+  int timestampNs = 0,
+  List<Rect> rois = const [],
+  PixelFormat format = PixelFormat.yuv420,
+}) {
+  return _decode(
+    null, format, yPlane, uPlane, vPlane, width, height, count,
+    yRowStride, uvRowStride, uvPixelStride, timestampNs,
+    rois.take(1).toList(),
+  ).single;
+}
+
+/// [processFrameColorMulti] through the struct ABI: `rois[i]` is decoded on
+/// `sessions[i]`, in parallel on the decode pool.
+List<FrameResult> decodeFrameMulti({
+  required List<LifiSession> sessions,
+  required Uint8List yPlane,
+  Uint8List? uPlane,
+  Uint8List? vPlane,
+  required int width,
+  required int height,
+  required int count,
+  required int yRowStride,
+  int uvRowStride = 0,
+  int uvPixelStride = 0,
+  int timestampNs = 0,
+  required List<Rect> rois,
+  PixelFormat format = PixelFormat.yuv420,
+}) {
+  if (sessions.length != rois.length) {
+    throw ArgumentError('one session per ROI');
+  }
+  if (rois.isEmpty) return const [];
+  return _decode(
+    sessions, format, yPlane, uPlane, vPlane, width, height, count,
+    yRowStride, uvRowStride, uvPixelStride, timestampNs, rois,
+  );
+}
+
+// Fills a lifi_frame_desc and runs lifi_session_decode on the default
+// session (sessions == null) or lifi_decode on one session per ROI.
+List<FrameResult> _decode(
+  List<LifiSession>? sessions,
+  PixelFormat format,
+  Uint8List yPlane,
+  Uint8List? uPlane,
+  Uint8List? vPlane,
+  int width,
+  int height,
+  int count,
+  int yRowStride,
+  int uvRowStride,
+  int uvPixelStride,
+  int timestampNs,
+  List<Rect> rois,
+) {
+  final n = rois.isEmpty ? 1 : rois.length;
+
+  final yPtr = calloc<Uint8>(yPlane.length)..asTypedList(yPlane.length).setAll(0, yPlane);
+  final chroma = _copyChroma(
+    uPlane, vPlane, uvPixelStride,
+    sessions == null ? _defaultChromaLayout : sessions.first._chromaLayout,
+  );
+  final roiPtr = calloc<lifi_roi>(n);
+  for (var i = 0; i < rois.length; i++) {
+    roiPtr[i]
+      ..x = rois[i].left.toInt()
+      ..y = rois[i].top.toInt()
+      ..w = rois[i].width.toInt()
+      ..h = rois[i].height.toInt();
+  }
+  final frame = calloc<lifi_frame_desc>();
+  frame.ref
+    ..version = LIFI_ABI_VERSION
+    ..format = format.index
+    ..y_plane = yPtr
+    ..u_plane = chroma.u
+    ..v_plane = chroma.v
+    ..width = width
+    ..height = height
+    ..y_row_stride = yRowStride
+    ..uv_row_stride = uvRowStride
+    ..uv_pixel_stride = uvPixelStride
+    ..count = count
+    ..timestamp_ns = timestampNs
+    ..rois = roiPtr
+    ..roi_count = rois.length;
+  final outPtr = calloc<lifi_result>(n);
+  final sessionPtr = calloc<Pointer<lifi_session>>(n);
+
+  final int status;
+  if (sessions == null) {
+    status = _bindings.lifi_session_decode(nullptr, frame, outPtr);
+  } else {
+    for (var i = 0; i < n; i++) {
+      sessionPtr[i] = sessions[i].pointer;
+    }
+    status = _bindings.lifi_decode(sessionPtr, frame, outPtr);
+  }
+  final results = status > 0
+      ? List<FrameResult>.generate(status, (i) => FrameResult._from(outPtr[i]))
+      : const <FrameResult>[];
+
+  calloc.free(yPtr);
+  chroma.free();
+  calloc.free(roiPtr);
+  calloc.free(frame);
+  calloc.free(outPtr);
+  calloc.free(sessionPtr);
+
+  if (status == LIFI_ERR_VERSION || status == LIFI_ERR_FORMAT) {
+    throw UnsupportedError('native decoder refused the frame ($status)');
+  }
+  if (status < 0) throw ArgumentError('native decoder refused the frame ($status)');
+  return results;
+}
+
+// Native copies of the U and V planes for _decode. Android's pixel stride 2
+// planes are two views of one interleaved V,U (or U,V) buffer, handed over
+// as separate copies; they are put back into one buffer so the native side
+// sees NV21 / NV12 and runs that kernel instead of the generic strided one.
+class _Chroma {
+  _Chroma(this.u, this.v, this._buffers);
+
+  final Pointer<Uint8> u;
+  final Pointer<Uint8> v;
+  final List<Pointer<Uint8>> _buffers;
+
+  void free() {
+    for (final b in _buffers) {
+      calloc.free(b);
+    }
+  }
+}
+
+enum _ChromaKind { separate, vFirst, uFirst }
+
+// How one stream's pixel stride 2 U and V planes relate. Views of one
+// buffer tell by their offsets; separate copies take a byte scan, done
+// when the stream's stride or plane size changes and reused after that.
+class _ChromaLayout {
+  int _pixelStride = -1;
+  int _length = -1;
+  _ChromaKind _kind = _ChromaKind.separate;
+
+  _ChromaKind of(Uint8List u, Uint8List v, int pixelStride) {
+    if (u.buffer == v.buffer) {
+      if (u.offsetInBytes == v.offsetInBytes + 1) return _ChromaKind.vFirst;
+      if (v.offsetInBytes == u.offsetInBytes + 1) return _ChromaKind.uFirst;
+      return _ChromaKind.separate;
+    }
+    if (pixelStride != _pixelStride || u.length != _length) {
+      final vu = _shiftedBy1(v, u);
+      final uv = vu == false ? _shiftedBy1(u, v) : false;
+      // Flat chroma matches either way: copy separately, look again next frame
+      if (vu == null || uv == null) return _ChromaKind.separate;
+      _pixelStride = pixelStride;
+      _length = u.length;
+      _kind = vu ? _ChromaKind.vFirst : uv ? _ChromaKind.uFirst : _ChromaKind.separate;
+    }
+    return _kind;
+  }
+}
+
+// Layout of the frames decoded on the default session
+final _defaultChromaLayout = _ChromaLayout();
+
+_Chroma _copyChroma(Uint8List? uPlane, Uint8List? vPlane, int pixelStride, _ChromaLayout layout) {
+  if (uPlane != null && vPlane != null && pixelStride == 2 &&
+      uPlane.length == vPlane.length && uPlane.isNotEmpty) {
+    switch (layout.of(uPlane, vPlane, pixelStride)) {
+      case _ChromaKind.vFirst:
+        final p = _copyShifted(vPlane, uPlane);
+        return _Chroma(p + 1, p, [p]);
+      case _ChromaKind.uFirst:
+        final p = _copyShifted(uPlane, vPlane);
+        return _Chroma(p, p + 1, [p]);
+      case _ChromaKind.separate:
+        break;
+    }
+  }
+  final u = _copyPlane(uPlane);
+  final v = _copyPlane(vPlane);
+  return _Chroma(u, v, [if (u != nullptr) u, if (v != nullptr) v]);
+}
+
+// Whether `second` is `first` one byte on, by comparing every byte; null
+// when `first` is flat, which would match any flat `second`
+bool? _shiftedBy1(Uint8List first, Uint8List second) {
+  var varied = false;
+  for (var i = 0; i + 1 < first.length; i++) {
+    if (second[i] != first[i + 1]) return false;
+    if (first[i] != first[0]) varied = true;
+  }
+  return varied ? true : null;
+}
+
+// The interleaved buffer `first` and `second` were cut from
+Pointer<Uint8> _copyShifted(Uint8List first, Uint8List second) {
+  final n = first.length + 1;
+  final p = calloc<Uint8>(n);
+  p.asTypedList(n)
+    ..setAll(0, first)
+    ..[n - 1] = second[second.length - 1];
+  return p;
+}
+
+Pointer<Uint8> _copyPlane(Uint8List? plane) {
+  if (plane == null) return nullptr;
+  return calloc<Uint8>(plane.length)..asTypedList(plane.length).setAll(0, plane);
+}
+
+/// The latest decision of a session from the native shared result block.
+/// A poll only peeks at the block's sequence number in place; when it has
+/// moved, one lifi_read_shared_result call takes a consistent copy (Dart's
+/// plain loads cannot be ordered for the seqlock check themselves). The
+/// decode thread never waits for it. Meant to be polled at display rate,
+/// e.g. from a Ticker; the fields hold the last consistent read and are
+/// updated in place, so polling does not allocate.
+///
+/// Stays valid until the session is disposed.
+class LiveResult {
+  LiveResult._(this._session)
+      : _block = _bindings.lifi_session_shared_result(_session).ref,
+        _copy = calloc<lifi_shared_result>() {
+    _finalizer.attach(this, _copy);
+  }
+
+  static final _finalizer = Finalizer<Pointer<lifi_shared_result>>(calloc.free);
+
+  final Pointer<lifi_session> _session;
+  final lifi_shared_result _block;
+  final Pointer<lifi_shared_result> _copy;
+  int _seq = 0;
+
+  /// Frames the session had decoded before this one.
+  int frame = 0;
+
+  /// Frame of the last LED on/off change; `frame - edgeFrame` is how long
+  /// the link has been quiet.
+  int edgeFrame = 0;
+  int sensorNs = 0;
+
+  /// CLOCK_MONOTONIC time of the decision, in nanoseconds.
+  int timestampNs = 0;
+  double y = 0.0;
+  double dynMin = 0.0;
+  double dynMax = 0.0;
+  double hue = 0.0;
+  double sat = 0.0;
+  double val = 0.0;
+
+  /// [classifyHsvColor] code.
+  int color = 0;
+  bool ledOn = false;
+  int encoded = 0;
+
+  /// LIFI_TRACE_* flags, as in [TraceRecord].
+  int flags = 0;
+  int framesMissed = 0;
+
+  /// Sensor to decision in microseconds, 0 if the frame had no timestamp.
+  int latencyUs = 0;
+
+  /// Whether anything has been published yet.
+  bool get valid => _seq != 0;
+
+  /// Takes the latest published decision if it is new and was not being
+  /// rewritten during the read. Returns whether the fields changed; on false
+  /// they keep the previous read, and the next poll picks up the new one.
+  bool update() {
+    if (_block.seq == _seq) return false;
+    if (_bindings.lifi_read_shared_result(_session, _copy) == 0) return false;
+
+    final b = _copy.ref;
+    if (b.seq == _seq) return false;
+    _seq = b.seq;
+    frame = b.frame;
+    edgeFrame = b.edge_frame;
+    sensorNs = b.sensor_ns;
+    timestampNs = b.t_ns;
+    y = b.y;
+    dynMin = b.dyn_min;
+    dynMax = b.dyn_max;
+    hue = b.hue;
+    sat = b.sat;
+    val = b.val;
+    color = b.color;
+    ledOn = b.led_on != 0;
+    encoded = b.encoded;
+    flags = b.flags;
+    framesMissed = b.frames_missed;
+    latencyUs = b.latency_us;
+    return true;
+  }
+}
+
+/// Live view of the latest decision of [session] (the default session if
+/// null); see [LiveResult].
+LiveResult liveResult([LifiSession? session]) =>
+    LiveResult._(session?.pointer ?? nullptr);
+
+/// What the strip shows during one slot.
+enum SlotColor { off, red, blue, green }
+
+/// The optical protocol the plugin was built with (lifi_protocol.h, shared
+/// with the ESP32 firmware): see [protocol].
+class LifiProtocol {
+  const LifiProtocol({
+    required this.marker,
+    required this.bitColors,
+    required this.slotsPerPulse,
+    required this.payloadBits,
+    required this.gapSlots,
+    required this.slotsPerChar,
+    required this.payloadSlots,
+    required this.defaultInterval,
+    required this.minInterval,
+    required this.framesPerSlot,
+  });
+
+  /// Start marker pulses, in transmit order.
+  final List<SlotColor> marker;
+
+  /// Pulse colour of a 0 bit and of a 1 bit.
+  final List<SlotColor> bitColors;
+
+  /// Slots per pulse: one lit, the rest dark.
+  final int slotsPerPulse;
+
+  /// Bits per character, MSB first.
+  final int payloadBits;
+
+  /// Dark slots after the last bit's pulse.
+  final int gapSlots;
+  final int slotsPerChar;
+
+  /// Slots after the marker until a character is complete.
+  final int payloadSlots;
+
+  /// Slot interval; requests under [minInterval] fall back to the default.
+  final Duration defaultInterval;
+  final Duration minInterval;
+
+  /// Camera frames voted into one slot.
+  final int framesPerSlot;
+
+  /// With the newest slot last and the lit slot of the marker's last pulse
+  /// newest, how many slots back (1 = newest) the lit slot of pulse [pulse] is.
+  int markerBack(int pulse) => (marker.length - 1 - pulse) * slotsPerPulse + 1;
+
+  /// Lit slot of payload bit [bit], counted from the slot after the marker's
+  /// last lit slot.
+  int bitSlot(int bit) => 1 + bit * slotsPerPulse;
+}
+
+/// The protocol both ends are built with.
+final LifiProtocol protocol = () {
+  final out = calloc<lifi_protocol>();
+  _bindings.lifi_get_protocol(out);
+
+  final p = out.ref;
+  SlotColor color(int code) => SlotColor.values[code & 3];
+  final result = LifiProtocol(
+    marker: List.unmodifiable(
+        List.generate(p.marker_pulses, (i) => color(p.marker[i]))),
+    bitColors: List.unmodifiable([color(p.bit_color[0]), color(p.bit_color[1])]),
+    slotsPerPulse: p.slots_per_pulse,
+    payloadBits: p.payload_bits,
+    gapSlots: p.gap_slots,
+    slotsPerChar: p.slots_per_char,
+    payloadSlots: p.payload_slots,
+    defaultInterval: Duration(milliseconds: p.default_interval_ms),
+    minInterval: Duration(milliseconds: p.min_interval_ms),
+    framesPerSlot: p.frames_per_slot,
+  );
+
+  calloc.free(out);
+  return result;
+}();
+
 /// Computes [hue, sat, val] over the ROI by building a hue histogram.
 /// Returns a List<double> of length 3.
 List<double> detectFrameColorPrecise({
@@ -396,6 +396,1907 @@ class NativeLibrary {
   >('classify_hsv_color');
   late final _classify_hsv_color =
       _classify_hsv_colorPtr.asFunction<int Function(double, double, double)>();
+
+  /// ambient-light / mains-flicker rejection for process_frame_color
+  /// filter_type: 0 = none, 1 = high-pass, 2 = notch (freq_hz = mains frequency)
+  void set_ambient_rejection(
+    int background_ring,
+    int filter_type,
+    double fps,
+    double freq_hz,
+    double q,
+  ) {
+    return _set_ambient_rejection(
+      background_ring,
+      filter_type,
+      fps,
+      freq_hz,
+      q,
+    );
+  }
+
+  late final _set_ambient_rejectionPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Double,
+        ffi.Double,
+        ffi.Double,
+      )
+    >
+  >('set_ambient_rejection');
+  late final _set_ambient_rejection =
+      _set_ambient_rejectionPtr
+          .asFunction<
+            void Function(int, int, double, double, double)
+          >();
+
+  /// luma estimator for process_frame_color
+  /// mode: 0 = block mean, 1 = temporal-variance weighted (last 3 frames)
+  void set_luma_estimator(int mode, int change_threshold) {
+    return _set_luma_estimator(mode, change_threshold);
+  }
+
+  late final _set_luma_estimatorPtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Int32, ffi.Int32)>
+  >('set_luma_estimator');
+  late final _set_luma_estimator =
+      _set_luma_estimatorPtr.asFunction<void Function(int, int)>();
+
+  /// poll roi_count LEDs ([x, y, w, h] quads in rois) with one integral image
+  void detect_leds_on(
+    ffi.Pointer<ffi.Uint8> nv21_data,
+    int width,
+    int height,
+    int threshold,
+    ffi.Pointer<ffi.Int> rois,
+    int roi_count,
+    ffi.Pointer<ffi.Uint8> out_on,
+  ) {
+    return _detect_leds_on(
+      nv21_data,
+      width,
+      height,
+      threshold,
+      rois,
+      roi_count,
+      out_on,
+    );
+  }
+
+  late final _detect_leds_onPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Int,
+        ffi.Int,
+        ffi.Uint8,
+        ffi.Pointer<ffi.Int>,
+        ffi.Int,
+        ffi.Pointer<ffi.Uint8>,
+      )
+    >
+  >('detect_leds_on');
+  late final _detect_leds_on =
+      _detect_leds_onPtr
+          .asFunction<
+            void Function(
+              ffi.Pointer<ffi.Uint8>,
+              int,
+              int,
+              int,
+              ffi.Pointer<ffi.Int>,
+              int,
+              ffi.Pointer<ffi.Uint8>,
+            )
+          >();
+
+  /// build this frame's Y integral image over (x, y, w, h)
+  /// count_threshold >= 0 also builds a count of pixels above it
+  /// tables are per thread: query them on the thread that built them
+  int lifi_integral_build(
+    ffi.Pointer<ffi.Uint8> y_plane,
+    int width,
+    int height,
+    int row_stride,
+    int x,
+    int y,
+    int w,
+    int h,
+    int count_threshold,
+  ) {
+    return _lifi_integral_build(
+      y_plane,
+      width,
+      height,
+      row_stride,
+      x,
+      y,
+      w,
+      h,
+      count_threshold,
+    );
+  }
+
+  late final _lifi_integral_buildPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+      )
+    >
+  >('lifi_integral_build');
+  late final _lifi_integral_build =
+      _lifi_integral_buildPtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<ffi.Uint8>,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+            )
+          >();
+
+  /// mean Y over a rectangle of the built region
+  double lifi_integral_mean(int x, int y, int w, int h) {
+    return _lifi_integral_mean(x, y, w, h);
+  }
+
+  late final _lifi_integral_meanPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Double Function(
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+      )
+    >
+  >('lifi_integral_mean');
+  late final _lifi_integral_mean =
+      _lifi_integral_meanPtr.asFunction<double Function(int, int, int, int)>();
+
+  /// fraction of pixels above count_threshold over a rectangle of the built region
+  double lifi_integral_fraction_above(int x, int y, int w, int h) {
+    return _lifi_integral_fraction_above(x, y, w, h);
+  }
+
+  late final _lifi_integral_fraction_abovePtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Double Function(
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+      )
+    >
+  >('lifi_integral_fraction_above');
+  late final _lifi_integral_fraction_above =
+      _lifi_integral_fraction_abovePtr
+          .asFunction<
+            double Function(int, int, int, int)
+          >();
+
+  /// create a decoder session with buffers sized for frames up to max_width x max_height
+  ffi.Pointer<lifi_session> lifi_session_create(int max_width, int max_height) {
+    return _lifi_session_create(max_width, max_height);
+  }
+
+  late final _lifi_session_createPtr = _lookup<
+    ffi.NativeFunction<ffi.Pointer<lifi_session> Function(ffi.Int32, ffi.Int32)>
+  >('lifi_session_create');
+  late final _lifi_session_create =
+      _lifi_session_createPtr
+          .asFunction<
+            ffi.Pointer<lifi_session> Function(int, int)
+          >();
+
+  /// free a session from lifi_session_create
+  void lifi_session_destroy(ffi.Pointer<lifi_session> session) {
+    return _lifi_session_destroy(session);
+  }
+
+  late final _lifi_session_destroyPtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<lifi_session>)>
+  >('lifi_session_destroy');
+  late final _lifi_session_destroy =
+      _lifi_session_destroyPtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_session>)
+          >();
+
+  /// process_frame_color on an explicit session; NULL = default
+  void lifi_session_process_frame_color(
+    ffi.Pointer<lifi_session> session,
+    ffi.Pointer<ffi.Uint8> y_plane,
+    ffi.Pointer<ffi.Uint8> u_plane,
+    ffi.Pointer<ffi.Uint8> v_plane,
+    int width,
+    int height,
+    int count,
+    int y_row_stride,
+    int uv_row_stride,
+    int uv_pixel_stride,
+    int x0,
+    int y0,
+    int w,
+    int h,
+    ffi.Pointer<ffi.Double> out_values,
+  ) {
+    return _lifi_session_process_frame_color(
+      session,
+      y_plane,
+      u_plane,
+      v_plane,
+      width,
+      height,
+      count,
+      y_row_stride,
+      uv_row_stride,
+      uv_pixel_stride,
+      x0,
+      y0,
+      w,
+      h,
+      out_values,
+    );
+  }
+
+  late final _lifi_session_process_frame_colorPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Pointer<ffi.Double>,
+      )
+    >
+  >('lifi_session_process_frame_color');
+  late final _lifi_session_process_frame_color =
+      _lifi_session_process_frame_colorPtr
+          .asFunction<
+            void Function(
+              ffi.Pointer<lifi_session>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Uint8>,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              ffi.Pointer<ffi.Double>,
+            )
+          >();
+
+  /// set_ambient_rejection for one session
+  void lifi_session_set_ambient_rejection(
+    ffi.Pointer<lifi_session> session,
+    int background_ring,
+    int filter_type,
+    double fps,
+    double freq_hz,
+    double q,
+  ) {
+    return _lifi_session_set_ambient_rejection(
+      session,
+      background_ring,
+      filter_type,
+      fps,
+      freq_hz,
+      q,
+    );
+  }
+
+  late final _lifi_session_set_ambient_rejectionPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Double,
+        ffi.Double,
+        ffi.Double,
+      )
+    >
+  >('lifi_session_set_ambient_rejection');
+  late final _lifi_session_set_ambient_rejection =
+      _lifi_session_set_ambient_rejectionPtr
+          .asFunction<
+            void Function(
+              ffi.Pointer<lifi_session>,
+              int,
+              int,
+              double,
+              double,
+              double,
+            )
+          >();
+
+  /// set_luma_estimator for one session
+  void lifi_session_set_luma_estimator(
+    ffi.Pointer<lifi_session> session,
+    int mode,
+    int change_threshold,
+  ) {
+    return _lifi_session_set_luma_estimator(session, mode, change_threshold);
+  }
+
+  late final _lifi_session_set_luma_estimatorPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Int32,
+        ffi.Int32,
+      )
+    >
+  >('lifi_session_set_luma_estimator');
+  late final _lifi_session_set_luma_estimator =
+      _lifi_session_set_luma_estimatorPtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_session>, int, int)
+          >();
+
+  /// block size of the process_frame_color grid (1..64, default 10)
+  void set_block_size(int block_size) {
+    return _set_block_size(block_size);
+  }
+
+  late final _set_block_sizePtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Int32)>
+  >('set_block_size');
+  late final _set_block_size =
+      _set_block_sizePtr.asFunction<void Function(int)>();
+
+  /// set_block_size for one session
+  void lifi_session_set_block_size(
+    ffi.Pointer<lifi_session> session,
+    int block_size,
+  ) {
+    return _lifi_session_set_block_size(session, block_size);
+  }
+
+  late final _lifi_session_set_block_sizePtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<lifi_session>, ffi.Int32)>
+  >('lifi_session_set_block_size');
+  late final _lifi_session_set_block_size =
+      _lifi_session_set_block_sizePtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_session>, int)
+          >();
+
+  /// process_frame with per-session running min/max; NULL = default
+  void lifi_session_process_frame(
+    ffi.Pointer<lifi_session> session,
+    ffi.Pointer<ffi.Uint8> y_plane,
+    int width,
+    int height,
+    int row_stride,
+    int x0,
+    int y0,
+    int w,
+    int h,
+    ffi.Pointer<ffi.Double> out_values,
+  ) {
+    return _lifi_session_process_frame(
+      session,
+      y_plane,
+      width,
+      height,
+      row_stride,
+      x0,
+      y0,
+      w,
+      h,
+      out_values,
+    );
+  }
+
+  late final _lifi_session_process_framePtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Pointer<ffi.Double>,
+      )
+    >
+  >('lifi_session_process_frame');
+  late final _lifi_session_process_frame =
+      _lifi_session_process_framePtr
+          .asFunction<
+            void Function(
+              ffi.Pointer<lifi_session>,
+              ffi.Pointer<ffi.Uint8>,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              ffi.Pointer<ffi.Double>,
+            )
+          >();
+
+  /// per-stage timing of a session (NULL = default); returns 0 if not compiled in
+  int lifi_get_stage_stats(
+    ffi.Pointer<lifi_session> session,
+    ffi.Pointer<lifi_stage_stats> out,
+  ) {
+    return _lifi_get_stage_stats(session, out);
+  }
+
+  late final _lifi_get_stage_statsPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Pointer<lifi_stage_stats>,
+      )
+    >
+  >('lifi_get_stage_stats');
+  late final _lifi_get_stage_stats =
+      _lifi_get_stage_statsPtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<lifi_session>,
+              ffi.Pointer<lifi_stage_stats>,
+            )
+          >();
+
+  /// clear per-stage timing (NULL = default session)
+  void lifi_reset_stage_stats(ffi.Pointer<lifi_session> session) {
+    return _lifi_reset_stage_stats(session);
+  }
+
+  late final _lifi_reset_stage_statsPtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<lifi_session>)>
+  >('lifi_reset_stage_stats');
+  late final _lifi_reset_stage_stats =
+      _lifi_reset_stage_statsPtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_session>)
+          >();
+
+  /// clock of the sensor timestamps (lifi_clock)
+  void lifi_latency_set_clock(int clock) {
+    return _lifi_latency_set_clock(clock);
+  }
+
+  late final _lifi_latency_set_clockPtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Int32)>
+  >('lifi_latency_set_clock');
+  late final _lifi_latency_set_clock =
+      _lifi_latency_set_clockPtr.asFunction<void Function(int)>();
+
+  /// now on the latency clock, ns
+  int lifi_latency_now() {
+    return _lifi_latency_now();
+  }
+
+  late final _lifi_latency_nowPtr =
+      _lookup<ffi.NativeFunction<ffi.Int64 Function()>>('lifi_latency_now');
+  late final _lifi_latency_now =
+      _lifi_latency_nowPtr.asFunction<int Function()>();
+
+  /// sensor timestamp of the next frame this session decodes (NULL = default, 0 = unknown)
+  void lifi_session_stamp_frame(
+    ffi.Pointer<lifi_session> session,
+    int sensor_timestamp_ns,
+  ) {
+    return _lifi_session_stamp_frame(session, sensor_timestamp_ns);
+  }
+
+  late final _lifi_session_stamp_framePtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<lifi_session>, ffi.Int64)>
+  >('lifi_session_stamp_frame');
+  late final _lifi_session_stamp_frame =
+      _lifi_session_stamp_framePtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_session>, int)
+          >();
+
+  /// the decoder emitted a byte built from frames first_sensor_ns..last_sensor_ns
+  void lifi_session_mark_byte(
+    ffi.Pointer<lifi_session> session,
+    int value,
+    int first_sensor_ns,
+    int last_sensor_ns,
+  ) {
+    return _lifi_session_mark_byte(
+      session,
+      value,
+      first_sensor_ns,
+      last_sensor_ns,
+    );
+  }
+
+  late final _lifi_session_mark_bytePtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Uint8,
+        ffi.Int64,
+        ffi.Int64,
+      )
+    >
+  >('lifi_session_mark_byte');
+  late final _lifi_session_mark_byte =
+      _lifi_session_mark_bytePtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_session>, int, int, int)
+          >();
+
+  /// latency histograms of a session (NULL = default)
+  /// call it on the session's decode thread; elsewhere the copy can be torn
+  void lifi_get_latency_stats(
+    ffi.Pointer<lifi_session> session,
+    ffi.Pointer<lifi_latency_stats> out,
+  ) {
+    return _lifi_get_latency_stats(session, out);
+  }
+
+  late final _lifi_get_latency_statsPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Pointer<lifi_latency_stats>,
+      )
+    >
+  >('lifi_get_latency_stats');
+  late final _lifi_get_latency_stats =
+      _lifi_get_latency_statsPtr
+          .asFunction<
+            void Function(
+              ffi.Pointer<lifi_session>,
+              ffi.Pointer<lifi_latency_stats>,
+            )
+          >();
+
+  /// clear latency histograms (NULL = default session); decode thread only
+  void lifi_reset_latency_stats(ffi.Pointer<lifi_session> session) {
+    return _lifi_reset_latency_stats(session);
+  }
+
+  late final _lifi_reset_latency_statsPtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<lifi_session>)>
+  >('lifi_reset_latency_stats');
+  late final _lifi_reset_latency_stats =
+      _lifi_reset_latency_statsPtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_session>)
+          >();
+
+  /// frame period and processing budget (<= 0 = estimate / same as period; NULL = default)
+  void lifi_session_set_frame_budget(
+    ffi.Pointer<lifi_session> session,
+    int period_ns,
+    int budget_ns,
+  ) {
+    return _lifi_session_set_frame_budget(session, period_ns, budget_ns);
+  }
+
+  late final _lifi_session_set_frame_budgetPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Int64,
+        ffi.Int64,
+      )
+    >
+  >('lifi_session_set_frame_budget');
+  late final _lifi_session_set_frame_budget =
+      _lifi_session_set_frame_budgetPtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_session>, int, int)
+          >();
+
+  /// frames missing right before the last decoded frame (NULL = default)
+  int lifi_session_frames_missed(ffi.Pointer<lifi_session> session) {
+    return _lifi_session_frames_missed(session);
+  }
+
+  late final _lifi_session_frames_missedPtr = _lookup<
+    ffi.NativeFunction<ffi.Int32 Function(ffi.Pointer<lifi_session>)>
+  >('lifi_session_frames_missed');
+  late final _lifi_session_frames_missed =
+      _lifi_session_frames_missedPtr
+          .asFunction<
+            int Function(ffi.Pointer<lifi_session>)
+          >();
+
+  /// frame cadence counters of a session (NULL = default)
+  /// call it on the session's decode thread; elsewhere the copy can be torn
+  void lifi_get_cadence_stats(
+    ffi.Pointer<lifi_session> session,
+    ffi.Pointer<lifi_cadence_stats> out,
+  ) {
+    return _lifi_get_cadence_stats(session, out);
+  }
+
+  late final _lifi_get_cadence_statsPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Pointer<lifi_cadence_stats>,
+      )
+    >
+  >('lifi_get_cadence_stats');
+  late final _lifi_get_cadence_stats =
+      _lifi_get_cadence_statsPtr
+          .asFunction<
+            void Function(
+              ffi.Pointer<lifi_session>,
+              ffi.Pointer<lifi_cadence_stats>,
+            )
+          >();
+
+  /// clear frame cadence counters (NULL = default session); decode thread only
+  void lifi_reset_cadence_stats(ffi.Pointer<lifi_session> session) {
+    return _lifi_reset_cadence_stats(session);
+  }
+
+  late final _lifi_reset_cadence_statsPtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<lifi_session>)>
+  >('lifi_reset_cadence_stats');
+  late final _lifi_reset_cadence_stats =
+      _lifi_reset_cadence_statsPtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_session>)
+          >();
+
+  /// per-frame trace on/off (default on)
+  void lifi_trace_enable(int on) {
+    return _lifi_trace_enable(on);
+  }
+
+  late final _lifi_trace_enablePtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Int32)>
+  >('lifi_trace_enable');
+  late final _lifi_trace_enable =
+      _lifi_trace_enablePtr.asFunction<void Function(int)>();
+
+  /// move up to max_records trace records into out, oldest first
+  int lifi_trace_drain(ffi.Pointer<lifi_trace_record> out, int max_records) {
+    return _lifi_trace_drain(out, max_records);
+  }
+
+  late final _lifi_trace_drainPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<lifi_trace_record>,
+        ffi.Int32,
+      )
+    >
+  >('lifi_trace_drain');
+  late final _lifi_trace_drain =
+      _lifi_trace_drainPtr
+          .asFunction<
+            int Function(ffi.Pointer<lifi_trace_record>, int)
+          >();
+
+  /// trace records overwritten before being drained
+  int lifi_trace_dropped() {
+    return _lifi_trace_dropped();
+  }
+
+  late final _lifi_trace_droppedPtr =
+      _lookup<ffi.NativeFunction<ffi.Uint64 Function()>>('lifi_trace_dropped');
+  late final _lifi_trace_dropped =
+      _lifi_trace_droppedPtr.asFunction<int Function()>();
+
+  /// drain the trace into a binary file (tools/lifi_trace2csv); -1 on error
+  int lifi_trace_dump(ffi.Pointer<ffi.Char> path) {
+    return _lifi_trace_dump(path);
+  }
+
+  late final _lifi_trace_dumpPtr = _lookup<
+    ffi.NativeFunction<ffi.Int32 Function(ffi.Pointer<ffi.Char>)>
+  >('lifi_trace_dump');
+  late final _lifi_trace_dump =
+      _lifi_trace_dumpPtr.asFunction<int Function(ffi.Pointer<ffi.Char>)>();
+
+  /// create a capture file; NULL on error
+  ffi.Pointer<lifi_recorder> lifi_recorder_open(ffi.Pointer<ffi.Char> path) {
+    return _lifi_recorder_open(path);
+  }
+
+  late final _lifi_recorder_openPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Pointer<lifi_recorder> Function(
+        ffi.Pointer<ffi.Char>,
+      )
+    >
+  >('lifi_recorder_open');
+  late final _lifi_recorder_open =
+      _lifi_recorder_openPtr
+          .asFunction<
+            ffi.Pointer<lifi_recorder> Function(ffi.Pointer<ffi.Char>)
+          >();
+
+  /// append one frame; crop_margin < 0 stores full planes, else ROI + margin
+  int lifi_recorder_write(
+    ffi.Pointer<lifi_recorder> rec,
+    ffi.Pointer<ffi.Uint8> y_plane,
+    ffi.Pointer<ffi.Uint8> u_plane,
+    ffi.Pointer<ffi.Uint8> v_plane,
+    int width,
+    int height,
+    int y_row_stride,
+    int uv_row_stride,
+    int uv_pixel_stride,
+    int count,
+    int timestamp_ns,
+    int x0,
+    int y0,
+    int w,
+    int h,
+    int crop_margin,
+  ) {
+    return _lifi_recorder_write(
+      rec,
+      y_plane,
+      u_plane,
+      v_plane,
+      width,
+      height,
+      y_row_stride,
+      uv_row_stride,
+      uv_pixel_stride,
+      count,
+      timestamp_ns,
+      x0,
+      y0,
+      w,
+      h,
+      crop_margin,
+    );
+  }
+
+  late final _lifi_recorder_writePtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<lifi_recorder>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int64,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+      )
+    >
+  >('lifi_recorder_write');
+  late final _lifi_recorder_write =
+      _lifi_recorder_writePtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<lifi_recorder>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Uint8>,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+            )
+          >();
+
+  /// write the index and close; returns frames written or -1
+  int lifi_recorder_close(ffi.Pointer<lifi_recorder> rec) {
+    return _lifi_recorder_close(rec);
+  }
+
+  late final _lifi_recorder_closePtr = _lookup<
+    ffi.NativeFunction<ffi.Int32 Function(ffi.Pointer<lifi_recorder>)>
+  >('lifi_recorder_close');
+  late final _lifi_recorder_close =
+      _lifi_recorder_closePtr
+          .asFunction<
+            int Function(ffi.Pointer<lifi_recorder>)
+          >();
+
+  /// spsc frame queue; policy is a lifi_queue_policy, NULL on bad arguments
+  ffi.Pointer<lifi_frame_queue> lifi_queue_create(
+    int capacity,
+    int max_width,
+    int max_height,
+    int policy,
+    int timeout_ms,
+  ) {
+    return _lifi_queue_create(
+      capacity,
+      max_width,
+      max_height,
+      policy,
+      timeout_ms,
+    );
+  }
+
+  late final _lifi_queue_createPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Pointer<lifi_frame_queue> Function(
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+      )
+    >
+  >('lifi_queue_create');
+  late final _lifi_queue_create =
+      _lifi_queue_createPtr
+          .asFunction<
+            ffi.Pointer<lifi_frame_queue> Function(int, int, int, int, int)
+          >();
+
+  void lifi_queue_destroy(ffi.Pointer<lifi_frame_queue> q) {
+    return _lifi_queue_destroy(q);
+  }
+
+  late final _lifi_queue_destroyPtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<lifi_frame_queue>)>
+  >('lifi_queue_destroy');
+  late final _lifi_queue_destroy =
+      _lifi_queue_destroyPtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_frame_queue>)
+          >();
+
+  /// producer: copy the frame's ROI in; 1 if queued, 0 if dropped
+  int lifi_queue_push(
+    ffi.Pointer<lifi_frame_queue> q,
+    ffi.Pointer<ffi.Uint8> y_plane,
+    ffi.Pointer<ffi.Uint8> u_plane,
+    ffi.Pointer<ffi.Uint8> v_plane,
+    int width,
+    int height,
+    int y_row_stride,
+    int uv_row_stride,
+    int uv_pixel_stride,
+    int count,
+    int timestamp_ns,
+    int x0,
+    int y0,
+    int w,
+    int h,
+  ) {
+    return _lifi_queue_push(
+      q,
+      y_plane,
+      u_plane,
+      v_plane,
+      width,
+      height,
+      y_row_stride,
+      uv_row_stride,
+      uv_pixel_stride,
+      count,
+      timestamp_ns,
+      x0,
+      y0,
+      w,
+      h,
+    );
+  }
+
+  late final _lifi_queue_pushPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<lifi_frame_queue>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int64,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+      )
+    >
+  >('lifi_queue_push');
+  late final _lifi_queue_push =
+      _lifi_queue_pushPtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<lifi_frame_queue>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Uint8>,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+            )
+          >();
+
+  /// producer: reserve a slot for the ROI to copy in yourself; 1 = fill it and commit, 0 = dropped
+  int lifi_queue_claim(
+    ffi.Pointer<lifi_frame_queue> q,
+    int width,
+    int height,
+    int count,
+    int timestamp_ns,
+    int x0,
+    int y0,
+    int w,
+    int h,
+    ffi.Pointer<lifi_queue_slot> out,
+  ) {
+    return _lifi_queue_claim(
+      q,
+      width,
+      height,
+      count,
+      timestamp_ns,
+      x0,
+      y0,
+      w,
+      h,
+      out,
+    );
+  }
+
+  late final _lifi_queue_claimPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<lifi_frame_queue>,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int64,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Pointer<lifi_queue_slot>,
+      )
+    >
+  >('lifi_queue_claim');
+  late final _lifi_queue_claim =
+      _lifi_queue_claimPtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<lifi_frame_queue>,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              ffi.Pointer<lifi_queue_slot>,
+            )
+          >();
+
+  /// queue the slot filled after a successful lifi_queue_claim
+  void lifi_queue_commit(ffi.Pointer<lifi_frame_queue> q) {
+    return _lifi_queue_commit(q);
+  }
+
+  late final _lifi_queue_commitPtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<lifi_frame_queue>)>
+  >('lifi_queue_commit');
+  late final _lifi_queue_commit =
+      _lifi_queue_commitPtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_frame_queue>)
+          >();
+
+  /// consumer: pop and decode one frame (NULL session = default); 1 if a frame was processed
+  int lifi_queue_process(
+    ffi.Pointer<lifi_frame_queue> q,
+    ffi.Pointer<lifi_session> session,
+    ffi.Pointer<ffi.Double> out_values,
+    ffi.Pointer<ffi.Int64> timestamp_ns,
+    ffi.Pointer<ffi.Uint64> seq,
+  ) {
+    return _lifi_queue_process(q, session, out_values, timestamp_ns, seq);
+  }
+
+  late final _lifi_queue_processPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<lifi_frame_queue>,
+        ffi.Pointer<lifi_session>,
+        ffi.Pointer<ffi.Double>,
+        ffi.Pointer<ffi.Int64>,
+        ffi.Pointer<ffi.Uint64>,
+      )
+    >
+  >('lifi_queue_process');
+  late final _lifi_queue_process =
+      _lifi_queue_processPtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<lifi_frame_queue>,
+              ffi.Pointer<lifi_session>,
+              ffi.Pointer<ffi.Double>,
+              ffi.Pointer<ffi.Int64>,
+              ffi.Pointer<ffi.Uint64>,
+            )
+          >();
+
+  /// copy the queue counters
+  void lifi_queue_get_stats(
+    ffi.Pointer<lifi_frame_queue> q,
+    ffi.Pointer<lifi_queue_stats> out,
+  ) {
+    return _lifi_queue_get_stats(q, out);
+  }
+
+  late final _lifi_queue_get_statsPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Void Function(
+        ffi.Pointer<lifi_frame_queue>,
+        ffi.Pointer<lifi_queue_stats>,
+      )
+    >
+  >('lifi_queue_get_stats');
+  late final _lifi_queue_get_stats =
+      _lifi_queue_get_statsPtr
+          .asFunction<
+            void Function(
+              ffi.Pointer<lifi_frame_queue>,
+              ffi.Pointer<lifi_queue_stats>,
+            )
+          >();
+
+  /// resize the decode pool; <= 0 = one thread per big core; returns the size
+  int lifi_pool_set_threads(int threads) {
+    return _lifi_pool_set_threads(threads);
+  }
+
+  late final _lifi_pool_set_threadsPtr = _lookup<
+    ffi.NativeFunction<ffi.Int32 Function(ffi.Int32)>
+  >('lifi_pool_set_threads');
+  late final _lifi_pool_set_threads =
+      _lifi_pool_set_threadsPtr.asFunction<int Function(int)>();
+
+  /// decode pool size, caller included
+  int lifi_pool_threads() {
+    return _lifi_pool_threads();
+  }
+
+  late final _lifi_pool_threadsPtr =
+      _lookup<ffi.NativeFunction<ffi.Int32 Function()>>('lifi_pool_threads');
+  late final _lifi_pool_threads =
+      _lifi_pool_threadsPtr.asFunction<int Function()>();
+
+  /// process_frame_color for n ROIs in parallel; rois = 4 ints, out = 7 doubles each
+  /// NULL session = default, at most one; returns n or LIFI_ERR_ARGUMENT
+  int lifi_process_frame_color_multi(
+    ffi.Pointer<ffi.Pointer<lifi_session>> sessions,
+    int n,
+    ffi.Pointer<ffi.Uint8> y_plane,
+    ffi.Pointer<ffi.Uint8> u_plane,
+    ffi.Pointer<ffi.Uint8> v_plane,
+    int width,
+    int height,
+    int count,
+    int y_row_stride,
+    int uv_row_stride,
+    int uv_pixel_stride,
+    ffi.Pointer<ffi.Int32> rois,
+    ffi.Pointer<ffi.Double> out_values,
+  ) {
+    return _lifi_process_frame_color_multi(
+      sessions,
+      n,
+      y_plane,
+      u_plane,
+      v_plane,
+      width,
+      height,
+      count,
+      y_row_stride,
+      uv_row_stride,
+      uv_pixel_stride,
+      rois,
+      out_values,
+    );
+  }
+
+  late final _lifi_process_frame_color_multiPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<ffi.Pointer<lifi_session>>,
+        ffi.Int32,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Pointer<ffi.Uint8>,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Int32,
+        ffi.Pointer<ffi.Int32>,
+        ffi.Pointer<ffi.Double>,
+      )
+    >
+  >('lifi_process_frame_color_multi');
+  late final _lifi_process_frame_color_multi =
+      _lifi_process_frame_color_multiPtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<ffi.Pointer<lifi_session>>,
+              int,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Uint8>,
+              int,
+              int,
+              int,
+              int,
+              int,
+              int,
+              ffi.Pointer<ffi.Int32>,
+              ffi.Pointer<ffi.Double>,
+            )
+          >();
+
+  /// protocol the plugin was built with
+  void lifi_get_protocol(ffi.Pointer<lifi_protocol> out) {
+    return _lifi_get_protocol(out);
+  }
+
+  late final _lifi_get_protocolPtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<lifi_protocol>)>
+  >('lifi_get_protocol');
+  late final _lifi_get_protocol =
+      _lifi_get_protocolPtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_protocol>)
+          >();
+
+  /// what this build supports
+  void lifi_get_capabilities(ffi.Pointer<lifi_capabilities> out) {
+    return _lifi_get_capabilities(out);
+  }
+
+  late final _lifi_get_capabilitiesPtr = _lookup<
+    ffi.NativeFunction<ffi.Void Function(ffi.Pointer<lifi_capabilities>)>
+  >('lifi_get_capabilities');
+  late final _lifi_get_capabilities =
+      _lifi_get_capabilitiesPtr
+          .asFunction<
+            void Function(ffi.Pointer<lifi_capabilities>)
+          >();
+
+  /// process_frame_color on frame->rois[0]; NULL session = default; 1 or LIFI_ERR_*
+  int lifi_session_decode(
+    ffi.Pointer<lifi_session> session,
+    ffi.Pointer<lifi_frame_desc> frame,
+    ffi.Pointer<lifi_result> out,
+  ) {
+    return _lifi_session_decode(session, frame, out);
+  }
+
+  late final _lifi_session_decodePtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Pointer<lifi_frame_desc>,
+        ffi.Pointer<lifi_result>,
+      )
+    >
+  >('lifi_session_decode');
+  late final _lifi_session_decode =
+      _lifi_session_decodePtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<lifi_session>,
+              ffi.Pointer<lifi_frame_desc>,
+              ffi.Pointer<lifi_result>,
+            )
+          >();
+
+  /// every ROI of a frame on the pool, one session and result each (at most one NULL = default); count or LIFI_ERR_*
+  int lifi_decode(
+    ffi.Pointer<ffi.Pointer<lifi_session>> sessions,
+    ffi.Pointer<lifi_frame_desc> frame,
+    ffi.Pointer<lifi_result> results,
+  ) {
+    return _lifi_decode(sessions, frame, results);
+  }
+
+  late final _lifi_decodePtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<ffi.Pointer<lifi_session>>,
+        ffi.Pointer<lifi_frame_desc>,
+        ffi.Pointer<lifi_result>,
+      )
+    >
+  >('lifi_decode');
+  late final _lifi_decode =
+      _lifi_decodePtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<ffi.Pointer<lifi_session>>,
+              ffi.Pointer<lifi_frame_desc>,
+              ffi.Pointer<lifi_result>,
+            )
+          >();
+
+  /// detect_leds_on on a descriptor of any format; entries written or LIFI_ERR_*
+  int lifi_detect_leds_on(
+    ffi.Pointer<lifi_frame_desc> frame,
+    int threshold,
+    ffi.Pointer<ffi.Uint8> out_on,
+  ) {
+    return _lifi_detect_leds_on(frame, threshold, out_on);
+  }
+
+  late final _lifi_detect_leds_onPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<lifi_frame_desc>,
+        ffi.Uint8,
+        ffi.Pointer<ffi.Uint8>,
+      )
+    >
+  >('lifi_detect_leds_on');
+  late final _lifi_detect_leds_on =
+      _lifi_detect_leds_onPtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<lifi_frame_desc>,
+              int,
+              ffi.Pointer<ffi.Uint8>,
+            )
+          >();
+
+  /// detect_bright_regions on a descriptor of any format; boxes found or LIFI_ERR_*
+  int lifi_detect_bright_regions(
+    ffi.Pointer<lifi_frame_desc> frame,
+    int threshold,
+    int max_regions,
+    ffi.Pointer<ffi.Int32> bbox_out,
+  ) {
+    return _lifi_detect_bright_regions(frame, threshold, max_regions, bbox_out);
+  }
+
+  late final _lifi_detect_bright_regionsPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<lifi_frame_desc>,
+        ffi.Uint8,
+        ffi.Int32,
+        ffi.Pointer<ffi.Int32>,
+      )
+    >
+  >('lifi_detect_bright_regions');
+  late final _lifi_detect_bright_regions =
+      _lifi_detect_bright_regionsPtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<lifi_frame_desc>,
+              int,
+              int,
+              ffi.Pointer<ffi.Int32>,
+            )
+          >();
+
+  /// shared result block of a session (NULL = default); valid until it is destroyed
+  ffi.Pointer<lifi_shared_result> lifi_session_shared_result(
+    ffi.Pointer<lifi_session> session,
+  ) {
+    return _lifi_session_shared_result(session);
+  }
+
+  late final _lifi_session_shared_resultPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Pointer<lifi_shared_result> Function(
+        ffi.Pointer<lifi_session>,
+      )
+    >
+  >('lifi_session_shared_result');
+  late final _lifi_session_shared_result =
+      _lifi_session_shared_resultPtr
+          .asFunction<
+            ffi.Pointer<lifi_shared_result> Function(ffi.Pointer<lifi_session>)
+          >();
+
+  /// consistent copy of the shared result block; 0 if it kept changing
+  int lifi_read_shared_result(
+    ffi.Pointer<lifi_session> session,
+    ffi.Pointer<lifi_shared_result> out,
+  ) {
+    return _lifi_read_shared_result(session, out);
+  }
+
+  late final _lifi_read_shared_resultPtr = _lookup<
+    ffi.NativeFunction<
+      ffi.Int32 Function(
+        ffi.Pointer<lifi_session>,
+        ffi.Pointer<lifi_shared_result>,
+      )
+    >
+  >('lifi_read_shared_result');
+  late final _lifi_read_shared_result =
+      _lifi_read_shared_resultPtr
+          .asFunction<
+            int Function(
+              ffi.Pointer<lifi_session>,
+              ffi.Pointer<lifi_shared_result>,
+            )
+          >();
+}
+
+/// per-stream decoder state
+final class lifi_session extends ffi.Opaque {}
+
+/// stages timed when built with LIFI_STAGE_TIMING
+enum lifi_stage {
+  LIFI_STAGE_ROI_COPY(0),
+  LIFI_STAGE_MEDIAN(1),
+  LIFI_STAGE_DOWNSAMPLE(2),
+  LIFI_STAGE_THRESHOLD(3),
+  LIFI_STAGE_COLOR_HISTOGRAM(4),
+  LIFI_STAGE_CLASSIFY(5),
+  LIFI_STAGE_COUNT(6);
+
+  final int value;
+  const lifi_stage(this.value);
+
+  static lifi_stage fromValue(int value) => switch (value) {
+    0 => LIFI_STAGE_ROI_COPY,
+    1 => LIFI_STAGE_MEDIAN,
+    2 => LIFI_STAGE_DOWNSAMPLE,
+    3 => LIFI_STAGE_THRESHOLD,
+    4 => LIFI_STAGE_COLOR_HISTOGRAM,
+    5 => LIFI_STAGE_CLASSIFY,
+    6 => LIFI_STAGE_COUNT,
+    _ => throw ArgumentError("Unknown value for lifi_stage: $value"),
+  };
+}
+
+/// latency of one stage in ns, one sample per frame
+final class lifi_stage_stat extends ffi.Struct {
+  @ffi.Uint64()
+  external int count;
+
+  @ffi.Uint64()
+  external int total_ns;
+
+  @ffi.Uint64()
+  external int min_ns;
+
+  @ffi.Uint64()
+  external int max_ns;
+
+  @ffi.Uint64()
+  external int p50_ns;
+
+  @ffi.Uint64()
+  external int p99_ns;
+}
+
+/// all stages of one session, indexed by lifi_stage
+final class lifi_stage_stats extends ffi.Struct {
+  @ffi.Int32()
+  external int enabled;
+
+  @ffi.Array.multi([6])
+  external ffi.Array<lifi_stage_stat> stages;
+}
+
+/// stage boundaries of the end-to-end latency histograms
+enum lifi_latency_span {
+  LIFI_LATENCY_SENSOR_TO_ENQUEUE(0),
+  LIFI_LATENCY_QUEUE_WAIT(1),
+  LIFI_LATENCY_PROCESSING(2),
+  LIFI_LATENCY_SENSOR_TO_DECISION(3),
+  LIFI_LATENCY_DECISION_TO_BYTE(4),
+  LIFI_LATENCY_SENSOR_TO_BYTE(5),
+  LIFI_LATENCY_CHARACTER(6),
+  LIFI_LATENCY_COUNT(7);
+
+  final int value;
+  const lifi_latency_span(this.value);
+
+  static lifi_latency_span fromValue(int value) => switch (value) {
+    0 => LIFI_LATENCY_SENSOR_TO_ENQUEUE,
+    1 => LIFI_LATENCY_QUEUE_WAIT,
+    2 => LIFI_LATENCY_PROCESSING,
+    3 => LIFI_LATENCY_SENSOR_TO_DECISION,
+    4 => LIFI_LATENCY_DECISION_TO_BYTE,
+    5 => LIFI_LATENCY_SENSOR_TO_BYTE,
+    6 => LIFI_LATENCY_CHARACTER,
+    7 => LIFI_LATENCY_COUNT,
+    _ => throw ArgumentError("Unknown value for lifi_latency_span: $value"),
+  };
+}
+
+/// latency histograms of one session, indexed by lifi_latency_span
+final class lifi_latency_stats extends ffi.Struct {
+  @ffi.Array.multi([7])
+  external ffi.Array<lifi_stage_stat> spans;
+}
+
+/// clock of the sensor timestamps
+enum lifi_clock {
+  LIFI_CLOCK_MONOTONIC(0),
+  LIFI_CLOCK_BOOTTIME(1);
+
+  final int value;
+  const lifi_clock(this.value);
+
+  static lifi_clock fromValue(int value) => switch (value) {
+    0 => LIFI_CLOCK_MONOTONIC,
+    1 => LIFI_CLOCK_BOOTTIME,
+    _ => throw ArgumentError("Unknown value for lifi_clock: $value"),
+  };
+}
+
+/// one process_frame_color decision (or LIFI_TRACE_BYTE emission) in the trace ring
+final class lifi_trace_record extends ffi.Struct {
+  @ffi.Uint32()
+  external int frame;
+
+  @ffi.Uint32()
+  external int session;
+
+  @ffi.Uint64()
+  external int t_ns;
+
+  @ffi.Int64()
+  external int sensor_ns;
+
+  @ffi.Uint32()
+  external int latency_us;
+
+  @ffi.Uint32()
+  external int wait_us;
+
+  @ffi.Float()
+  external double y;
+
+  @ffi.Float()
+  external double dyn_min;
+
+  @ffi.Float()
+  external double dyn_max;
+
+  @ffi.Uint8()
+  external int led_on;
+
+  @ffi.Uint8()
+  external int encoded;
+
+  @ffi.Uint8()
+  external int color;
+
+  @ffi.Uint8()
+  external int flags;
+}
+
+/// frame spacing, inferred gaps and deadline misses of one session
+final class lifi_cadence_stats extends ffi.Struct {
+  @ffi.Uint64()
+  external int frames;
+
+  @ffi.Uint64()
+  external int gaps;
+
+  @ffi.Uint64()
+  external int missed_frames;
+
+  @ffi.Uint64()
+  external int deadline_misses;
+
+  @ffi.Uint64()
+  external int period_ns;
+
+  @ffi.Uint64()
+  external int budget_ns;
+
+  @ffi.Uint64()
+  external int last_missed;
+
+  external lifi_stage_stat interval;
+
+  external lifi_stage_stat jitter;
+}
+
+/// the optical protocol shared with the firmware (lifi_protocol.h)
+final class lifi_protocol extends ffi.Struct {
+  @ffi.Int32()
+  external int marker_pulses;
+
+  @ffi.Array.multi([16])
+  external ffi.Array<ffi.Uint8> marker;
+
+  @ffi.Array.multi([2])
+  external ffi.Array<ffi.Uint8> bit_color;
+
+  @ffi.Int32()
+  external int slots_per_pulse;
+
+  @ffi.Int32()
+  external int payload_bits;
+
+  @ffi.Int32()
+  external int gap_slots;
+
+  @ffi.Int32()
+  external int slots_per_char;
+
+  @ffi.Int32()
+  external int payload_slots;
+
+  @ffi.Int32()
+  external int default_interval_ms;
+
+  @ffi.Int32()
+  external int min_interval_ms;
+
+  @ffi.Int32()
+  external int frames_per_slot;
+}
+
+/// pixel layouts a lifi_frame_desc can describe
+enum lifi_pixel_format {
+  LIFI_FORMAT_YUV_420_888(0),
+  LIFI_FORMAT_NV21(1),
+  LIFI_FORMAT_NV12(2),
+  LIFI_FORMAT_I420(3);
+
+  final int value;
+  const lifi_pixel_format(this.value);
+
+  static lifi_pixel_format fromValue(int value) => switch (value) {
+    0 => LIFI_FORMAT_YUV_420_888,
+    1 => LIFI_FORMAT_NV21,
+    2 => LIFI_FORMAT_NV12,
+    3 => LIFI_FORMAT_I420,
+    _ => throw ArgumentError("Unknown value for lifi_pixel_format: $value"),
+  };
+}
+
+/// rectangle in frame pixels
+final class lifi_roi extends ffi.Struct {
+  @ffi.Int32()
+  external int x;
+
+  @ffi.Int32()
+  external int y;
+
+  @ffi.Int32()
+  external int w;
+
+  @ffi.Int32()
+  external int h;
+}
+
+/// one camera frame and the ROIs to decode in it; y_row_stride 0 = width in
+/// every format, YUV_420_888 needs both chroma strides
+final class lifi_frame_desc extends ffi.Struct {
+  @ffi.Uint32()
+  external int version;
+
+  @ffi.Int32()
+  external int format;
+
+  external ffi.Pointer<ffi.Uint8> y_plane;
+
+  external ffi.Pointer<ffi.Uint8> u_plane;
+
+  external ffi.Pointer<ffi.Uint8> v_plane;
+
+  @ffi.Int32()
+  external int width;
+
+  @ffi.Int32()
+  external int height;
+
+  @ffi.Int32()
+  external int y_row_stride;
+
+  @ffi.Int32()
+  external int uv_row_stride;
+
+  @ffi.Int32()
+  external int uv_pixel_stride;
+
+  @ffi.Int32()
+  external int count;
+
+  @ffi.Int64()
+  external int timestamp_ns;
+
+  external ffi.Pointer<lifi_roi> rois;
+
+  @ffi.Int32()
+  external int roi_count;
+}
+
+/// per-frame events in lifi_result.events
+enum lifi_event_type {
+  LIFI_EVENT_RESET(1),
+  LIFI_EVENT_LED_ON(2),
+  LIFI_EVENT_LED_OFF(3),
+  LIFI_EVENT_COLOR(4),
+  LIFI_EVENT_GAP(5),
+  LIFI_EVENT_LATE(6);
+
+  final int value;
+  const lifi_event_type(this.value);
+
+  static lifi_event_type fromValue(int value) => switch (value) {
+    1 => LIFI_EVENT_RESET,
+    2 => LIFI_EVENT_LED_ON,
+    3 => LIFI_EVENT_LED_OFF,
+    4 => LIFI_EVENT_COLOR,
+    5 => LIFI_EVENT_GAP,
+    6 => LIFI_EVENT_LATE,
+    _ => throw ArgumentError("Unknown value for lifi_event_type: $value"),
+  };
+}
+
+final class lifi_event extends ffi.Struct {
+  @ffi.Int32()
+  external int type;
+
+  @ffi.Int32()
+  external int value;
+}
+
+/// decision for one ROI of one frame
+final class lifi_result extends ffi.Struct {
+  @ffi.Uint32()
+  external int version;
+
+  @ffi.Uint32()
+  external int frame;
+
+  @ffi.Int64()
+  external int sensor_ns;
+
+  @ffi.Double()
+  external double y;
+
+  @ffi.Double()
+  external double dyn_min;
+
+  @ffi.Double()
+  external double dyn_max;
+
+  @ffi.Double()
+  external double hue;
+
+  @ffi.Double()
+  external double sat;
+
+  @ffi.Double()
+  external double val;
+
+  @ffi.Int32()
+  external int color;
+
+  @ffi.Int32()
+  external int led_on;
+
+  @ffi.Int32()
+  external int encoded;
+
+  @ffi.Int32()
+  external int flags;
+
+  @ffi.Uint32()
+  external int latency_us;
+
+  @ffi.Int32()
+  external int event_count;
+
+  @ffi.Array.multi([8])
+  external ffi.Array<lifi_event> events;
+}
+
+/// what this build of the library supports
+final class lifi_capabilities extends ffi.Struct {
+  @ffi.Uint32()
+  external int abi_version;
+
+  @ffi.Uint32()
+  external int formats;
+
+  @ffi.Uint32()
+  external int features;
+
+  @ffi.Int32()
+  external int max_events;
+
+  @ffi.Int32()
+  external int pool_threads;
+}
+
+/// latest decision of a session, seqlock-published for lock-free readers
+final class lifi_shared_result extends ffi.Struct {
+  @ffi.Uint64()
+  external int seq;
+
+  @ffi.Uint32()
+  external int frame;
+
+  @ffi.Uint32()
+  external int edge_frame;
+
+  @ffi.Int64()
+  external int sensor_ns;
+
+  @ffi.Uint64()
+  external int t_ns;
+
+  @ffi.Double()
+  external double y;
+
+  @ffi.Double()
+  external double dyn_min;
+
+  @ffi.Double()
+  external double dyn_max;
+
+  @ffi.Double()
+  external double hue;
+
+  @ffi.Double()
+  external double sat;
+
+  @ffi.Double()
+  external double val;
+
+  @ffi.Int32()
+  external int color;
+
+  @ffi.Int32()
+  external int led_on;
+
+  @ffi.Int32()
+  external int encoded;
+
+  @ffi.Int32()
+  external int flags;
+
+  @ffi.Int32()
+  external int frames_missed;
+
+  @ffi.Uint32()
+  external int latency_us;
+}
+
+/// frame recorder writing a .lfc capture
+final class lifi_recorder extends ffi.Opaque {}
+
+/// bounded camera-to-decoder frame queue
+final class lifi_frame_queue extends ffi.Opaque {}
+
+/// what lifi_queue_push does when the queue is full
+enum lifi_queue_policy {
+  LIFI_QUEUE_DROP_OLDEST(0),
+  LIFI_QUEUE_DROP_NEWEST(1),
+  LIFI_QUEUE_BLOCK(2);
+
+  final int value;
+  const lifi_queue_policy(this.value);
+
+  static lifi_queue_policy fromValue(int value) => switch (value) {
+    0 => LIFI_QUEUE_DROP_OLDEST,
+    1 => LIFI_QUEUE_DROP_NEWEST,
+    2 => LIFI_QUEUE_BLOCK,
+    _ => throw ArgumentError("Unknown value for lifi_queue_policy: $value"),
+  };
+}
+
+/// slot from lifi_queue_claim: planar crop at (x0, y0), chroma stride (width + 1) / 2
+final class lifi_queue_slot extends ffi.Struct {
+  external ffi.Pointer<ffi.Uint8> y;
+
+  external ffi.Pointer<ffi.Uint8> u;
+
+  external ffi.Pointer<ffi.Uint8> v;
+
+  @ffi.Int32()
+  external int x0;
+
+  @ffi.Int32()
+  external int y0;
+
+  @ffi.Int32()
+  external int width;
+
+  @ffi.Int32()
+  external int height;
+}
+
+/// frame queue counters since creation
+final class lifi_queue_stats extends ffi.Struct {
+  @ffi.Uint64()
+  external int enqueued;
+
+  @ffi.Uint64()
+  external int dequeued;
+
+  @ffi.Uint64()
+  external int dropped_oldest;
+
+  @ffi.Uint64()
+  external int dropped_newest;
+
+  @ffi.Uint64()
+  external int timeouts;
+
+  @ffi.Uint32()
+  external int depth;
+
+  @ffi.Uint32()
+  external int max_depth;
 }
 
 const int _VCRT_COMPILER_PREPROCESSOR = 1;
@@ -525,3 +2426,27 @@ const int WCHAR_MAX = 65535;
 const int WINT_MIN = 0;
 
 const int WINT_MAX = 65535;
+
+const int LIFI_TRACE_RESET = 1;
+
+const int LIFI_TRACE_AMBIENT_RING = 2;
+
+const int LIFI_TRACE_BYTE = 4;
+
+const int LIFI_TRACE_GAP = 8;
+
+const int LIFI_TRACE_LATE = 16;
+
+const int LIFI_ABI_VERSION = 1;
+
+const int LIFI_MAX_EVENTS = 8;
+
+const int LIFI_ERR_ARGUMENT = -1;
+
+const int LIFI_ERR_VERSION = -2;
+
+const int LIFI_ERR_FORMAT = -3;
+
+const int LIFI_FEATURE_OPENCV = 1;
+
+const int LIFI_FEATURE_STAGE_TIMING = 2;
@@ -1,4 +1,6 @@
 // c_plugin.h
+#ifndef C_PLUGIN_H
+#define C_PLUGIN_H
 
 #include <stdint.h>
 #include <stdio.h>
@@ -21,6 +23,295 @@
 extern "C" {
 #endif
 
+/// Per-stream decoder state (history, filters and ROI buffers).
+typedef struct lifi_session lifi_session;
+
+/// Frame recorder writing a .lfc capture (see capture_file.h).
+typedef struct lifi_recorder lifi_recorder;
+
+/// Bounded camera-to-decoder frame queue (see frame_queue.h).
+typedef struct lifi_frame_queue lifi_frame_queue;
+
+/// What lifi_queue_push does with a frame when the queue is full.
+typedef enum {
+    LIFI_QUEUE_DROP_OLDEST = 0,   // replace the oldest waiting frame
+    LIFI_QUEUE_DROP_NEWEST,       // discard the new frame
+    LIFI_QUEUE_BLOCK              // wait up to timeout_ms, then discard it
+} lifi_queue_policy;
+
+/**
+ * A queue slot claimed by lifi_queue_claim: the crop of the camera frame at
+ * (x0, y0) to copy in, as planar Y (stride width) and U, V (stride
+ * (width + 1) / 2, one sample per 2x2 block).
+ */
+typedef struct {
+    uint8_t* y;
+    uint8_t* u;
+    uint8_t* v;
+    int32_t x0, y0;
+    int32_t width, height;
+} lifi_queue_slot;
+
+/// Frame queue counters since creation.
+typedef struct {
+    uint64_t enqueued;
+    uint64_t dequeued;
+    uint64_t dropped_oldest;
+    uint64_t dropped_newest;   // includes block timeouts
+    uint64_t timeouts;
+    uint32_t depth;            // frames waiting now
+    uint32_t max_depth;
+} lifi_queue_stats;
+
+/// Pipeline stages timed when built with LIFI_STAGE_TIMING.
+typedef enum {
+    LIFI_STAGE_ROI_COPY = 0,
+    LIFI_STAGE_MEDIAN,
+    LIFI_STAGE_DOWNSAMPLE,
+    LIFI_STAGE_THRESHOLD,
+    LIFI_STAGE_COLOR_HISTOGRAM,
+    LIFI_STAGE_CLASSIFY,
+    LIFI_STAGE_COUNT
+} lifi_stage;
+
+/// Latency of one stage, one sample per frame, in nanoseconds.
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+} lifi_stage_stat;
+
+/// All stages of one session, indexed by lifi_stage.
+typedef struct {
+    int32_t enabled;   // 0 if the library was built without LIFI_STAGE_TIMING
+    lifi_stage_stat stages[LIFI_STAGE_COUNT];
+} lifi_stage_stats;
+
+/// Stage boundaries of the end-to-end latency histograms.
+typedef enum {
+    LIFI_LATENCY_SENSOR_TO_ENQUEUE = 0,  // exposure -> lifi_queue_push
+    LIFI_LATENCY_QUEUE_WAIT,             // lifi_queue_push -> processing starts
+    LIFI_LATENCY_PROCESSING,             // processing starts -> symbol decision
+    LIFI_LATENCY_SENSOR_TO_DECISION,     // exposure -> symbol decision
+    LIFI_LATENCY_DECISION_TO_BYTE,       // last symbol decision -> byte emitted
+    LIFI_LATENCY_SENSOR_TO_BYTE,         // exposure of the byte's last frame -> byte emitted
+    LIFI_LATENCY_CHARACTER,              // exposure of the byte's first frame -> byte emitted
+    LIFI_LATENCY_COUNT
+} lifi_latency_span;
+
+/// Latency histograms of one session, indexed by lifi_latency_span.
+typedef struct {
+    lifi_stage_stat spans[LIFI_LATENCY_COUNT];
+} lifi_latency_stats;
+
+/// Clocks a sensor timestamp can be on (SENSOR_INFO_TIMESTAMP_SOURCE).
+typedef enum {
+    LIFI_CLOCK_MONOTONIC = 0,   // TIMESTAMP_SOURCE_UNKNOWN
+    LIFI_CLOCK_BOOTTIME,        // TIMESTAMP_SOURCE_REALTIME (elapsedRealtimeNanos)
+} lifi_clock;
+
+/**
+ * One process_frame_color decision, or with LIFI_TRACE_BYTE one byte handed
+ * to lifi_session_mark_byte, in the trace ring (48 bytes). Latencies are 0
+ * when the frame had no sensor timestamp.
+ */
+typedef struct {
+    uint32_t frame;         // frames processed by the session so far (bytes for LIFI_TRACE_BYTE)
+    uint32_t session;       // 0 = default session, else creation order
+    uint64_t t_ns;          // CLOCK_MONOTONIC
+    int64_t  sensor_ns;     // sensor timestamp (of the byte's last frame), 0 if unknown
+    uint32_t latency_us;    // sensor -> decision (-> byte emitted)
+    uint32_t wait_us;       // queued -> processing starts (last decision -> byte)
+    float    y;             // filtered brightness
+    float    dyn_min;       // dynamic threshold window
+    float    dyn_max;
+    uint8_t  led_on;
+    uint8_t  encoded;       // 5-frame on/off bitmask (the byte for LIFI_TRACE_BYTE)
+    uint8_t  color;         // classify_hsv_color code
+    uint8_t  flags;         // LIFI_TRACE_*
+} lifi_trace_record;
+
+#define LIFI_TRACE_RESET        1   // history was reset on this frame (count == 0)
+#define LIFI_TRACE_AMBIENT_RING 2   // Y was measured inside the background ring
+#define LIFI_TRACE_BYTE         4   // a byte emission, not a frame
+#define LIFI_TRACE_GAP          8   // frames were missing before this one
+#define LIFI_TRACE_LATE        16   // processing overran the frame budget
+
+/**
+ * Frame cadence of one session: spacing of the frames as they arrive,
+ * frames inferred missing from that spacing, and frames whose processing
+ * took longer than the frame budget.
+ */
+typedef struct {
+    uint64_t frames;            // frames seen
+    uint64_t gaps;              // intervals with frames missing
+    uint64_t missed_frames;     // frames inferred missing, all gaps
+    uint64_t deadline_misses;   // frames processed in more than budget_ns
+    uint64_t period_ns;         // frame period, set or estimated (0 = not yet known)
+    uint64_t budget_ns;         // processing budget per frame
+    uint64_t last_missed;       // frames missing right before the last frame
+    lifi_stage_stat interval;   // time between frames, gaps included
+    lifi_stage_stat jitter;     // |interval - period| of intervals without a gap
+} lifi_cadence_stats;
+
+/**
+ * The optical protocol the plugin was built with (lifi_protocol.h, shared
+ * with the ESP32 firmware). Colours are slot colours: 0 off, 1 red, 2 blue,
+ * 3 green. Slot positions count voted slots as in lifiMarkerBack and
+ * lifiBitSlot.
+ */
+typedef struct {
+    int32_t marker_pulses;
+    uint8_t marker[16];             // colour of each marker pulse, in transmit order
+    uint8_t bit_color[2];           // pulse colour of a 0 bit and a 1 bit
+    int32_t slots_per_pulse;        // one lit slot, the rest dark
+    int32_t payload_bits;           // bits per character, MSB first
+    int32_t gap_slots;              // dark slots after the last bit's pulse
+    int32_t slots_per_char;
+    int32_t payload_slots;          // slots after the marker until a character is complete
+    int32_t default_interval_ms;
+    int32_t min_interval_ms;
+    int32_t frames_per_slot;        // camera frames voted into one slot
+} lifi_protocol;
+
+/**
+ * Version of the struct ABI below (lifi_frame_desc, lifi_result,
+ * lifi_capabilities). Callers put the version they were built against in
+ * lifi_frame_desc.version; a library that does not know it refuses the call
+ * instead of misreading the structs.
+ */
+#define LIFI_ABI_VERSION 1
+
+/**
+ * Pixel layouts a lifi_frame_desc can describe.
+ *
+ * The packed formats are one buffer at y_plane: `height` rows of Y every
+ * y_row_stride bytes (0 = width), then the chroma; u_plane, v_plane and
+ * uv_pixel_stride are ignored and uv_row_stride may be 0 for the usual
+ * tight value.
+ */
+typedef enum {
+    LIFI_FORMAT_YUV_420_888 = 0,   // Y, U and V planes with the strides in the descriptor
+    LIFI_FORMAT_NV21,              // packed: interleaved V,U rows (uv_row_stride 0 = y_row_stride)
+    LIFI_FORMAT_NV12,              // packed: interleaved U,V rows (uv_row_stride 0 = y_row_stride)
+    LIFI_FORMAT_I420,              // packed: U plane then V plane (uv_row_stride 0 = half y_row_stride)
+} lifi_pixel_format;
+
+/// A rectangle in frame pixels.
+typedef struct {
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+} lifi_roi;
+
+/**
+ * One camera frame and the ROIs to decode in it. The planes are only read
+ * during the call.
+ */
+typedef struct {
+    uint32_t version;               // LIFI_ABI_VERSION
+    int32_t  format;                // lifi_pixel_format
+    const uint8_t* y_plane;
+    const uint8_t* u_plane;
+    const uint8_t* v_plane;
+    int32_t  width;
+    int32_t  height;
+    int32_t  y_row_stride;          // 0 = width, in every format
+    int32_t  uv_row_stride;         // YUV_420_888: required
+    int32_t  uv_pixel_stride;       // YUV_420_888: required
+    int32_t  count;                 // frames since the stream started; 0 resets the history
+    int64_t  timestamp_ns;          // sensor timestamp on the latency clock, 0 = unknown
+    const lifi_roi* rois;           // roi_count ROIs; none = the whole frame
+    int32_t  roi_count;
+} lifi_frame_desc;
+
+/// Per-frame events carried in lifi_result.events.
+typedef enum {
+    LIFI_EVENT_RESET = 1,           // history cleared (count == 0)
+    LIFI_EVENT_LED_ON,              // the LED turned on
+    LIFI_EVENT_LED_OFF,             // the LED turned off
+    LIFI_EVENT_COLOR,               // colour class changed; value = new classify_hsv_color code
+    LIFI_EVENT_GAP,                 // value = frames missing right before this one
+    LIFI_EVENT_LATE,                // processing overran the frame budget
+} lifi_event_type;
+
+#define LIFI_MAX_EVENTS 8
+
+typedef struct {
+    int32_t type;                   // lifi_event_type
+    int32_t value;
+} lifi_event;
+
+/// The decision for one ROI of one frame.
+typedef struct {
+    uint32_t version;               // LIFI_ABI_VERSION of the library
+    uint32_t frame;                 // frames the session had decoded before this one
+    int64_t  sensor_ns;             // sensor timestamp of the frame, 0 if unknown
+    double   y;                     // filtered brightness
+    double   dyn_min;               // dynamic threshold window
+    double   dyn_max;
+    double   hue;                   // degrees
+    double   sat;
+    double   val;
+    int32_t  color;                 // classify_hsv_color code
+    int32_t  led_on;
+    int32_t  encoded;               // 5-frame on/off bitmask
+    int32_t  flags;                 // LIFI_TRACE_*
+    uint32_t latency_us;            // sensor -> decision, 0 if unknown
+    int32_t  event_count;
+    lifi_event events[LIFI_MAX_EVENTS];
+} lifi_result;
+
+/// lifi_decode / lifi_session_decode failures.
+#define LIFI_ERR_ARGUMENT -1        // NULL frame, planes, results or session array, bad size or stride
+#define LIFI_ERR_VERSION  -2        // lifi_frame_desc.version is not one this library knows
+#define LIFI_ERR_FORMAT   -3        // pixel format not supported
+
+/// What this build of the library supports.
+typedef struct {
+    uint32_t abi_version;           // LIFI_ABI_VERSION
+    uint32_t formats;               // bit (1 << f) for each supported lifi_pixel_format f
+    uint32_t features;              // LIFI_FEATURE_*
+    int32_t  max_events;            // LIFI_MAX_EVENTS
+    int32_t  pool_threads;          // decode pool size, caller included
+} lifi_capabilities;
+
+#define LIFI_FEATURE_OPENCV       1 // detect_bright_regions / lifi_detect_bright_regions are available
+#define LIFI_FEATURE_STAGE_TIMING 2 // built with LIFI_STAGE_TIMING
+
+/**
+ * Latest decision of a session, published after every frame into a block
+ * that stays at the same address for the session's lifetime. Readers copy
+ * it in place, without a call or a lock: read seq with acquire, copy the
+ * fields, fence (acquire), read seq again, and keep the copy only if both
+ * reads gave the same even value. Readers that cannot order their loads
+ * (Dart FFI) use lifi_read_shared_result instead. The decode thread never
+ * waits for readers.
+ */
+typedef struct {
+    uint64_t seq;                   // odd while the decode thread is writing
+    uint32_t frame;                 // frames the session had decoded before this one
+    uint32_t edge_frame;            // frame of the last LED on/off change
+    int64_t  sensor_ns;             // sensor timestamp of the frame, 0 if unknown
+    uint64_t t_ns;                  // CLOCK_MONOTONIC time of the decision
+    double   y;                     // filtered brightness
+    double   dyn_min;               // dynamic threshold window
+    double   dyn_max;
+    double   hue;
+    double   sat;
+    double   val;
+    int32_t  color;                 // classify_hsv_color code
+    int32_t  led_on;
+    int32_t  encoded;               // 5-frame on/off bitmask
+    int32_t  flags;                 // LIFI_TRACE_*
+    int32_t  frames_missed;         // frames missing right before this one
+    uint32_t latency_us;            // sensor -> decision, 0 if unknown
+} lifi_shared_result;
+
 /// A very short-lived native function.
 FFI_PLUGIN_EXPORT int sum(int a, int b);
 
@@ -82,7 +373,7 @@ void process_frame_color(
         int32_t y0,
         int32_t w,
         int32_t h,
-        double* out_values   // length = 5: [Ycurr, Ymin, Ymax, hue, sat]
+        double* out_values   // length = 7: [Y, dynMin, dynMax, hue, sat, colorCode, encoded]
 );
 void yuvpixel_to_hsv_c(
         uint8_t y_val,
@@ -111,6 +402,438 @@ void detect_frame_color_precise(
 
 int classify_hsv_color(double hue, double sat, double val);
 
+/**
+ * Configure ambient-light and mains-flicker rejection for process_frame_color.
+ * @param background_ring width (in downsampled blocks) of the ROI border ring
+ *                        used as the background reference; 0 disables subtraction.
+ * @param filter_type     0 = none, 1 = high-pass, 2 = notch on the per-frame luma series.
+ * @param fps             camera frame rate the luma series is sampled at.
+ * @param freq_hz         high-pass cutoff, or mains flicker frequency (100/120) for the notch.
+ * @param q               filter quality factor (0.707 for a Butterworth high-pass).
+ */
+void set_ambient_rejection(
+        int32_t background_ring,
+        int32_t filter_type,
+        double fps,
+        double freq_hz,
+        double q
+);
+
+/**
+ * Select how process_frame_color turns the block grid into one Y value.
+ * @param mode             0 = plain block mean, 1 = blocks weighted by their
+ *                         max-min change over the last 3 frames.
+ * @param change_threshold blocks changing by this much or less get no weight.
+ */
+void set_luma_estimator(int32_t mode, int32_t change_threshold);
+
+/**
+ * Set the block size (pixels per side, 1..64, default 10) of the grid
+ * process_frame_color downsamples the ROI into. Clears the grid history.
+ */
+void set_block_size(int32_t block_size);
+
+/**
+ * Poll several LEDs at once. rois holds roi_count [x, y, w, h] quads; one
+ * count table is built over their bounding box and each LED costs 4 loads.
+ * out_on[i] is 1 if LED i is ON (>5% of its pixels above threshold).
+ */
+void detect_leds_on(
+        const uint8_t* nv21_data,
+        int width,
+        int height,
+        uint8_t threshold,
+        const int* rois,
+        int roi_count,
+        uint8_t* out_on
+);
+
+/**
+ * Build this frame's integral image of the Y plane over (x, y, w, h).
+ * When count_threshold >= 0 a second table counting pixels above it is built.
+ * The tables belong to the calling thread: lifi_integral_mean and
+ * lifi_integral_fraction_above read the last table built on the same
+ * thread, so other threads can build their own at the same time.
+ * @returns 1 if the clamped region is non-empty.
+ */
+int32_t lifi_integral_build(
+        const uint8_t* y_plane,
+        int32_t width,
+        int32_t height,
+        int32_t row_stride,
+        int32_t x,
+        int32_t y,
+        int32_t w,
+        int32_t h,
+        int32_t count_threshold
+);
+
+/// Mean Y over a frame-space rectangle, clipped to the built region.
+double lifi_integral_mean(int32_t x, int32_t y, int32_t w, int32_t h);
+
+/// Fraction of pixels above count_threshold over a frame-space rectangle.
+double lifi_integral_fraction_above(int32_t x, int32_t y, int32_t w, int32_t h);
+
+/**
+ * Create a decoder session whose buffers are sized once for frames up to
+ * max_width x max_height. Any ROI inside such a frame can be processed
+ * without further allocation. Free with lifi_session_destroy().
+ */
+lifi_session* lifi_session_create(int32_t max_width, int32_t max_height);
+
+void lifi_session_destroy(lifi_session* session);
+
+/// process_frame_color() on an explicit session instead of the default one
+/// (NULL = the default one).
+void lifi_session_process_frame_color(
+        lifi_session* session,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t count,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        double* out_values   // length = 7
+);
+
+/// set_ambient_rejection() for one session.
+void lifi_session_set_ambient_rejection(
+        lifi_session* session,
+        int32_t background_ring,
+        int32_t filter_type,
+        double fps,
+        double freq_hz,
+        double q
+);
+
+/// set_luma_estimator() for one session.
+void lifi_session_set_luma_estimator(lifi_session* session, int32_t mode, int32_t change_threshold);
+
+/// set_block_size() for one session.
+void lifi_session_set_block_size(lifi_session* session, int32_t block_size);
+
+/**
+ * process_frame() on a session: the running min/max in out_values[1..2]
+ * belong to this session instead of the whole process (NULL = the default
+ * session, as process_frame()).
+ */
+void lifi_session_process_frame(
+        lifi_session* session,
+        const uint8_t* y_plane,
+        int32_t width,
+        int32_t height,
+        int32_t row_stride,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        double* out_values   // length = 3
+);
+
+/**
+ * Copy the per-stage timing counters of a session (NULL = the session used
+ * by process_frame_color). Returns 1 if timing is compiled in, else 0 and
+ * all counters are zero.
+ */
+int32_t lifi_get_stage_stats(const lifi_session* session, lifi_stage_stats* out);
+
+/// Clear the per-stage timing counters (NULL = default session).
+void lifi_reset_stage_stats(lifi_session* session);
+
+/**
+ * Clock the sensor timestamps passed to lifi_session_stamp_frame and
+ * lifi_queue_push are on (lifi_clock, default LIFI_CLOCK_MONOTONIC). All
+ * latencies are measured on it. Where the platform has no CLOCK_BOOTTIME
+ * (macOS host builds) LIFI_CLOCK_BOOTTIME falls back to monotonic.
+ */
+void lifi_latency_set_clock(int32_t clock);
+
+/// Current time on the latency clock, in nanoseconds.
+int64_t lifi_latency_now(void);
+
+/**
+ * Give the sensor timestamp of the frame the next process_frame_color call
+ * on this session (NULL = default session) will decode. 0 = unknown.
+ * lifi_queue_process stamps its frames itself.
+ */
+void lifi_session_stamp_frame(lifi_session* session, int64_t sensor_timestamp_ns);
+
+/**
+ * Report that the decoder above the native layer emitted a byte. The
+ * sensor timestamps of the first and last frame that went into it give the
+ * character and sensor-to-byte latencies; the time since the session's last
+ * decision gives the decoder's own share. Call it from the thread that
+ * decodes the session's frames.
+ */
+void lifi_session_mark_byte(
+        lifi_session* session,
+        uint8_t value,
+        int64_t first_sensor_ns,
+        int64_t last_sensor_ns
+);
+
+/**
+ * Copy the latency histograms of a session (NULL = default session). The
+ * decode thread updates them without locking, so call this, like
+ * lifi_reset_latency_stats, from the thread that decodes the session's
+ * frames; from any other thread the copy can be torn.
+ */
+void lifi_get_latency_stats(const lifi_session* session, lifi_latency_stats* out);
+
+/// Clear the latency histograms (NULL = default session); decode thread only.
+void lifi_reset_latency_stats(lifi_session* session);
+
+/**
+ * Frame period and processing budget of a session (NULL = default session).
+ * period_ns <= 0 estimates the period from recent frame intervals;
+ * budget_ns <= 0 makes the budget equal to the period.
+ */
+void lifi_session_set_frame_budget(lifi_session* session, int64_t period_ns, int64_t budget_ns);
+
+/**
+ * Frames missing right before the last frame this session decoded (NULL =
+ * default session), inferred from the sensor timestamps, or from the call
+ * times when frames are not stamped. A decoder grouping frames into symbols
+ * skips this many slots to stay aligned.
+ */
+int32_t lifi_session_frames_missed(const lifi_session* session);
+
+/**
+ * Copy the frame cadence counters of a session (NULL = default session).
+ * Like the latency histograms they are updated without locking: call this
+ * and lifi_reset_cadence_stats from the thread that decodes the session's
+ * frames.
+ */
+void lifi_get_cadence_stats(const lifi_session* session, lifi_cadence_stats* out);
+
+/// Clear the frame cadence counters (NULL = default session); decode thread only.
+void lifi_reset_cadence_stats(lifi_session* session);
+
+/// Turn the per-frame trace on or off (on by default).
+void lifi_trace_enable(int32_t on);
+
+/**
+ * Move up to max_records trace records, oldest first, into out. Returns how
+ * many were copied. Call from a background thread; recording never waits.
+ */
+int32_t lifi_trace_drain(lifi_trace_record* out, int32_t max_records);
+
+/// Records overwritten before they were drained.
+uint64_t lifi_trace_dropped(void);
+
+/**
+ * Drain the trace into a binary file for tools/lifi_trace2csv. Returns the
+ * number of records written, or -1 on I/O error.
+ */
+int32_t lifi_trace_dump(const char* path);
+
+/// Create a capture file at path. Returns NULL if it cannot be created.
+lifi_recorder* lifi_recorder_open(const char* path);
+
+/**
+ * Append one YUV_420_888 frame with its timestamp, the count passed to
+ * process_frame_color and the ROI. crop_margin < 0 stores the full planes;
+ * otherwise only the ROI grown by crop_margin pixels. Returns 1 on success.
+ */
+int32_t lifi_recorder_write(
+        lifi_recorder* rec,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        int32_t count,
+        int64_t timestamp_ns,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        int32_t crop_margin
+);
+
+/// Write the index and close. Returns the number of frames, -1 on I/O error.
+int32_t lifi_recorder_close(lifi_recorder* rec);
+
+/**
+ * Create a single-producer/single-consumer frame queue holding up to
+ * capacity frames of at most max_width x max_height (the ROI is all that is
+ * copied). policy is a lifi_queue_policy; timeout_ms applies to
+ * LIFI_QUEUE_BLOCK. Returns NULL on bad arguments.
+ */
+lifi_frame_queue* lifi_queue_create(
+        int32_t capacity,
+        int32_t max_width,
+        int32_t max_height,
+        int32_t policy,
+        int32_t timeout_ms
+);
+
+void lifi_queue_destroy(lifi_frame_queue* q);
+
+/**
+ * Producer side: copy the ROI of one YUV_420_888 frame into the queue.
+ * Returns 1 if queued, 0 if this frame was dropped. Never takes a lock;
+ * only LIFI_QUEUE_BLOCK waits, and then for the consumer to make room.
+ * timestamp_ns is the sensor timestamp on the latency clock; 0 stamps the
+ * frame with the time it was queued.
+ */
+int32_t lifi_queue_push(
+        lifi_frame_queue* q,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        int32_t count,
+        int64_t timestamp_ns,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h
+);
+
+/**
+ * Producer side without lifi_queue_push's copy, for callers whose planes
+ * are not in native memory: reserve a slot for the ROI of a width x height
+ * frame and describe it in *out. Returns 1 with a slot to fill, then
+ * lifi_queue_commit must be called before the next claim; 0 if this frame
+ * was dropped (nothing to commit). Same policies as lifi_queue_push.
+ */
+int32_t lifi_queue_claim(
+        lifi_frame_queue* q,
+        int32_t width,
+        int32_t height,
+        int32_t count,
+        int64_t timestamp_ns,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        lifi_queue_slot* out
+);
+
+/// Queue the slot filled after lifi_queue_claim returned 1.
+void lifi_queue_commit(lifi_frame_queue* q);
+
+/**
+ * Consumer side: pop the oldest frame and run process_frame_color on it
+ * with session (NULL = default session). Returns 1 and fills out_values
+ * (length = 7), plus the frame's timestamp and sequence number if the
+ * pointers are not NULL; a jump in seq means frames were dropped in
+ * between. Returns 0 if empty.
+ */
+int32_t lifi_queue_process(
+        lifi_frame_queue* q,
+        lifi_session* session,
+        double* out_values,
+        int64_t* timestamp_ns,
+        uint64_t* seq
+);
+
+/// Copy the queue counters; safe from any thread.
+void lifi_queue_get_stats(const lifi_frame_queue* q, lifi_queue_stats* out);
+
+/**
+ * Resize the decode thread pool used by lifi_process_frame_color_multi.
+ * threads <= 0 sizes it to the big cores. Returns the new size, the calling
+ * thread included.
+ */
+int32_t lifi_pool_set_threads(int32_t threads);
+
+/// Threads used by lifi_process_frame_color_multi, the caller included.
+int32_t lifi_pool_threads(void);
+
+/**
+ * process_frame_color for n ROIs (or transmitters) of the same frame, in
+ * parallel on the pool. ROI i is rois[4*i .. 4*i+3] = x0, y0, w, h and is
+ * decoded with sessions[i] (NULL = default session); its results go to
+ * out_values[7*i .. 7*i+6]. Sessions must be distinct, so at most one may
+ * be NULL. Returns n once every ROI is done, or LIFI_ERR_ARGUMENT.
+ */
+int32_t lifi_process_frame_color_multi(
+        lifi_session* const* sessions,
+        int32_t n,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t count,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        const int32_t* rois,
+        double* out_values
+);
+
+/// Copy the protocol the plugin was built with.
+void lifi_get_protocol(lifi_protocol* out);
+
+/// Fill out with what this build of the library supports.
+void lifi_get_capabilities(lifi_capabilities* out);
+
+/**
+ * process_frame_color on a frame descriptor: decodes frame->rois[0] (the
+ * whole frame if there are none) with session (NULL = default session)
+ * into out, after stamping the session with frame->timestamp_ns if it is
+ * set. Returns 1, or a negative LIFI_ERR_*.
+ */
+int32_t lifi_session_decode(lifi_session* session, const lifi_frame_desc* frame, lifi_result* out);
+
+/**
+ * Decode every ROI of a frame in parallel on the pool: frame->rois[i] with
+ * sessions[i] into results[i]. Sessions must be distinct; NULL is the
+ * default session, as in lifi_session_decode, so at most one entry may be
+ * NULL. Returns the number of results written, or a negative LIFI_ERR_*.
+ */
+int32_t lifi_decode(lifi_session* const* sessions, const lifi_frame_desc* frame, lifi_result* results);
+
+/**
+ * detect_leds_on on a frame descriptor of any lifi_pixel_format, padded
+ * rows included: out_on[i] for frame->rois[i], or out_on[0] for the whole
+ * frame if there are none. Returns the number of entries written, or a
+ * negative LIFI_ERR_*.
+ */
+int32_t lifi_detect_leds_on(const lifi_frame_desc* frame, uint8_t threshold, uint8_t* out_on);
+
+/**
+ * detect_bright_regions on a frame descriptor of any lifi_pixel_format:
+ * up to max_regions boxes as (x, y, w, h) in bbox_out, largest first.
+ * Returns the number found, or a negative LIFI_ERR_*. Needs
+ * LIFI_FEATURE_OPENCV.
+ */
+int32_t lifi_detect_bright_regions(
+        const lifi_frame_desc* frame,
+        uint8_t threshold,
+        int32_t max_regions,
+        int32_t* bbox_out
+);
+
+/**
+ * The shared result block of a session (NULL = default session). Valid
+ * until the session is destroyed; the default session's for the process.
+ */
+const lifi_shared_result* lifi_session_shared_result(const lifi_session* session);
+
+/**
+ * Seqlock read of the shared result block into out, for C callers (NULL =
+ * default session). Returns 1, or 0 if the decode thread kept rewriting it.
+ */
+int32_t lifi_read_shared_result(const lifi_session* session, lifi_shared_result* out);
+
 //typedef struct {
 //    int isOn;
 //    int isGreen;
@@ -121,3 +844,5 @@ int classify_hsv_color(double hue, double sat, double val);
 #ifdef __cplusplus
 }
 #endif
+
+#endif // C_PLUGIN_H
@@ -7,6 +7,255 @@
 extern "C" {
 #endif
 
+/// per-stream decoder state
+typedef struct lifi_session lifi_session;
+
+/// frame recorder writing a .lfc capture
+typedef struct lifi_recorder lifi_recorder;
+
+/// bounded camera-to-decoder frame queue
+typedef struct lifi_frame_queue lifi_frame_queue;
+
+/// what lifi_queue_push does when the queue is full
+typedef enum {
+    LIFI_QUEUE_DROP_OLDEST = 0,
+    LIFI_QUEUE_DROP_NEWEST,
+    LIFI_QUEUE_BLOCK
+} lifi_queue_policy;
+
+/// slot from lifi_queue_claim: planar crop at (x0, y0), chroma stride (width + 1) / 2
+typedef struct {
+    uint8_t* y;
+    uint8_t* u;
+    uint8_t* v;
+    int32_t x0, y0;
+    int32_t width, height;
+} lifi_queue_slot;
+
+/// frame queue counters since creation
+typedef struct {
+    uint64_t enqueued;
+    uint64_t dequeued;
+    uint64_t dropped_oldest;
+    uint64_t dropped_newest;
+    uint64_t timeouts;
+    uint32_t depth;
+    uint32_t max_depth;
+} lifi_queue_stats;
+
+/// stages timed when built with LIFI_STAGE_TIMING
+typedef enum {
+    LIFI_STAGE_ROI_COPY = 0,
+    LIFI_STAGE_MEDIAN,
+    LIFI_STAGE_DOWNSAMPLE,
+    LIFI_STAGE_THRESHOLD,
+    LIFI_STAGE_COLOR_HISTOGRAM,
+    LIFI_STAGE_CLASSIFY,
+    LIFI_STAGE_COUNT
+} lifi_stage;
+
+/// latency of one stage in ns, one sample per frame
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+} lifi_stage_stat;
+
+/// all stages of one session, indexed by lifi_stage
+typedef struct {
+    int32_t enabled;
+    lifi_stage_stat stages[LIFI_STAGE_COUNT];
+} lifi_stage_stats;
+
+/// stage boundaries of the end-to-end latency histograms
+typedef enum {
+    LIFI_LATENCY_SENSOR_TO_ENQUEUE = 0,
+    LIFI_LATENCY_QUEUE_WAIT,
+    LIFI_LATENCY_PROCESSING,
+    LIFI_LATENCY_SENSOR_TO_DECISION,
+    LIFI_LATENCY_DECISION_TO_BYTE,
+    LIFI_LATENCY_SENSOR_TO_BYTE,
+    LIFI_LATENCY_CHARACTER,
+    LIFI_LATENCY_COUNT
+} lifi_latency_span;
+
+/// latency histograms of one session, indexed by lifi_latency_span
+typedef struct {
+    lifi_stage_stat spans[LIFI_LATENCY_COUNT];
+} lifi_latency_stats;
+
+/// clock of the sensor timestamps
+typedef enum {
+    LIFI_CLOCK_MONOTONIC = 0,
+    LIFI_CLOCK_BOOTTIME,
+} lifi_clock;
+
+/// one process_frame_color decision (or LIFI_TRACE_BYTE emission) in the trace ring
+typedef struct {
+    uint32_t frame;
+    uint32_t session;
+    uint64_t t_ns;
+    int64_t  sensor_ns;
+    uint32_t latency_us;
+    uint32_t wait_us;
+    float    y;
+    float    dyn_min;
+    float    dyn_max;
+    uint8_t  led_on;
+    uint8_t  encoded;
+    uint8_t  color;
+    uint8_t  flags;
+} lifi_trace_record;
+
+#define LIFI_TRACE_RESET        1
+#define LIFI_TRACE_AMBIENT_RING 2
+#define LIFI_TRACE_BYTE         4
+#define LIFI_TRACE_GAP          8
+#define LIFI_TRACE_LATE        16
+
+/// frame spacing, inferred gaps and deadline misses of one session
+typedef struct {
+    uint64_t frames;
+    uint64_t gaps;
+    uint64_t missed_frames;
+    uint64_t deadline_misses;
+    uint64_t period_ns;
+    uint64_t budget_ns;
+    uint64_t last_missed;
+    lifi_stage_stat interval;
+    lifi_stage_stat jitter;
+} lifi_cadence_stats;
+
+/// the optical protocol shared with the firmware (lifi_protocol.h)
+typedef struct {
+    int32_t marker_pulses;
+    uint8_t marker[16];
+    uint8_t bit_color[2];
+    int32_t slots_per_pulse;
+    int32_t payload_bits;
+    int32_t gap_slots;
+    int32_t slots_per_char;
+    int32_t payload_slots;
+    int32_t default_interval_ms;
+    int32_t min_interval_ms;
+    int32_t frames_per_slot;
+} lifi_protocol;
+
+/// version of the struct ABI (lifi_frame_desc, lifi_result, lifi_capabilities)
+#define LIFI_ABI_VERSION 1
+
+/// pixel layouts a lifi_frame_desc can describe
+typedef enum {
+    LIFI_FORMAT_YUV_420_888 = 0,
+    LIFI_FORMAT_NV21,
+    LIFI_FORMAT_NV12,
+    LIFI_FORMAT_I420,
+} lifi_pixel_format;
+
+/// rectangle in frame pixels
+typedef struct {
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+} lifi_roi;
+
+/// one camera frame and the ROIs to decode in it; y_row_stride 0 = width in
+/// every format, YUV_420_888 needs both chroma strides
+typedef struct {
+    uint32_t version;
+    int32_t  format;
+    const uint8_t* y_plane;
+    const uint8_t* u_plane;
+    const uint8_t* v_plane;
+    int32_t  width;
+    int32_t  height;
+    int32_t  y_row_stride;
+    int32_t  uv_row_stride;
+    int32_t  uv_pixel_stride;
+    int32_t  count;
+    int64_t  timestamp_ns;
+    const lifi_roi* rois;
+    int32_t  roi_count;
+} lifi_frame_desc;
+
+/// per-frame events in lifi_result.events
+typedef enum {
+    LIFI_EVENT_RESET = 1,
+    LIFI_EVENT_LED_ON,
+    LIFI_EVENT_LED_OFF,
+    LIFI_EVENT_COLOR,
+    LIFI_EVENT_GAP,
+    LIFI_EVENT_LATE,
+} lifi_event_type;
+
+#define LIFI_MAX_EVENTS 8
+
+typedef struct {
+    int32_t type;
+    int32_t value;
+} lifi_event;
+
+/// decision for one ROI of one frame
+typedef struct {
+    uint32_t version;
+    uint32_t frame;
+    int64_t  sensor_ns;
+    double   y;
+    double   dyn_min;
+    double   dyn_max;
+    double   hue;
+    double   sat;
+    double   val;
+    int32_t  color;
+    int32_t  led_on;
+    int32_t  encoded;
+    int32_t  flags;
+    uint32_t latency_us;
+    int32_t  event_count;
+    lifi_event events[LIFI_MAX_EVENTS];
+} lifi_result;
+
+#define LIFI_ERR_ARGUMENT -1
+#define LIFI_ERR_VERSION  -2
+#define LIFI_ERR_FORMAT   -3
+
+/// what this build of the library supports
+typedef struct {
+    uint32_t abi_version;
+    uint32_t formats;
+    uint32_t features;
+    int32_t  max_events;
+    int32_t  pool_threads;
+} lifi_capabilities;
+
+#define LIFI_FEATURE_OPENCV       1
+#define LIFI_FEATURE_STAGE_TIMING 2
+
+/// latest decision of a session, seqlock-published for lock-free readers
+typedef struct {
+    uint64_t seq;
+    uint32_t frame;
+    uint32_t edge_frame;
+    int64_t  sensor_ns;
+    uint64_t t_ns;
+    double   y;
+    double   dyn_min;
+    double   dyn_max;
+    double   hue;
+    double   sat;
+    double   val;
+    int32_t  color;
+    int32_t  led_on;
+    int32_t  encoded;
+    int32_t  flags;
+    int32_t  frames_missed;
+    uint32_t latency_us;
+} lifi_shared_result;
+
 /// very short-lived
 int   sum(int a, int b);
 
@@ -63,7 +312,7 @@ void process_frame_color(
         int32_t y0,
         int32_t w,
         int32_t h,
-        double* out_values   // length = 7: [Ycurr, Ymin, Ymax, hue, sat]
+        double* out_values   // length = 7: [Y, dynMin, dynMax, hue, sat, colorCode, encoded]
 );
 
 void yuvpixel_to_hsv_c(
@@ -93,6 +342,298 @@ void detect_frame_color_precise(
 
 int classify_hsv_color(double hue, double sat, double val);
 
+/// ambient-light / mains-flicker rejection for process_frame_color
+/// filter_type: 0 = none, 1 = high-pass, 2 = notch (freq_hz = mains frequency)
+void set_ambient_rejection(
+        int32_t background_ring,
+        int32_t filter_type,
+        double fps,
+        double freq_hz,
+        double q
+);
+
+/// luma estimator for process_frame_color
+/// mode: 0 = block mean, 1 = temporal-variance weighted (last 3 frames)
+void set_luma_estimator(int32_t mode, int32_t change_threshold);
+
+/// block size of the process_frame_color grid (1..64, default 10)
+void set_block_size(int32_t block_size);
+
+/// poll roi_count LEDs ([x, y, w, h] quads in rois) with one integral image
+void detect_leds_on(
+        const uint8_t* nv21_data,
+        int width,
+        int height,
+        uint8_t threshold,
+        const int* rois,
+        int roi_count,
+        uint8_t* out_on
+);
+
+/// build this frame's Y integral image over (x, y, w, h)
+/// count_threshold >= 0 also builds a count of pixels above it
+/// tables are per thread: query them on the thread that built them
+int32_t lifi_integral_build(
+        const uint8_t* y_plane,
+        int32_t width,
+        int32_t height,
+        int32_t row_stride,
+        int32_t x,
+        int32_t y,
+        int32_t w,
+        int32_t h,
+        int32_t count_threshold
+);
+
+/// mean Y over a rectangle of the built region
+double lifi_integral_mean(int32_t x, int32_t y, int32_t w, int32_t h);
+
+/// fraction of pixels above count_threshold over a rectangle of the built region
+double lifi_integral_fraction_above(int32_t x, int32_t y, int32_t w, int32_t h);
+
+/// create a decoder session with buffers sized for frames up to max_width x max_height
+lifi_session* lifi_session_create(int32_t max_width, int32_t max_height);
+
+/// free a session from lifi_session_create
+void lifi_session_destroy(lifi_session* session);
+
+/// process_frame_color on an explicit session; NULL = default
+void lifi_session_process_frame_color(
+        lifi_session* session,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t count,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        double* out_values   // length = 7
+);
+
+/// set_ambient_rejection for one session
+void lifi_session_set_ambient_rejection(
+        lifi_session* session,
+        int32_t background_ring,
+        int32_t filter_type,
+        double fps,
+        double freq_hz,
+        double q
+);
+
+/// set_luma_estimator for one session
+void lifi_session_set_luma_estimator(lifi_session* session, int32_t mode, int32_t change_threshold);
+
+/// set_block_size for one session
+void lifi_session_set_block_size(lifi_session* session, int32_t block_size);
+
+/// process_frame with per-session running min/max; NULL = default
+void lifi_session_process_frame(
+        lifi_session* session,
+        const uint8_t* y_plane,
+        int32_t width,
+        int32_t height,
+        int32_t row_stride,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        double* out_values
+);
+
+/// per-stage timing of a session (NULL = default); returns 0 if not compiled in
+int32_t lifi_get_stage_stats(const lifi_session* session, lifi_stage_stats* out);
+
+/// clear per-stage timing (NULL = default session)
+void lifi_reset_stage_stats(lifi_session* session);
+
+/// clock of the sensor timestamps (lifi_clock)
+void lifi_latency_set_clock(int32_t clock);
+
+/// now on the latency clock, ns
+int64_t lifi_latency_now(void);
+
+/// sensor timestamp of the next frame this session decodes (NULL = default, 0 = unknown)
+void lifi_session_stamp_frame(lifi_session* session, int64_t sensor_timestamp_ns);
+
+/// the decoder emitted a byte built from frames first_sensor_ns..last_sensor_ns
+void lifi_session_mark_byte(
+        lifi_session* session,
+        uint8_t value,
+        int64_t first_sensor_ns,
+        int64_t last_sensor_ns
+);
+
+/// latency histograms of a session (NULL = default)
+/// call it on the session's decode thread; elsewhere the copy can be torn
+void lifi_get_latency_stats(const lifi_session* session, lifi_latency_stats* out);
+
+/// clear latency histograms (NULL = default session); decode thread only
+void lifi_reset_latency_stats(lifi_session* session);
+
+/// frame period and processing budget (<= 0 = estimate / same as period; NULL = default)
+void lifi_session_set_frame_budget(lifi_session* session, int64_t period_ns, int64_t budget_ns);
+
+/// frames missing right before the last decoded frame (NULL = default)
+int32_t lifi_session_frames_missed(const lifi_session* session);
+
+/// frame cadence counters of a session (NULL = default)
+/// call it on the session's decode thread; elsewhere the copy can be torn
+void lifi_get_cadence_stats(const lifi_session* session, lifi_cadence_stats* out);
+
+/// clear frame cadence counters (NULL = default session); decode thread only
+void lifi_reset_cadence_stats(lifi_session* session);
+
+/// per-frame trace on/off (default on)
+void lifi_trace_enable(int32_t on);
+
+/// move up to max_records trace records into out, oldest first
+int32_t lifi_trace_drain(lifi_trace_record* out, int32_t max_records);
+
+/// trace records overwritten before being drained
+uint64_t lifi_trace_dropped(void);
+
+/// drain the trace into a binary file (tools/lifi_trace2csv); -1 on error
+int32_t lifi_trace_dump(const char* path);
+
+/// create a capture file; NULL on error
+lifi_recorder* lifi_recorder_open(const char* path);
+
+/// append one frame; crop_margin < 0 stores full planes, else ROI + margin
+int32_t lifi_recorder_write(
+        lifi_recorder* rec,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        int32_t count,
+        int64_t timestamp_ns,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        int32_t crop_margin
+);
+
+/// write the index and close; returns frames written or -1
+int32_t lifi_recorder_close(lifi_recorder* rec);
+
+/// spsc frame queue; policy is a lifi_queue_policy, NULL on bad arguments
+lifi_frame_queue* lifi_queue_create(
+        int32_t capacity,
+        int32_t max_width,
+        int32_t max_height,
+        int32_t policy,
+        int32_t timeout_ms
+);
+
+void lifi_queue_destroy(lifi_frame_queue* q);
+
+/// producer: copy the frame's ROI in; 1 if queued, 0 if dropped
+int32_t lifi_queue_push(
+        lifi_frame_queue* q,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        int32_t count,
+        int64_t timestamp_ns,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h
+);
+
+/// producer: reserve a slot for the ROI to copy in yourself; 1 = fill it and commit, 0 = dropped
+int32_t lifi_queue_claim(
+        lifi_frame_queue* q,
+        int32_t width,
+        int32_t height,
+        int32_t count,
+        int64_t timestamp_ns,
+        int32_t x0,
+        int32_t y0,
+        int32_t w,
+        int32_t h,
+        lifi_queue_slot* out
+);
+
+/// queue the slot filled after a successful lifi_queue_claim
+void lifi_queue_commit(lifi_frame_queue* q);
+
+/// consumer: pop and decode one frame (NULL session = default); 1 if a frame was processed
+int32_t lifi_queue_process(
+        lifi_frame_queue* q,
+        lifi_session* session,
+        double* out_values,
+        int64_t* timestamp_ns,
+        uint64_t* seq
+);
+
+/// copy the queue counters
+void lifi_queue_get_stats(const lifi_frame_queue* q, lifi_queue_stats* out);
+
+/// resize the decode pool; <= 0 = one thread per big core; returns the size
+int32_t lifi_pool_set_threads(int32_t threads);
+
+/// decode pool size, caller included
+int32_t lifi_pool_threads(void);
+
+/// process_frame_color for n ROIs in parallel; rois = 4 ints, out = 7 doubles each
+/// NULL session = default, at most one; returns n or LIFI_ERR_ARGUMENT
+int32_t lifi_process_frame_color_multi(
+        lifi_session* const* sessions,
+        int32_t n,
+        const uint8_t* y_plane,
+        const uint8_t* u_plane,
+        const uint8_t* v_plane,
+        int32_t width,
+        int32_t height,
+        int32_t count,
+        int32_t y_row_stride,
+        int32_t uv_row_stride,
+        int32_t uv_pixel_stride,
+        const int32_t* rois,
+        double* out_values
+);
+
+/// protocol the plugin was built with
+void lifi_get_protocol(lifi_protocol* out);
+
+/// what this build supports
+void lifi_get_capabilities(lifi_capabilities* out);
+
+/// process_frame_color on frame->rois[0]; NULL session = default; 1 or LIFI_ERR_*
+int32_t lifi_session_decode(lifi_session* session, const lifi_frame_desc* frame, lifi_result* out);
+
+/// every ROI of a frame on the pool, one session and result each (at most one NULL = default); count or LIFI_ERR_*
+int32_t lifi_decode(lifi_session* const* sessions, const lifi_frame_desc* frame, lifi_result* results);
+
+/// detect_leds_on on a descriptor of any format; entries written or LIFI_ERR_*
+int32_t lifi_detect_leds_on(const lifi_frame_desc* frame, uint8_t threshold, uint8_t* out_on);
+
+/// detect_bright_regions on a descriptor of any format; boxes found or LIFI_ERR_*
+int32_t lifi_detect_bright_regions(const lifi_frame_desc* frame, uint8_t threshold, int32_t max_regions, int32_t* bbox_out);
+
+/// shared result block of a session (NULL = default); valid until it is destroyed
+const lifi_shared_result* lifi_session_shared_result(const lifi_session* session);
+
+/// consistent copy of the shared result block; 0 if it kept changing
+int32_t lifi_read_shared_result(const lifi_session* session, lifi_shared_result* out);
+
 #ifdef __cplusplus
 }
 #endif
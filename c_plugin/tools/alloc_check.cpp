@@ -0,0 +1,355 @@
+// Steady-state allocation check for the per-frame native entry points.
+//
+//   lifi_alloc_check [--warmup N] [--frames N] [--threads N] [--abort]
+//
+// Replaces the global operator new/delete with counting versions, runs
+// every per-frame call for --warmup frames, then arms the counter and runs
+// --frames more. Any allocation after warm-up, on the caller or on a pool
+// thread, is reported per entry point and makes the exit status 1. With
+// --abort the first one calls abort() instead, so a debugger shows who
+// allocated.
+//
+// detect_bright_regions is listed but not held to zero: OpenCV's
+// findContours keeps its own storage.
+
+#include "c_plugin.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Counting allocator
+
+namespace {
+
+std::atomic<bool>     armed{false};
+std::atomic<uint64_t> allocations{0};
+std::atomic<uint64_t> allocatedBytes{0};
+bool abortOnAlloc = false;
+
+void* countedAlloc(size_t size, size_t align) {
+    if (armed.load(std::memory_order_relaxed)) {
+        if (abortOnAlloc) std::abort();
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    if (size == 0) size = 1;
+    void* p = nullptr;
+    if (align <= alignof(std::max_align_t)) {
+        p = std::malloc(size);
+    } else if (posix_memalign(&p, align, size) != 0) {
+        p = nullptr;
+    }
+    return p;
+}
+
+} // namespace
+
+void* operator new(size_t n) {
+    if (void* p = countedAlloc(n, 0)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) {
+    if (void* p = countedAlloc(n, 0)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t n, std::align_val_t a) {
+    if (void* p = countedAlloc(n, size_t(a))) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n, std::align_val_t a) {
+    if (void* p = countedAlloc(n, size_t(a))) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return countedAlloc(n, 0); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return countedAlloc(n, 0); }
+
+// Everything above comes from malloc / posix_memalign, so free is the match
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr int W = 1280, H = 720;
+
+// Interleaved-chroma camera frame with an LED disk that blinks red/blue
+struct Frame {
+    std::vector<uint8_t> y, vu, nv21;
+
+    Frame() : y(size_t(W) * H), vu(size_t(W) * H / 2 + 1), nv21(size_t(W) * H * 3 / 2) {}
+
+    void render(int index) {
+        const bool on = index % 3 != 2;
+        const bool red = index % 2 == 0;
+        const int cx = W / 2, cy = H / 2, r2 = 60 * 60;
+        std::srand(unsigned(index));
+        for (int r = 0; r < H; ++r) {
+            for (int c = 0; c < W; ++c) {
+                const bool led = on && (r - cy) * (r - cy) + (c - cx) * (c - cx) < r2;
+                y[size_t(r) * W + c] = uint8_t(40 + std::rand() % 8 + (led ? 150 : 0));
+            }
+        }
+        for (int r = 0; r < H / 2; ++r) {
+            for (int c = 0; c < W / 2; ++c) {
+                const bool led = on && (2 * r - cy) * (2 * r - cy) + (2 * c - cx) * (2 * c - cx) < r2;
+                vu[size_t(r) * W + 2 * c]     = led ? (red ? 200 : 100) : 128;   // V
+                vu[size_t(r) * W + 2 * c + 1] = led ? (red ? 90 : 200) : 128;    // U
+            }
+        }
+        std::memcpy(nv21.data(), y.data(), y.size());
+        std::memcpy(nv21.data() + y.size(), vu.data(), nv21.size() - y.size());
+    }
+
+    const uint8_t* u() const { return vu.data() + 1; }
+    const uint8_t* v() const { return vu.data(); }
+};
+
+struct Step {
+    const char* name;
+    bool mustBeZero;
+    void (*run)(const Frame& f, int index);
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+struct State {
+    lifi_session* small = nullptr;
+    lifi_session* large = nullptr;
+    std::vector<lifi_session*> multi;
+    std::vector<int32_t> multiRois;
+    std::vector<double> multiOut;
+    std::vector<lifi_session*> decoders;
+    std::vector<lifi_roi> decodeRois;
+    std::vector<lifi_result> results;
+    lifi_frame_queue* queue = nullptr;
+    std::vector<lifi_trace_record> trace;
+} state;
+
+constexpr int ROI_X = W / 2 - 100, ROI_Y = H / 2 - 100, ROI = 200;
+
+void sessionColor(const Frame& f, int i) {
+    double out[7];
+    lifi_session_process_frame_color(state.small, f.y.data(), f.u(), f.v(), W, H, i,
+                                     W, W, 2, ROI_X, ROI_Y, ROI, ROI, out);
+}
+
+void sessionColorLarge(const Frame& f, int i) {
+    double out[7];
+    lifi_session_process_frame_color(state.large, f.y.data(), f.u(), f.v(), W, H, i,
+                                     W, W, 2, 0, 0, W, H, out);
+}
+
+void defaultColor(const Frame& f, int i) {
+    double out[7];
+    process_frame_color(f.y.data(), f.u(), f.v(), W, H, i, W, W, 2, ROI_X, ROI_Y, ROI, ROI, out);
+}
+
+void multiColor(const Frame& f, int i) {
+    lifi_process_frame_color_multi(state.multi.data(), int32_t(state.multi.size()),
+                                   f.y.data(), f.u(), f.v(), W, H, i, W, W, 2,
+                                   state.multiRois.data(), state.multiOut.data());
+}
+
+void decodeFrame(const Frame& f, int i) {
+    lifi_frame_desc frame = {};
+    frame.version = LIFI_ABI_VERSION;
+    frame.format = LIFI_FORMAT_YUV_420_888;
+    frame.y_plane = f.y.data();
+    frame.u_plane = f.u();
+    frame.v_plane = f.v();
+    frame.width = W;
+    frame.height = H;
+    frame.y_row_stride = W;
+    frame.uv_row_stride = W;
+    frame.uv_pixel_stride = 2;
+    frame.count = i;
+    frame.timestamp_ns = int64_t(i + 1) * 33333333;
+    frame.rois = state.decodeRois.data();
+    frame.roi_count = int32_t(state.decodeRois.size());
+    lifi_decode(state.decoders.data(), &frame, state.results.data());
+
+    frame.roi_count = 1;
+    lifi_session_decode(nullptr, &frame, state.results.data());
+
+    // The same frame as one packed NV21 buffer
+    frame.format = LIFI_FORMAT_NV21;
+    frame.y_plane = f.nv21.data();
+    lifi_session_decode(state.decoders[0], &frame, state.results.data());
+}
+
+void brightness(const Frame& f, int) {
+    double out[3];
+    process_frame(f.y.data(), W, H, W, ROI_X, ROI_Y, ROI, ROI, out);
+    lifi_session_process_frame(state.small, f.y.data(), W, H, W, ROI_X, ROI_Y, ROI, ROI, out);
+}
+
+void ledPoll(const Frame& f, int) {
+    const int rois[12] = {ROI_X, ROI_Y, ROI, ROI, 10, 10, 40, 40, W - 60, H - 60, 50, 50};
+    uint8_t on[3];
+    detect_led_on(f.nv21.data(), W, H, 120, ROI_X, ROI_Y, ROI, ROI);
+    detect_leds_on(f.nv21.data(), W, H, 120, rois, 3, on);
+
+    const lifi_roi leds[3] = {{ROI_X, ROI_Y, ROI, ROI}, {10, 10, 40, 40}, {W - 60, H - 60, 50, 50}};
+    lifi_frame_desc frame = {};
+    frame.version = LIFI_ABI_VERSION;
+    frame.format = LIFI_FORMAT_NV21;
+    frame.y_plane = f.nv21.data();
+    frame.width = W;
+    frame.height = H;
+    frame.rois = leds;
+    frame.roi_count = 3;
+    lifi_detect_leds_on(&frame, 120, on);
+}
+
+void integral(const Frame& f, int) {
+    lifi_integral_build(f.y.data(), W, H, W, 0, 0, W, H, 120);
+    lifi_integral_mean(ROI_X, ROI_Y, ROI, ROI);
+    lifi_integral_fraction_above(ROI_X, ROI_Y, ROI, ROI);
+}
+
+void colorPrecise(const Frame& f, int) {
+    double hsv[3];
+    detect_frame_color_precise(f.y.data(), f.u(), f.v(), W, H, W, W, 2, 0, 0, W, H, hsv);
+    detect_frame_color_precise(f.y.data(), f.u(), f.v(), W, H, W, W, 2, ROI_X, ROI_Y, ROI, ROI, hsv);
+}
+
+void queued(const Frame& f, int i) {
+    double out[7];
+    int64_t ts;
+    uint64_t seq;
+    lifi_queue_push(state.queue, f.y.data(), f.u(), f.v(), W, H, W, W, 2, i, int64_t(i) * 33333333,
+                    ROI_X, ROI_Y, ROI, ROI);
+    lifi_queue_process(state.queue, state.small, out, &ts, &seq);
+}
+
+void diagnostics(const Frame&, int) {
+    lifi_stage_stats stats;
+    lifi_latency_stats latency;
+    lifi_cadence_stats cadence;
+    lifi_shared_result shared;
+    lifi_trace_drain(state.trace.data(), int32_t(state.trace.size()));
+    lifi_get_stage_stats(state.small, &stats);
+    lifi_get_latency_stats(state.small, &latency);
+    lifi_get_cadence_stats(state.small, &cadence);
+    lifi_read_shared_result(state.small, &shared);
+}
+
+#if LIFI_HAVE_OPENCV
+void brightRegions(const Frame& f, int) {
+    int boxes[16], count = 0;
+    detect_bright_regions(f.nv21.data(), W, H, 120, 4, boxes, &count);
+}
+#endif
+
+void usage(const char* argv0) {
+    std::fprintf(stderr, "usage: %s [--warmup N] [--frames N] [--threads N] [--abort]\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int warmup = 20, frames = 200, threads = 4;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--warmup") && i + 1 < argc) {
+            warmup = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--abort")) {
+            abortOnAlloc = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    lifi_pool_set_threads(threads);
+    lifi_trace_enable(1);
+
+    state.small = lifi_session_create(W, H);
+    lifi_session_set_luma_estimator(state.small, 1, 4);
+    lifi_session_set_ambient_rejection(state.small, 2, 1, 30.0, 100.0, 2.0);
+    state.large = lifi_session_create(W, H);
+    for (int i = 0; i < 6; ++i) {
+        state.multi.push_back(lifi_session_create(160, 160));
+        state.multiRois.insert(state.multiRois.end(), {40 + 200 * i, 200 + 40 * i, 160, 160});
+    }
+    state.multiOut.resize(7 * state.multi.size());
+    for (int i = 0; i < 3; ++i) {
+        state.decoders.push_back(lifi_session_create(160, 160));
+        state.decodeRois.push_back(lifi_roi{100 + 300 * i, 300, 160, 160});
+    }
+    state.results.resize(state.decoders.size());
+    state.queue = lifi_queue_create(4, 256, 256, 0, 0);
+    state.trace.resize(4096);
+
+    std::vector<Step> steps = {
+        {"lifi_session_process_frame_color", true, sessionColor},
+        {"lifi_session_process_frame_color (banded)", true, sessionColorLarge},
+        {"process_frame_color", true, defaultColor},
+        {"lifi_process_frame_color_multi", true, multiColor},
+        {"lifi_decode / lifi_session_decode", true, decodeFrame},
+        {"process_frame", true, brightness},
+        {"detect_led(s)_on / lifi_detect_leds_on", true, ledPoll},
+        {"lifi_integral_build", true, integral},
+        {"detect_frame_color_precise", true, colorPrecise},
+        {"lifi_queue_push / lifi_queue_process", true, queued},
+        {"lifi_trace_drain / stats / shared result", true, diagnostics},
+#if LIFI_HAVE_OPENCV
+        {"detect_bright_regions", false, brightRegions},
+#endif
+    };
+
+    Frame frame;
+    for (int i = 0; i < warmup + frames; ++i) {
+        frame.render(i);
+        if (i == warmup) armed.store(true);
+        for (Step& s : steps) {
+            const uint64_t n0 = allocations.load(), b0 = allocatedBytes.load();
+            s.run(frame, i);
+            s.allocations += allocations.load() - n0;
+            s.bytes += allocatedBytes.load() - b0;
+        }
+    }
+    armed.store(false);
+
+    std::printf("%d warm-up + %d checked frames, pool of %d\n", warmup, frames, lifi_pool_threads());
+    bool failed = false;
+    for (const Step& s : steps) {
+        const bool bad = s.mustBeZero && s.allocations > 0;
+        failed |= bad;
+        std::printf("  %-44s %8llu allocations %10llu bytes%s\n", s.name,
+                    (unsigned long long)s.allocations, (unsigned long long)s.bytes,
+                    bad ? "  FAIL" : (s.mustBeZero ? "" : "  (not enforced)"));
+    }
+
+    lifi_queue_destroy(state.queue);
+    for (lifi_session* s : state.multi) lifi_session_destroy(s);
+    for (lifi_session* s : state.decoders) lifi_session_destroy(s);
+    lifi_session_destroy(state.large);
+    lifi_session_destroy(state.small);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,239 @@
+// Micro-benchmarks of the native kernels on synthetic YUV_420_888 frames.
+//
+//   lifi_bench [--quick] [--min-ms N] [--format csv|json] > bench.csv
+//
+// Sweeps frame size (VGA to 4K), ROI size, chroma pixel stride (1 = planar
+// I420, 2 = interleaved like most Android cameras) and row padding. Prints
+// one record per case with the median ns per frame and MPix/s over the
+// pixels the kernel reads (the ROI, or the whole frame for
+// detect_bright_regions). Progress goes to stderr.
+
+#include "c_plugin.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+// One camera frame as the Android YUV_420_888 image hands it over, plus
+// the packed NV21 copy the detect_* entry points take.
+struct Frame {
+    int width = 0, height = 0;
+    int yStride = 0, uvStride = 0, pixelStride = 1;
+    std::vector<uint8_t> y, chroma, nv21;
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+};
+
+// Noisy dark background with a red LED disk in the middle.
+Frame makeFrame(int width, int height, int pixelStride, int rowPad, bool ledOn, unsigned seed) {
+    Frame f;
+    f.width = width;
+    f.height = height;
+    f.pixelStride = pixelStride;
+    f.yStride = width + rowPad;
+
+    const int cw = width / 2, ch = height / 2;
+    const int cx = width / 2, cy = height / 2;
+    const int r2 = (std::min(width, height) / 12) * (std::min(width, height) / 12);
+
+    f.y.assign(size_t(f.yStride) * height, 0);
+    f.nv21.assign(size_t(width) * height * 3 / 2, 128);
+    std::srand(seed);
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            bool led = ledOn && (r - cy) * (r - cy) + (c - cx) * (c - cx) < r2;
+            uint8_t val = uint8_t(40 + std::rand() % 8 + (led ? 150 : 0));
+            f.y[size_t(r) * f.yStride + c] = val;
+            f.nv21[size_t(r) * width + c] = val;
+        }
+    }
+
+    // Planar: U plane then V plane. Interleaved: one VU plane, U = V + 1.
+    f.uvStride = (pixelStride == 1 ? cw : width) + rowPad;
+    f.chroma.assign(size_t(f.uvStride) * ch * (pixelStride == 1 ? 2 : 1) + 1, 128);
+    uint8_t* u = pixelStride == 1 ? f.chroma.data() : f.chroma.data() + 1;
+    uint8_t* v = pixelStride == 1 ? f.chroma.data() + size_t(f.uvStride) * ch : f.chroma.data();
+    uint8_t* vu = f.nv21.data() + size_t(width) * height;
+    for (int r = 0; r < ch; ++r) {
+        for (int c = 0; c < cw; ++c) {
+            bool led = ledOn && (2 * r - cy) * (2 * r - cy) + (2 * c - cx) * (2 * c - cx) < r2;
+            uint8_t uu = led ? 90 : 128, vv = led ? 200 : 128;
+            u[size_t(r) * f.uvStride + size_t(c) * pixelStride] = uu;
+            v[size_t(r) * f.uvStride + size_t(c) * pixelStride] = vv;
+            vu[size_t(r) * width + 2 * c]     = vv;
+            vu[size_t(r) * width + 2 * c + 1] = uu;
+        }
+    }
+    f.u = u;
+    f.v = v;
+    return f;
+}
+
+struct Result {
+    long   iterations;
+    double medianNs;
+    double meanNs;
+};
+
+// Runs `body(i)` until `minMs` has passed (at least 5 calls) after a short
+// warm-up, timing every call.
+Result measure(const std::function<void(int)>& body, double minMs) {
+    using clock = std::chrono::steady_clock;
+    for (int i = 0; i < 3; ++i) body(i);
+
+    std::vector<double> samples;
+    const auto start = clock::now();
+    double total = 0.0;
+    for (int i = 0; samples.size() < 5 || total < minMs * 1e6; ++i) {
+        auto t0 = clock::now();
+        body(i);
+        double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+        samples.push_back(ns);
+        total = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    }
+
+    Result r;
+    r.iterations = long(samples.size());
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    r.meanNs = sum / samples.size();
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    r.medianNs = samples[samples.size() / 2];
+    return r;
+}
+
+struct Case {
+    const char* kernel;
+    int width, height, roi, pixelStride, rowPad;
+    long pixels;
+};
+
+enum class Format { CSV, JSON };
+
+void report(Format fmt, const Case& c, const Result& r) {
+    const double mpix = r.medianNs > 0 ? c.pixels / (r.medianNs / 1e3) : 0.0;
+    if (fmt == Format::CSV) {
+        std::printf("%s,%d,%d,%d,%d,%d,%ld,%.0f,%.0f,%.2f\n",
+                    c.kernel, c.width, c.height, c.roi, c.pixelStride, c.rowPad,
+                    r.iterations, r.medianNs, r.meanNs, mpix);
+    } else {
+        std::printf("{\"kernel\":\"%s\",\"width\":%d,\"height\":%d,\"roi\":%d,"
+                    "\"pixel_stride\":%d,\"row_pad\":%d,\"iterations\":%ld,"
+                    "\"ns_per_frame\":%.0f,\"ns_mean\":%.0f,\"mpix_per_s\":%.2f}\n",
+                    c.kernel, c.width, c.height, c.roi, c.pixelStride, c.rowPad,
+                    r.iterations, r.medianNs, r.meanNs, mpix);
+    }
+    std::fflush(stdout);
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr, "usage: %s [--quick] [--min-ms N] [--format csv|json]\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    double minMs = 200.0;
+    Format fmt = Format::CSV;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--quick")) {
+            quick = true;
+        } else if (!std::strcmp(argv[i], "--min-ms") && i + 1 < argc) {
+            minMs = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            std::string f = argv[++i];
+            if (f == "json") fmt = Format::JSON;
+            else if (f != "csv") { usage(argv[0]); return 2; }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    struct Size { int w, h; };
+    std::vector<Size> sizes = quick ? std::vector<Size>{{640, 480}, {1920, 1080}}
+                                    : std::vector<Size>{{640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+    std::vector<int> rois   = quick ? std::vector<int>{128} : std::vector<int>{32, 128, 512};
+    std::vector<int> pads   = quick ? std::vector<int>{0} : std::vector<int>{0, 64};
+
+    lifi_trace_enable(0);   // keep the ring out of the numbers
+
+    if (fmt == Format::CSV) {
+        std::printf("kernel,width,height,roi,pixel_stride,row_pad,iterations,ns_per_frame,ns_mean,mpix_per_s\n");
+    }
+
+    for (const Size& sz : sizes) {
+        for (int pixelStride : {1, 2}) {
+            for (int pad : pads) {
+                // Alternate LED on/off frames so the decoder sees real toggles
+                Frame frames[2] = {makeFrame(sz.w, sz.h, pixelStride, pad, true, 1),
+                                   makeFrame(sz.w, sz.h, pixelStride, pad, false, 2)};
+                std::fprintf(stderr, "%dx%d pixel_stride=%d pad=%d\n", sz.w, sz.h, pixelStride, pad);
+
+                // Whole-frame kernel on the packed NV21 copy; no strides involved
+                if (pixelStride == 1 && pad == 0) {
+#if LIFI_HAVE_OPENCV
+                    Case c{"detect_bright_regions", sz.w, sz.h, 0, 1, 0, long(sz.w) * sz.h};
+                    int boxes[4 * 16], count = 0;
+                    report(fmt, c, measure([&](int i) {
+                        detect_bright_regions(frames[i & 1].nv21.data(), sz.w, sz.h, 150, 16, boxes, &count);
+                    }, minMs));
+#else
+                    std::fprintf(stderr, "  detect_bright_regions skipped (built without OpenCV)\n");
+#endif
+                }
+
+                for (int roiSize : rois) {
+                    const int rw = std::min(roiSize, sz.w), rh = std::min(roiSize, sz.h);
+                    const int x0 = (sz.w - rw) / 2, y0 = (sz.h - rh) / 2;
+                    const long px = long(rw) * rh;
+                    double out[7];
+
+                    if (pixelStride == 1 && pad == 0) {
+                        Case c{"detect_led_on", sz.w, sz.h, roiSize, 1, 0, px};
+                        report(fmt, c, measure([&](int i) {
+                            detect_led_on(frames[i & 1].nv21.data(), sz.w, sz.h, 150, x0, y0, rw, rh);
+                        }, minMs));
+                    }
+
+                    if (pixelStride == 1) {
+                        Case c{"process_frame", sz.w, sz.h, roiSize, 1, pad, px};
+                        report(fmt, c, measure([&](int i) {
+                            const Frame& f = frames[i & 1];
+                            process_frame(f.y.data(), sz.w, sz.h, f.yStride, x0, y0, rw, rh, out);
+                        }, minMs));
+                    }
+
+                    {
+                        Case c{"process_frame_color", sz.w, sz.h, roiSize, pixelStride, pad, px};
+                        report(fmt, c, measure([&](int i) {
+                            const Frame& f = frames[i & 1];
+                            process_frame_color(f.y.data(), f.u, f.v, sz.w, sz.h, i,
+                                                f.yStride, f.uvStride, f.pixelStride,
+                                                x0, y0, rw, rh, out);
+                        }, minMs));
+                    }
+
+                    {
+                        Case c{"detect_frame_color_precise", sz.w, sz.h, roiSize, pixelStride, pad, px};
+                        report(fmt, c, measure([&](int i) {
+                            const Frame& f = frames[i & 1];
+                            detect_frame_color_precise(f.y.data(), f.u, f.v, sz.w, sz.h,
+                                                       f.yStride, f.uvStride, f.pixelStride,
+                                                       x0, y0, rw, rh, out);
+                        }, minMs));
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,278 @@
+// ESP32 stream queue against a mocked BLE link.
+//
+//   lifi_ble_queue_check [--bytes N] [--queue N] [--chunk N] [--latency N] [--seed N]
+//
+// Runs esp32Codenew/fully_working/message_queue.cpp with the NimBLE side
+// replaced by a fake notify characteristic and a simulated phone that
+// writes sequence-numbered chunks and paces itself on the status
+// notifications. Time is counted in transmit slots; writes and
+// notifications each take --latency slots to cross the link. Checks that:
+//
+//   sequence   in-order chunks are queued, a resend is ignored, a gap is
+//              refused with the seq to resend from, seq wraps past 255
+//   full       a chunk that does not fit is refused whole and goes in once
+//              the transmitter has made room
+//   level      fill reports go out per reporting step and once on empty
+//   stream     a paced sender keeps the transmitter busy: every byte goes
+//              out in order, characters back to back, no starved slots
+//
+// Exits 1 if any check fails.
+
+#include "message_queue.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The notify characteristic: keeps every status packet it was handed
+class FakeCharacteristic : public StatusNotifier {
+public:
+    struct Status {
+        uint8_t  code;
+        uint8_t  nextSeq;
+        uint32_t used;
+        uint32_t free;
+    };
+
+    void notify(const uint8_t* p, size_t length) override {
+        if (length != STATUS_BYTES) return;
+        sent.push_back(Status{p[0], p[1], uint32_t(p[2] | p[3] << 8), uint32_t(p[4] | p[5] << 8)});
+    }
+
+    std::vector<Status> sent;
+};
+
+std::vector<uint8_t> chunk(uint8_t seq, const uint8_t* payload, size_t length) {
+    std::vector<uint8_t> c(length + 1);
+    c[0] = seq;
+    std::memcpy(c.data() + 1, payload, length);
+    return c;
+}
+
+ChunkStatus write(ChunkReceiver& rx, const std::vector<uint8_t>& c) {
+    return rx.onWrite(c.data(), c.size());
+}
+
+std::vector<uint8_t> drain(StreamSource& source, size_t chars) {
+    std::vector<uint8_t> slots;
+    uint8_t slot;
+    for (size_t n = chars * LIFI_SLOTS_PER_CHAR; n > 0 && source.next(slot); --n) slots.push_back(slot);
+    return slots;
+}
+
+bool report(const char* name, bool ok, const std::string& detail) {
+    std::printf("  %-10s %s  %s\n", name, ok ? "ok  " : "FAIL", detail.c_str());
+    return ok;
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr, "usage: %s [--bytes N] [--queue N] [--chunk N] [--latency N] [--seed N]\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int bytes = 3000, queueBytes = 256, chunkBytes = 20, latency = 3;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--bytes") && i + 1 < argc) {
+            bytes = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--queue") && i + 1 < argc) {
+            queueBytes = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--chunk") && i + 1 < argc) {
+            chunkBytes = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--latency") && i + 1 < argc) {
+            latency = std::max(0, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = unsigned(std::atoi(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (queueBytes < 16 || queueBytes > 32768 || (queueBytes & (queueBytes - 1))) {
+        std::fprintf(stderr, "--queue must be a power of two from 16 to 32768\n");
+        return 2;
+    }
+    chunkBytes = std::min(chunkBytes, queueBytes);
+
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> message(static_cast<size_t>(bytes));
+    for (uint8_t& b : message) b = uint8_t(rng());
+
+    // The slots the transmitter must produce for `data`, back to back
+    auto expectedSlots = [](const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> slots;
+        uint8_t one[MAX_SLOTS_PER_CHAR];
+        for (uint8_t c : data) {
+            const int n = encodeChar(c, TX_FEC_NONE, one);
+            slots.insert(slots.end(), one, one + n);
+        }
+        return slots;
+    };
+
+    std::printf("%d bytes in %d-byte chunks through a %d-byte queue, link latency %d slots\n",
+                bytes, chunkBytes, queueBytes, latency);
+    bool ok = true;
+
+    // sequence
+    {
+        std::vector<uint8_t> storage(64);
+        ByteRing ring(storage.data(), 64);
+        FakeCharacteristic chr;
+        ChunkReceiver rx(ring, chr);
+        StreamSource source(ring);
+
+        const uint8_t a[] = {'a'}, b[] = {'b', 'c'}, d[] = {'d'};
+        std::vector<uint8_t> w;
+        bool good = write(rx, w = chunk(0, a, 1)) == CHUNK_ACCEPTED;
+        good &= write(rx, w = chunk(1, b, 2)) == CHUNK_ACCEPTED;
+        good &= write(rx, w = chunk(1, b, 2)) == CHUNK_DUPLICATE;
+        good &= write(rx, w = chunk(3, d, 1)) == CHUNK_OUT_OF_ORDER;
+        good &= chr.sent.back().nextSeq == 2;
+        good &= rx.onWrite(w.data(), 1) == CHUNK_EMPTY;
+        good &= write(rx, w = chunk(2, d, 1)) == CHUNK_ACCEPTED;
+        good &= drain(source, 8) == expectedSlots({'a', 'b', 'c', 'd'});
+
+        // Past 255 and back to 0
+        for (int n = 3; n < 300 && good; ++n) {
+            good &= write(rx, w = chunk(uint8_t(n), a, 1)) == CHUNK_ACCEPTED;
+            good &= drain(source, 1).size() == size_t(LIFI_SLOTS_PER_CHAR);
+        }
+        good &= rx.nextSeq() == uint8_t(300);
+
+        // A new connection starts over; a stale seq 0 is not a resend
+        rx.reset();
+        good &= write(rx, w = chunk(uint8_t(299), a, 1)) == CHUNK_OUT_OF_ORDER;
+        good &= write(rx, w = chunk(0, a, 1)) == CHUNK_ACCEPTED;
+        good &= chr.sent.size() == 6 + 297 + 2;
+        ok &= report("sequence", good, std::to_string(chr.sent.size()) + " status notifications, " +
+                                       "next seq " + std::to_string(rx.nextSeq()));
+    }
+
+    // full
+    {
+        std::vector<uint8_t> storage(64);
+        ByteRing ring(storage.data(), 64);
+        FakeCharacteristic chr;
+        ChunkReceiver rx(ring, chr);
+        StreamSource source(ring);
+
+        const std::vector<uint8_t> payload(message.begin(), message.begin() + 24);
+        std::vector<uint8_t> w;
+        bool good = true;
+        for (uint8_t s = 0; s < 2; ++s)
+            good &= write(rx, w = chunk(s, payload.data(), 24)) == CHUNK_ACCEPTED;
+        good &= write(rx, w = chunk(2, payload.data(), 24)) == CHUNK_FULL;
+        good &= chr.sent.back().used == 48 && chr.sent.back().free == 16 && chr.sent.back().nextSeq == 2;
+
+        // Room for it once eight characters went out; the copy wraps the ring
+        good &= drain(source, 8).size() == size_t(8 * LIFI_SLOTS_PER_CHAR);
+        good &= write(rx, w) == CHUNK_ACCEPTED;
+        std::vector<uint8_t> all(payload.begin() + 8, payload.end());
+        all.insert(all.end(), payload.begin(), payload.end());
+        all.insert(all.end(), payload.begin(), payload.end());
+        good &= drain(source, 64) == expectedSlots(all) && source.idle();
+        ok &= report("full", good, good ? "refused whole, queued after draining" : "partial or lost data");
+    }
+
+    // level
+    {
+        std::vector<uint8_t> storage(64);
+        ByteRing ring(storage.data(), 64);
+        FakeCharacteristic chr;
+        ChunkReceiver rx(ring, chr);        // step 8 bytes
+        StreamSource source(ring);
+
+        std::vector<uint8_t> w = chunk(0, message.data(), 40);
+        rx.onWrite(w.data(), w.size());
+        int levels = 0;
+        for (int c = 0; c < 50; ++c) {
+            drain(source, 1);
+            const size_t before = chr.sent.size();
+            rx.poll();
+            levels += int(chr.sent.size() - before);
+        }
+        const bool good = levels == 5 && chr.sent.back().code == STREAM_LEVEL && chr.sent.back().used == 0;
+        ok &= report("level", good, std::to_string(levels) + " fill reports over 40 bytes, expected 5");
+    }
+
+    // stream: the phone writes whenever the last status leaves room for a
+    // chunk beyond what it still has in flight
+    {
+        std::vector<uint8_t> storage(size_t(queueBytes), 0);
+        ByteRing ring(storage.data(), uint32_t(queueBytes));
+        FakeCharacteristic chr;
+        ChunkReceiver rx(ring, chr);
+        StreamSource source(ring);
+
+        struct Write {
+            long arrives;
+            std::vector<uint8_t> data;
+        };
+        struct Note {
+            long arrives;
+            long sentAt;
+            FakeCharacteristic::Status status;
+        };
+        std::deque<Write> writes;           // phone -> ESP32
+        std::deque<Note> notes;             // ESP32 -> phone
+        std::vector<std::pair<long, size_t>> unconfirmed;   // send time, payload bytes
+
+        size_t sent = 0, notified = 0;
+        uint8_t seq = 0;
+        uint32_t freeSeen = uint32_t(queueBytes);
+        long freeAt = -1;                   // when the status behind freeSeen was sent
+        std::vector<uint8_t> out;
+        long starved = 0, refused = 0, t = 0;
+        bool started = false;
+
+        for (; t < long(bytes) * LIFI_SLOTS_PER_CHAR * 4 && out.size() < size_t(bytes) * LIFI_SLOTS_PER_CHAR; ++t) {
+            // ESP32: BLE writes land, loop() polls, the timer takes a slot
+            while (!writes.empty() && writes.front().arrives <= t) {
+                const ChunkStatus st = rx.onWrite(writes.front().data.data(), writes.front().data.size());
+                refused += st != CHUNK_ACCEPTED;
+                writes.pop_front();
+            }
+            rx.poll();
+            for (; notified < chr.sent.size(); ++notified) notes.push_back(Note{t + latency, t, chr.sent[notified]});
+
+            uint8_t slot;
+            if (source.next(slot)) {
+                out.push_back(slot);
+                started = true;
+            } else if (started) {
+                ++starved;
+            }
+
+            // Phone
+            while (!notes.empty() && notes.front().arrives <= t) {
+                freeSeen = notes.front().status.free;
+                freeAt = notes.front().sentAt;
+                notes.pop_front();
+            }
+            size_t inFlight = 0;
+            for (const auto& u : unconfirmed) inFlight += u.first + latency > freeAt ? u.second : 0;
+            const size_t n = std::min(size_t(chunkBytes), size_t(bytes) - sent);
+            if (n && freeSeen >= inFlight + n) {
+                writes.push_back(Write{t + latency, chunk(seq++, message.data() + sent, n)});
+                unconfirmed.emplace_back(t, n);
+                sent += n;
+            }
+        }
+
+        const bool same = out == expectedSlots(message);
+        ok &= report("stream", same && starved == 0 && refused == 0,
+                     std::to_string(out.size() / LIFI_SLOTS_PER_CHAR) + " characters in " + std::to_string(t) +
+                     " slots, " + std::to_string(starved) + " starved, " + std::to_string(refused) +
+                     " chunks refused" + (same ? "" : ", slots differ"));
+    }
+
+    return ok ? 0 : 1;
+}
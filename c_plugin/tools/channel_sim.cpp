@@ -0,0 +1,346 @@
+#include "channel_sim.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+// Mean of sin(2*pi*f*t) over [t0, t1), t in ms
+double meanSin(double hz, double t0, double t1) {
+    const double w = 2.0 * PI * hz / 1000.0;
+    if (w == 0.0 || t1 <= t0) return std::sin(w * t0);
+    return (std::cos(w * t0) - std::cos(w * t1)) / (w * (t1 - t0));
+}
+
+inline uint8_t clampCode(float v) {
+    return uint8_t(v <= 0.f ? 0 : v >= 255.f ? 255 : int(v + 0.5f));
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// TextTransmitter
+
+void TextTransmitter::send(const std::vector<uint8_t>& msg, uint16_t intervalMs, uint32_t nowMs) {
+    message = msg;
+    gInterval = intervalMs < LIFI_MIN_INTERVAL_MS ? LIFI_DEFAULT_INTERVAL_MS : intervalMs;
+    state = BS_IDLE;
+    charIndex = 0;
+    bitIndex = LIFI_PAYLOAD_BITS - 1;
+    darkSlots = 0;
+    markerIndex = 0;
+    ledOn = false;
+    newMessage = true;
+    stripOff();
+    phaseStart = nowMs;
+}
+
+void TextTransmitter::stripOff() {
+    on = false;
+    shown = LedColor{};
+}
+
+void TextTransmitter::fill(uint8_t slot) {
+    on = slot != SLOT_OFF;
+    shown = LedColor{slot == SLOT_RED ? TX_BRIGHTNESS : 0.f,
+                     slot == SLOT_GREEN ? TX_BRIGHTNESS : 0.f,
+                     slot == SLOT_BLUE ? TX_BRIGHTNESS : 0.f};
+}
+
+void TextTransmitter::poll(uint32_t now) {
+    if (message.empty() && state == BS_IDLE) return;
+
+    switch (state) {
+        case BS_IDLE:
+            if (newMessage) {
+                newMessage = false;
+                charIndex = 0;
+                markerIndex = 0;
+                bitIndex = LIFI_PAYLOAD_BITS - 1;
+                darkSlots = 0;
+                ledOn = false;
+                state = BS_START_MARKER;
+                phaseStart = now;
+            }
+            break;
+
+        case BS_START_MARKER:
+            if (now - phaseStart >= gInterval) {
+                phaseStart = now;
+                if (!ledOn) {
+                    fill(LIFI_MARKER[markerIndex]);
+                    ledOn = true;
+                } else {
+                    stripOff();
+                    if (++darkSlots >= LIFI_SLOTS_PER_PULSE - 1) {
+                        darkSlots = 0;
+                        ledOn = false;
+                        if (++markerIndex >= LIFI_MARKER_PULSES) {
+                            markerIndex = 0;
+                            bitIndex = LIFI_PAYLOAD_BITS - 1;
+                            state = BS_BIT_ON;
+                        }
+                    }
+                }
+            }
+            break;
+
+        case BS_BIT_ON:
+            if (now - phaseStart >= gInterval) {
+                phaseStart = now;
+                if (bitIndex >= 0) {
+                    if (ledOn) {
+                        stripOff();
+                        if (++darkSlots >= LIFI_SLOTS_PER_PULSE - 1) {
+                            darkSlots = 0;
+                            ledOn = false;
+                            bitIndex--;
+                        }
+                    } else {
+                        fill(LIFI_BIT_COLOR[(message[size_t(charIndex)] >> bitIndex) & 0x01]);
+                        ledOn = true;
+                    }
+                } else if (++darkSlots >= LIFI_GAP_SLOTS) {
+                    // Character done; the firmware wraps to the first one
+                    stripOff();
+                    sentChars++;
+                    if (++charIndex >= int(message.size())) charIndex = 0;
+                    state = BS_START_MARKER;
+                    markerIndex = 0;
+                    bitIndex = LIFI_PAYLOAD_BITS - 1;
+                    darkSlots = 0;
+                    ledOn = false;
+                    phaseStart = now;
+                }
+            }
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// LedTimeline
+
+LedTimeline LedTimeline::record(TextTransmitter& tx, uint32_t durationMs) {
+    LedTimeline t;
+    for (uint32_t ms = 0; ms <= durationMs; ++ms) {
+        tx.poll(ms);
+        t.add(double(ms), tx.color());
+    }
+    return t;
+}
+
+void LedTimeline::add(double tMs, const LedColor& c) {
+    endMs = std::max(endMs, tMs);
+    if (!steps.empty()) {
+        const LedColor& last = steps.back().color;
+        if (last.r == c.r && last.g == c.g && last.b == c.b) return;
+    }
+    steps.push_back(Change{tMs, c});
+}
+
+size_t LedTimeline::find(double tMs) const {
+    auto it = std::upper_bound(steps.begin(), steps.end(), tMs,
+                               [](double t, const Change& s) { return t < s.tMs; });
+    return it == steps.begin() ? 0 : size_t(it - steps.begin()) - 1;
+}
+
+LedColor LedTimeline::at(double tMs) const {
+    return steps.empty() ? LedColor{} : steps[find(tMs)].color;
+}
+
+LedColor LedTimeline::average(double t0, double t1) const {
+    if (steps.empty()) return LedColor{};
+    if (t1 <= t0) return at(t0);
+
+    double r = 0.0, g = 0.0, b = 0.0;
+    for (size_t i = find(t0); i < steps.size(); ++i) {
+        const double a = std::max(t0, i == 0 ? t0 : steps[i].tMs);
+        const double e = i + 1 < steps.size() ? std::min(t1, steps[i + 1].tMs) : t1;
+        if (e > a) {
+            r += steps[i].color.r * (e - a);
+            g += steps[i].color.g * (e - a);
+            b += steps[i].color.b * (e - a);
+        }
+        if (e >= t1) break;
+    }
+    const double inv = 1.0 / (t1 - t0);
+    return LedColor{float(r * inv), float(g * inv), float(b * inv)};
+}
+
+// ---------------------------------------------------------------------------
+// ChannelSim
+
+ChannelSim::ChannelSim(const ChannelConfig& config, const LedTimeline& tl)
+        : cfg(config), timeline(tl), rng(config.seed) {
+    // 4:2:0 wants even dimensions
+    cfg.width  = std::max(2, cfg.width & ~1);
+    cfg.height = std::max(2, cfg.height & ~1);
+    cfg.pixelStride = cfg.pixelStride == 1 ? 1 : 2;
+    cfg.rowPad = std::max(0, cfg.rowPad);
+    if (cfg.fps <= 0.0) cfg.fps = 30.0;
+
+    const double g = cfg.gamma > 0.0 ? 1.0 / cfg.gamma : 1.0;
+    for (int i = 0; i < 4096; ++i) {
+        toCode[i] = clampCode(float(255.0 * std::pow(i / 4095.0, g)));
+    }
+
+    rowLed.resize(size_t(cfg.height));
+    rowAmbient.resize(size_t(cfg.height));
+    rgb.resize(size_t(cfg.width) * 3 * 2);
+    buildMask();
+}
+
+void ChannelSim::bounds(int& x0, int& y0, int& w, int& h) const {
+    x0 = boxX;
+    y0 = boxY;
+    w = boxW;
+    h = boxH;
+}
+
+void ChannelSim::buildMask() {
+    if (cfg.blobs.empty()) {
+        boxX = boxY = boxW = boxH = 0;
+        mask.clear();
+        return;
+    }
+
+    const float soft = float(std::max(0.0, cfg.blurPx));
+    int x0 = cfg.width, y0 = cfg.height, x1 = 0, y1 = 0;
+    for (const LedBlob& b : cfg.blobs) {
+        const float reach = b.radius + soft * 0.5f + 1.f;
+        x0 = std::min(x0, int(std::floor(b.x - reach)));
+        y0 = std::min(y0, int(std::floor(b.y - reach)));
+        x1 = std::max(x1, int(std::ceil(b.x + reach)));
+        y1 = std::max(y1, int(std::ceil(b.y + reach)));
+    }
+    boxX = std::max(0, x0);
+    boxY = std::max(0, y0);
+    boxW = std::max(0, std::min(cfg.width, x1) - boxX);
+    boxH = std::max(0, std::min(cfg.height, y1) - boxY);
+
+    // Disk with a linear edge ramp `soft` pixels wide, standing in for the
+    // lens blur and the diffuser
+    mask.assign(size_t(boxW) * boxH * 3, 0.f);
+    for (const LedBlob& b : cfg.blobs) {
+        for (int r = 0; r < boxH; ++r) {
+            for (int c = 0; c < boxW; ++c) {
+                const float dx = boxX + c + 0.5f - b.x, dy = boxY + r + 0.5f - b.y;
+                const float d = std::sqrt(dx * dx + dy * dy);
+                float k;
+                if (soft > 0.f) k = std::min(1.f, std::max(0.f, (b.radius + soft * 0.5f - d) / soft));
+                else k = d < b.radius ? 1.f : 0.f;
+                if (k == 0.f) continue;
+                float* m = &mask[(size_t(r) * boxW + c) * 3];
+                m[0] += k * b.tint.r;
+                m[1] += k * b.tint.g;
+                m[2] += k * b.tint.b;
+            }
+        }
+    }
+}
+
+inline uint8_t ChannelSim::encode(float linear) const {
+    const int i = linear <= 0.f ? 0 : linear >= 1.f ? 4095 : int(linear * 4095.f + 0.5f);
+    return toCode[i];
+}
+
+bool ChannelSim::next(SimFrame& out) {
+    const int W = cfg.width, H = cfg.height;
+    const double period = 1000.0 / cfg.fps;
+
+    // Frame start with jitter, kept monotonic
+    std::normal_distribution<double> jitter(0.0, std::max(0.0, cfg.jitterMs));
+    double start = frame * period + (cfg.jitterMs > 0.0 ? jitter(rng) : 0.0);
+    if (start < 0.0) start = 0.0;
+    if (frame > 0) start = std::max(start, lastStart + 0.1);
+    const double rowTime = H > 1 ? cfg.readoutMs / (H - 1) : 0.0;
+    if (start + cfg.readoutMs + cfg.exposureMs > timeline.duration()) return false;
+
+    // Rolling shutter: every row integrates its own window
+    for (int r = 0; r < H; ++r) {
+        const double t0 = start + r * rowTime, t1 = t0 + cfg.exposureMs;
+        LedColor led = timeline.average(t0, t1);
+        led.r *= float(cfg.ledGain);
+        led.g *= float(cfg.ledGain);
+        led.b *= float(cfg.ledGain);
+        rowLed[size_t(r)] = led;
+        rowAmbient[size_t(r)] =
+                float(cfg.ambient * (1.0 + cfg.flickerDepth * meanSin(cfg.flickerHz, t0, t1)));
+    }
+
+    // Output buffers, same layout as the bench frames
+    const int cw = W / 2, ch = H / 2;
+    out.width = W;
+    out.height = H;
+    out.yRowStride = W + cfg.rowPad;
+    out.uvPixelStride = cfg.pixelStride;
+    out.uvRowStride = (cfg.pixelStride == 1 ? cw : W) + cfg.rowPad;
+    out.timestampNs = int64_t(start * 1e6);
+    out.y.assign(size_t(out.yRowStride) * H, 0);
+    out.chroma.assign(size_t(out.uvRowStride) * ch * (cfg.pixelStride == 1 ? 2 : 1) + 1, 128);
+    uint8_t* u = cfg.pixelStride == 1 ? out.chroma.data() : out.chroma.data() + 1;
+    uint8_t* v = cfg.pixelStride == 1 ? out.chroma.data() + size_t(out.uvRowStride) * ch
+                                      : out.chroma.data();
+    out.u = u;
+    out.v = v;
+
+    std::normal_distribution<float> noiseY(0.f, float(std::max(0.0, cfg.noiseY)));
+    std::normal_distribution<float> noiseC(0.f, float(std::max(0.0, cfg.noiseC)));
+    const bool addY = cfg.noiseY > 0.0, addC = cfg.noiseC > 0.0;
+
+    for (int pr = 0; pr < ch; ++pr) {
+        // Sensor RGB codes for the two rows of this chroma row
+        for (int k = 0; k < 2; ++k) {
+            const int r = 2 * pr + k;
+            const float amb = rowAmbient[size_t(r)];
+            const LedColor& led = rowLed[size_t(r)];
+            const bool inBox = r >= boxY && r < boxY + boxH;
+            float* px = &rgb[size_t(k) * W * 3];
+            uint8_t* yRow = &out.y[size_t(r) * out.yRowStride];
+
+            for (int c = 0; c < W; ++c) {
+                float lr = amb, lg = amb, lb = amb;
+                if (inBox && c >= boxX && c < boxX + boxW) {
+                    const float* m = &mask[(size_t(r - boxY) * boxW + (c - boxX)) * 3];
+                    lr += m[0] * led.r;
+                    lg += m[1] * led.g;
+                    lb += m[2] * led.b;
+                }
+                const float R = encode(lr), G = encode(lg), B = encode(lb);
+                px[3 * c] = R;
+                px[3 * c + 1] = G;
+                px[3 * c + 2] = B;
+
+                // BT.601 full range, the inverse of YUVPixel_to_HSV
+                float Y = 0.299f * R + 0.587f * G + 0.114f * B;
+                if (addY) Y += noiseY(rng);
+                yRow[c] = clampCode(Y);
+            }
+        }
+
+        // 2x2 box filter down to the chroma grid
+        const float* a = rgb.data();
+        const float* b = rgb.data() + size_t(W) * 3;
+        for (int pc = 0; pc < cw; ++pc) {
+            const int i = 6 * pc;
+            const float R = 0.25f * (a[i]     + a[i + 3] + b[i]     + b[i + 3]);
+            const float G = 0.25f * (a[i + 1] + a[i + 4] + b[i + 1] + b[i + 4]);
+            const float B = 0.25f * (a[i + 2] + a[i + 5] + b[i + 2] + b[i + 5]);
+            const float Y = 0.299f * R + 0.587f * G + 0.114f * B;
+            float U = 128.f + (B - Y) / 1.772f;
+            float V = 128.f + (R - Y) / 1.402f;
+            if (addC) {
+                U += noiseC(rng);
+                V += noiseC(rng);
+            }
+            const size_t at = size_t(pr) * out.uvRowStride + size_t(pc) * cfg.pixelStride;
+            u[at] = clampCode(U);
+            v[at] = clampCode(V);
+        }
+    }
+
+    lastStart = start;
+    frame++;
+    return true;
+}
@@ -0,0 +1,185 @@
+#ifndef CHANNEL_SIM_H
+#define CHANNEL_SIM_H
+
+#include "lifi_protocol.h"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Synthetic optical channel: renders the YUV_420_888 frames a phone camera
+// would see while the ESP32 strip transmits a message.
+//
+//   TextTransmitter   host port of the firmware's original polled processTextState,
+//                     the reference esp32Codenew/fully_working/symbol_engine is
+//                     checked against (lifi_tx_engine_check)
+//   LedTimeline       strip colour over time, sampled from the transmitter
+//   ChannelSim        camera model: frame timing with jitter, rolling-shutter
+//                     exposure integration per row, blurred LED blobs, ambient
+//                     light with mains flicker, sensor noise, 4:2:0 chroma
+//
+// Everything is deterministic for a given seed, so a decoder change can be
+// compared on exactly the same frames.
+
+// Strip colour, linear 0..1 per channel
+struct LedColor {
+    float r = 0.f, g = 0.f, b = 0.f;
+};
+
+// Colours the firmware shows, after FastLED.setBrightness(150)
+constexpr float TX_BRIGHTNESS = 150.f / 255.f;
+
+// Port of the firmware's BS_* text state machine. poll() is one pass of
+// loop(); the firmware calls it continuously, so callers should poll at
+// least once per millisecond of simulated time.
+//
+// The character layout comes from lifi_protocol.h (for the original
+// firmware: three red and three blue marker pulses, 8 bits MSB first with
+// red = 1 and blue = 0, each pulse lit for one interval and dark for one,
+// one more dark interval). The message repeats forever.
+class TextTransmitter {
+public:
+    // Mirrors the BLE text write: resets the machine and starts sending at nowMs.
+    // Intervals under LIFI_MIN_INTERVAL_MS fall back to the default like the firmware.
+    void send(const std::vector<uint8_t>& message, uint16_t intervalMs, uint32_t nowMs);
+
+    void poll(uint32_t nowMs);
+
+    bool lit() const { return on; }
+    LedColor color() const { return shown; }
+    uint16_t interval() const { return gInterval; }
+
+    // Characters fully sent so far (counts up across repeats)
+    uint64_t charactersSent() const { return sentChars; }
+
+private:
+    enum State { BS_IDLE, BS_START_MARKER, BS_BIT_ON };
+
+    std::vector<uint8_t> message;
+    uint16_t gInterval = LIFI_DEFAULT_INTERVAL_MS;
+    State state = BS_IDLE;
+    uint32_t phaseStart = 0;
+    int charIndex = 0;
+    int bitIndex = LIFI_PAYLOAD_BITS - 1;
+    int markerIndex = 0;
+    int darkSlots = 0;
+    bool ledOn = false;
+    bool newMessage = false;
+
+    bool on = false;
+    LedColor shown;
+    uint64_t sentChars = 0;
+
+    void stripOff();
+    void fill(uint8_t slot);
+};
+
+// Piecewise-constant strip colour: one entry per change, in time order.
+class LedTimeline {
+public:
+    struct Change {
+        double tMs;
+        LedColor color;
+    };
+
+    // Runs `tx` from 0 to durationMs, polling every millisecond like loop().
+    static LedTimeline record(TextTransmitter& tx, uint32_t durationMs);
+
+    void add(double tMs, const LedColor& color);
+
+    double duration() const { return endMs; }
+    const std::vector<Change>& changes() const { return steps; }
+
+    // Colour at time t
+    LedColor at(double tMs) const;
+
+    // Mean colour over [t0, t1)
+    LedColor average(double t0, double t1) const;
+
+private:
+    std::vector<Change> steps;
+    double endMs = 0.0;
+
+    size_t find(double tMs) const;
+};
+
+// One LED blob in the image, in pixels. `tint` scales the strip colour, for
+// strips seen through a diffuser or at an angle.
+struct LedBlob {
+    float x = 0.f, y = 0.f;
+    float radius = 20.f;
+    LedColor tint{1.f, 1.f, 1.f};
+};
+
+struct ChannelConfig {
+    int width = 640;
+    int height = 480;
+    int pixelStride = 2;        // 2 = interleaved chroma (most phones), 1 = planar
+    int rowPad = 0;             // bytes of padding after each row
+
+    double fps = 30.0;
+    double jitterMs = 1.0;      // s.d. of frame start time
+    double exposureMs = 8.0;
+    double readoutMs = 20.0;    // rolling shutter: first to last row start
+
+    double blurPx = 2.0;        // width of the soft blob edge
+    double ledGain = 1.6;       // LED at full colour, relative to sensor clip
+    double ambient = 0.10;      // background level, 0..1
+    double flickerDepth = 0.0;  // ambient modulation, 0..1
+    double flickerHz = 100.0;   // 2x mains
+    double noiseY = 2.0;        // s.d. in 8-bit code values
+    double noiseC = 1.0;
+    double gamma = 2.2;
+
+    uint32_t seed = 1;
+    std::vector<LedBlob> blobs;
+};
+
+// One rendered frame, laid out the way ImageFormat.YUV_420_888 hands it over
+struct SimFrame {
+    int width = 0, height = 0;
+    int yRowStride = 0, uvRowStride = 0, uvPixelStride = 1;
+    int64_t timestampNs = 0;
+    std::vector<uint8_t> y, chroma;
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+};
+
+class ChannelSim {
+public:
+    ChannelSim(const ChannelConfig& config, const LedTimeline& timeline);
+
+    // Renders the next frame into `out`, reusing its buffers. Returns false
+    // once the frame's exposure would run past the end of the timeline.
+    bool next(SimFrame& out);
+
+    int frameIndex() const { return frame; }
+
+    // Strip colour integrated by `row` of the last frame, LED gain applied;
+    // the ground truth for that frame
+    LedColor exposed(int row) const { return rowLed[size_t(row)]; }
+
+    // Bounding box of the blobs, for the decoder ROI
+    void bounds(int& x0, int& y0, int& w, int& h) const;
+
+private:
+    ChannelConfig cfg;
+    const LedTimeline& timeline;
+    std::mt19937 rng;
+    int frame = 0;
+    double lastStart = 0.0;
+
+    // Blob coverage per pixel inside the bounding box, tint applied, RGB
+    int boxX = 0, boxY = 0, boxW = 0, boxH = 0;
+    std::vector<float> mask;
+
+    uint8_t toCode[4096];           // linear 0..1 -> gamma-encoded 8-bit
+    std::vector<float> rgb;         // sensor RGB of the two rows under one chroma row
+    std::vector<LedColor> rowLed;   // exposure-averaged strip colour per row
+    std::vector<float> rowAmbient;
+
+    void buildMask();
+    uint8_t encode(float linear) const;
+};
+
+#endif // CHANNEL_SIM_H
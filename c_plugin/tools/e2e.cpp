@@ -0,0 +1,318 @@
+// End-to-end link benchmark: transmitter -> optical channel -> decoder.
+//
+//   lifi_e2e [--quick] [--text MSG] [--size WxH] [--seed N] [--format csv|json]
+//   lifi_e2e --capture rx.lfc --text MSG [--format csv|json]
+//
+// The first form sweeps symbol interval, frame rate, LED size (and with it
+// the ROI) and sensor noise. Each case runs the message once through the
+// host port of the firmware's processTextState, renders it with ChannelSim,
+// and decodes every frame with lifi_session_process_frame_color followed by
+// SymbolDecoder, the port of the app's grouping and marker logic. The second
+// form scores a real capture instead, with the message it was sent.
+//
+// Per case:
+//   goodput_bps  correctly decoded bits per second of air time
+//   ber          bit errors / bits, over characters aligned to a sent one
+//   cer          (substituted + lost + spurious characters) / characters sent
+//   ttfb_ms      from the start of the transmission (first frame for a
+//                capture) to the frame that completed the first correct byte
+//   ns_per_frame mean CPU time of process_frame_color + SymbolDecoder
+//
+// Characters are matched with an edit-distance alignment, so a lost or
+// spurious character costs one error instead of shifting every later one.
+// A capture is aligned against the message repeated, starting anywhere.
+
+#include "c_plugin.h"
+#include "capture_file.h"
+#include "channel_sim.h"
+#include "symbol_decoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Decoded {
+    std::vector<uint8_t> bytes;
+    std::vector<double> atMs;       // frame time that completed each byte
+    int frames = 0;
+    double spanMs = 0.0;            // air time covered by the frames
+    double decodeNs = 0.0;
+};
+
+struct Score {
+    int sent = 0, decoded = 0, correct = 0;
+    int substituted = 0, lost = 0, spurious = 0;
+    long bitErrors = 0, bits = 0;
+    double ttfbMs = -1.0;
+};
+
+int popcount8(unsigned v) {
+    int n = 0;
+    for (; v; v &= v - 1) ++n;
+    return n;
+}
+
+// Edit-distance alignment of `got` against `ref`. With freeEnds the
+// alignment may start and stop anywhere in `ref` (a capture of a repeating
+// message); otherwise all of `ref` must be accounted for.
+Score align(const Decoded& got, const std::vector<uint8_t>& ref, bool freeEnds) {
+    const size_t n = got.bytes.size(), m = ref.size();
+    std::vector<int> d((n + 1) * (m + 1));
+    auto at = [&](size_t i, size_t j) -> int& { return d[i * (m + 1) + j]; };
+
+    for (size_t j = 0; j <= m; ++j) at(0, j) = freeEnds ? 0 : int(j);
+    for (size_t i = 1; i <= n; ++i) {
+        at(i, 0) = int(i);
+        for (size_t j = 1; j <= m; ++j) {
+            const int sub = at(i - 1, j - 1) + (got.bytes[i - 1] != ref[j - 1]);
+            at(i, j) = std::min({sub, at(i - 1, j) + 1, at(i, j - 1) + 1});
+        }
+    }
+
+    size_t i = n, j = m;
+    if (freeEnds) {
+        for (size_t k = 0; k <= m; ++k) {
+            if (at(n, k) < at(n, j)) j = k;
+        }
+    }
+
+    Score s;
+    s.decoded = int(n);
+    const size_t end = j;
+    int firstCorrect = -1;
+    while (i > 0 && j > 0) {
+        const bool same = got.bytes[i - 1] == ref[j - 1];
+        if (at(i, j) == at(i - 1, j - 1) + !same) {
+            if (same) {
+                s.correct++;
+                firstCorrect = int(i - 1);
+            } else {
+                s.substituted++;
+            }
+            s.bitErrors += popcount8(got.bytes[i - 1] ^ ref[j - 1]);
+            s.bits += 8;
+            --i;
+            --j;
+        } else if (at(i, j) == at(i - 1, j) + 1) {
+            s.spurious++;
+            --i;
+        } else {
+            s.lost++;
+            --j;
+        }
+    }
+    s.spurious += int(i);
+    if (!freeEnds) s.lost += int(j);
+    s.sent = freeEnds ? int(end - j) : int(m);
+    if (firstCorrect >= 0) s.ttfbMs = got.atMs[size_t(firstCorrect)];
+    return s;
+}
+
+// Plane pointers of a SimFrame or a mapped capture record, in one shape
+struct FrameRef {
+    const uint8_t *y, *u, *v;
+    int width, height, yRowStride, uvRowStride, uvPixelStride;
+};
+
+// Runs one frame through the receiver, timing only the decoder side
+void decodeFrame(lifi_session* session, SymbolDecoder& rx, const FrameRef& f, int count,
+                 int x0, int y0, int w, int h, double tMs, Decoded& out) {
+    double values[7];
+    const auto t0 = Clock::now();
+    lifi_session_process_frame_color(session, f.y, f.u, f.v, f.width, f.height, count,
+                                     f.yRowStride, f.uvRowStride, f.uvPixelStride,
+                                     x0, y0, w, h, values);
+    const int byte = rx.push(values);
+    out.decodeNs += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+    out.frames++;
+    if (byte >= 0) {
+        out.bytes.push_back(uint8_t(byte));
+        out.atMs.push_back(tMs);
+    }
+}
+
+struct Case {
+    int intervalMs;
+    double fps;
+    float radius;
+    double noise;
+};
+
+Decoded runSimulated(const Case& c, const std::vector<uint8_t>& msg, int width, int height,
+                     uint32_t seed, int& roi) {
+    TextTransmitter tx;
+    tx.send(msg, uint16_t(c.intervalMs), 0);
+    ChannelConfig cfg;
+    cfg.width = width;
+    cfg.height = height;
+    cfg.fps = c.fps;
+    cfg.noiseY = c.noise;
+    cfg.noiseC = c.noise * 0.5;
+    cfg.seed = seed;
+    LedBlob blob;
+    blob.x = width * 0.5f;
+    blob.y = height * 0.5f;
+    blob.radius = c.radius;
+    cfg.blobs.push_back(blob);
+
+    // One character is 29 intervals; leave a few more for the last decode
+    const uint32_t durationMs = uint32_t((double(msg.size()) * 29 + 4) * tx.interval() +
+                                         cfg.readoutMs + cfg.exposureMs);
+    LedTimeline timeline = LedTimeline::record(tx, durationMs);
+    ChannelSim sim(cfg, timeline);
+    int x0, y0, w, h;
+    sim.bounds(x0, y0, w, h);
+    roi = w;
+
+    lifi_session* session = lifi_session_create(width, height);
+    SymbolDecoder rx;
+    Decoded out;
+    SimFrame f;
+    while (sim.next(f)) {
+        FrameRef ref{f.y.data(), f.u, f.v, f.width, f.height,
+                     f.yRowStride, f.uvRowStride, f.uvPixelStride};
+        const double tMs = f.timestampNs / 1e6 + cfg.exposureMs;
+        decodeFrame(session, rx, ref, sim.frameIndex() - 1, x0, y0, w, h, tMs, out);
+        out.spanMs = tMs;
+    }
+    lifi_session_destroy(session);
+    return out;
+}
+
+Decoded runCapture(const CaptureReader& reader, int& roi) {
+    lifi_session* session = lifi_session_create(reader.maxWidth(), reader.maxHeight());
+    SymbolDecoder rx;
+    Decoded out;
+    double t0 = 0.0;
+    roi = 0;
+    for (size_t i = 0; i < reader.size(); ++i) {
+        CaptureFrame f = reader.frame(i);
+        const CaptureFrameHeader& hd = *f.info;
+        FrameRef ref{f.y, f.u, f.v, hd.width, hd.height,
+                     hd.yRowStride, hd.uvRowStride, hd.uvPixelStride};
+        const double tMs = hd.timestampNs / 1e6;
+        if (i == 0) t0 = tMs;
+        roi = std::max(roi, int(hd.roiW));
+        decodeFrame(session, rx, ref, int(i), hd.roiX, hd.roiY, hd.roiW, hd.roiH, tMs - t0, out);
+        out.spanMs = tMs - t0;
+    }
+    lifi_session_destroy(session);
+    return out;
+}
+
+enum class Format { CSV, JSON };
+
+void report(Format fmt, const char* source, const Case& c, int roi, const Decoded& d, const Score& s) {
+    const double ber = s.bits ? double(s.bitErrors) / s.bits : 1.0;
+    const double cer = s.sent ? double(s.substituted + s.lost + s.spurious) / s.sent : 1.0;
+    const double goodput = d.spanMs > 0 ? s.correct * 8 / (d.spanMs / 1e3) : 0.0;
+    const double nsPerFrame = d.frames ? d.decodeNs / d.frames : 0.0;
+    if (fmt == Format::CSV) {
+        std::printf("%s,%d,%.1f,%d,%.1f,%d,%d,%d,%d,%.5f,%.4f,%.2f,%.0f,%.0f\n",
+                    source, c.intervalMs, c.fps, roi, c.noise, d.frames,
+                    s.sent, s.decoded, s.correct, ber, cer, goodput, s.ttfbMs, nsPerFrame);
+    } else {
+        std::printf("{\"source\":\"%s\",\"interval_ms\":%d,\"fps\":%.1f,\"roi\":%d,\"noise\":%.1f,"
+                    "\"frames\":%d,\"sent\":%d,\"decoded\":%d,\"correct\":%d,\"ber\":%.5f,"
+                    "\"cer\":%.4f,\"goodput_bps\":%.2f,\"ttfb_ms\":%.0f,\"ns_per_frame\":%.0f}\n",
+                    source, c.intervalMs, c.fps, roi, c.noise, d.frames,
+                    s.sent, s.decoded, s.correct, ber, cer, goodput, s.ttfbMs, nsPerFrame);
+    }
+    std::fflush(stdout);
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s [--quick] [--text MSG] [--size WxH] [--seed N] [--format csv|json]\n"
+                 "       %s --capture rx.lfc --text MSG [--format csv|json]\n",
+                 argv0, argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    Format fmt = Format::CSV;
+    std::string text = "LiFi 0123";
+    const char* capture = nullptr;
+    int width = 320, height = 240;
+    uint32_t seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--quick")) {
+            quick = true;
+        } else if (!std::strcmp(argv[i], "--text") && i + 1 < argc) {
+            text = argv[++i];
+        } else if (!std::strcmp(argv[i], "--capture") && i + 1 < argc) {
+            capture = argv[++i];
+        } else if (!std::strcmp(argv[i], "--size") && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2) { usage(argv[0]); return 2; }
+        } else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(argv[i], "--format") && i + 1 < argc) {
+            std::string f = argv[++i];
+            if (f == "json") fmt = Format::JSON;
+            else if (f != "csv") { usage(argv[0]); return 2; }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    const std::vector<uint8_t> msg(text.begin(), text.end());
+    if (msg.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    lifi_trace_enable(0);
+    if (fmt == Format::CSV) {
+        std::printf("source,interval_ms,fps,roi,noise,frames,sent,decoded,correct,"
+                    "ber,cer,goodput_bps,ttfb_ms,ns_per_frame\n");
+    }
+
+    if (capture) {
+        CaptureReader reader;
+        if (!reader.open(capture)) {
+            std::fprintf(stderr, "%s: not a readable capture\n", capture);
+            return 1;
+        }
+        int roi = 0;
+        Decoded d = runCapture(reader, roi);
+        std::vector<uint8_t> ref;
+        for (size_t k = 0; k < d.bytes.size() / msg.size() + 2; ++k) {
+            ref.insert(ref.end(), msg.begin(), msg.end());
+        }
+        Score s = align(d, ref, true);
+        report(fmt, "capture", Case{0, d.spanMs > 0 ? d.frames * 1e3 / d.spanMs : 0.0, 0.f, 0.0},
+               roi, d, s);
+        return 0;
+    }
+
+    std::vector<int> intervals  = quick ? std::vector<int>{99} : std::vector<int>{66, 99, 132};
+    std::vector<double> rates   = quick ? std::vector<double>{30} : std::vector<double>{30, 60};
+    std::vector<float> radii    = quick ? std::vector<float>{40} : std::vector<float>{16, 40};
+    std::vector<double> noises  = {2, 8};
+
+    for (int interval : intervals) {
+        for (double fps : rates) {
+            for (float radius : radii) {
+                for (double noise : noises) {
+                    Case c{interval, fps, radius, noise};
+                    std::fprintf(stderr, "interval=%d fps=%.0f radius=%.0f noise=%.0f\n",
+                                 interval, fps, double(radius), noise);
+                    int roi = 0;
+                    Decoded d = runSimulated(c, msg, width, height, seed, roi);
+                    report(fmt, "sim", c, roi, d, align(d, msg, false));
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Integral images against a scalar reference.
+//
+//   lifi_integral_check [--frames N] [--seed N]
+//
+// Checks that:
+//
+//   sum        IntegralImage::build (NEON/SSE2 when available) gives the
+//              same rectangle sums as adding the pixels up one by one, over
+//              random regions, strides and rectangles, odd widths included
+//   count      buildCount gives the same counts above a random threshold
+//   threads    lifi_integral_build/_mean and lifi_detect_leds_on give each
+//              thread its own frame's answers while other threads run them
+//              on different frames
+//
+// Exits 1 if any check fails.
+
+#include "c_plugin.h"
+#include "integral_image.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+bool report(const char* name, bool ok, const std::string& detail) {
+    std::printf("  %-10s %s  %s\n", name, ok ? "ok  " : "FAIL", detail.c_str());
+    return ok;
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr, "usage: %s [--frames N] [--seed N]\n", argv0);
+}
+
+uint64_t referenceSum(const std::vector<uint8_t>& plane, int stride, int x, int y, int w, int h,
+                      int threshold) {
+    uint64_t total = 0;
+    for (int r = y; r < y + h; ++r) {
+        for (int c = x; c < x + w; ++c) {
+            const uint8_t p = plane[size_t(r) * stride + c];
+            total += threshold < 0 ? p : uint64_t(p > threshold);
+        }
+    }
+    return total;
+}
+
+// One scalar-vs-table comparison pass; returns the number of mismatches
+int compareTables(std::mt19937& rng, int frames, bool count, int& rects) {
+    int bad = 0;
+    IntegralImage table;
+    for (int f = 0; f < frames; ++f) {
+        const int width = 1 + int(rng() % 157), height = 1 + int(rng() % 61);
+        const int stride = width + int(rng() % 9);
+        std::vector<uint8_t> plane(size_t(stride) * height);
+        for (uint8_t& p : plane) p = uint8_t(rng());
+
+        const int x0 = int(rng() % width), y0 = int(rng() % height);
+        const int w = 1 + int(rng() % (width - x0)), h = 1 + int(rng() % (height - y0));
+        const int threshold = count ? int(rng() % 256) : -1;
+        const uint8_t* origin = plane.data() + size_t(y0) * stride + x0;
+        if (count) {
+            table.buildCount(origin, stride, x0, y0, w, h, uint8_t(threshold));
+        } else {
+            table.build(origin, stride, x0, y0, w, h);
+        }
+
+        for (int k = 0; k < 32; ++k, ++rects) {
+            const int x = x0 + int(rng() % w), y = y0 + int(rng() % h);
+            const int rw = 1 + int(rng() % (x0 + w - x)), rh = 1 + int(rng() % (y0 + h - y));
+            if (table.sum(x, y, rw, rh) != referenceSum(plane, stride, x, y, rw, rh, threshold)) ++bad;
+        }
+    }
+    return bad;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int frames = 2000;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--frames") && i + 1 < argc) {
+            frames = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = unsigned(std::atoi(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::printf("%d random frames per check\n", frames);
+    bool ok = true;
+    std::mt19937 rng(seed);
+
+    {
+        int rects = 0;
+        const int bad = compareTables(rng, frames, false, rects);
+        ok &= report("sum", bad == 0, std::to_string(bad) + " of " + std::to_string(rects) + " rectangles differ");
+    }
+    {
+        int rects = 0;
+        const int bad = compareTables(rng, frames, true, rects);
+        ok &= report("count", bad == 0, std::to_string(bad) + " of " + std::to_string(rects) + " rectangles differ");
+    }
+
+    // threads: every thread owns a flat frame of its own brightness, so any
+    // table shared between threads shows up as another thread's mean
+    {
+        const int W = 96, H = 64, threads = 4, rounds = std::max(50, frames / 4);
+        std::atomic<int> bad{0};
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t] {
+                const uint8_t level = uint8_t(40 + 50 * t);
+                std::vector<uint8_t> frame(size_t(W) * H * 3 / 2, level);
+                lifi_frame_desc desc;
+                std::memset(&desc, 0, sizeof(desc));
+                desc.version = LIFI_ABI_VERSION;
+                desc.format = LIFI_FORMAT_NV21;
+                desc.y_plane = frame.data();
+                desc.width = W;
+                desc.height = H;
+                // Two LEDs, so the shared-table path of detect_leds_on runs
+                lifi_roi rois[2] = {{0, 0, 8, 8}, {40, 20, 8, 8}};
+                desc.rois = rois;
+                desc.roi_count = 2;
+                // LED "on" only for the brighter half of the threads
+                const uint8_t expectOn = level > 120 ? 1 : 0;
+                for (int r = 0; r < rounds; ++r) {
+                    lifi_integral_build(frame.data(), W, H, W, 0, 0, W, H, -1);
+                    uint8_t on[2] = {0, 0};
+                    lifi_detect_leds_on(&desc, 120, on);
+                    if (lifi_integral_mean(4, 4, 32, 32) != double(level)) ++bad;
+                    if (on[0] != expectOn || on[1] != expectOn) ++bad;
+                }
+            });
+        }
+        for (std::thread& th : pool) th.join();
+        ok &= report("threads", bad.load() == 0,
+                     std::to_string(bad.load()) + " wrong answers over " + std::to_string(threads) +
+                     " threads x " + std::to_string(rounds) + " rounds");
+    }
+
+    return ok ? 0 : 1;
+}
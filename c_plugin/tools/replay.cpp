@@ -0,0 +1,90 @@
+// Replays a .lfc capture (lifi_recorder_*) through process_frame_color.
+//
+//   lifi_replay capture.lfc [--repeat N] [--out decoded.csv]
+//
+// Frames are fed straight from the mapped file to a fresh decoder session,
+// so the same capture always decodes to the same CSV; diff two builds'
+// output to spot regressions. --repeat reruns the capture (new session each
+// time) for timing; the CSV is written for the first pass only.
+
+#include "c_plugin.h"
+#include "capture_file.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    const char* outPath = nullptr;
+    int repeat = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path) {
+        std::fprintf(stderr, "usage: %s <capture.lfc> [--repeat N] [--out decoded.csv]\n", argv[0]);
+        return 2;
+    }
+
+    CaptureReader reader;
+    if (!reader.open(path)) {
+        std::fprintf(stderr, "%s: not a readable capture\n", path);
+        return 1;
+    }
+    std::fprintf(stderr, "%s: %zu frames, up to %dx%d\n",
+                 path, reader.size(), reader.maxWidth(), reader.maxHeight());
+
+    FILE* out = outPath ? std::fopen(outPath, "w") : stdout;
+    if (!out) {
+        std::perror(outPath);
+        return 1;
+    }
+    std::fprintf(out, "frame,timestamp_ns,count,y,dyn_min,dyn_max,hue,sat,color,encoded\n");
+
+    lifi_trace_enable(0);
+    double totalNs = 0.0;
+    for (int pass = 0; pass < repeat; ++pass) {
+        lifi_session* session = lifi_session_create(reader.maxWidth(), reader.maxHeight());
+        double out7[7];
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < reader.size(); ++i) {
+            CaptureFrame f = reader.frame(i);
+            const CaptureFrameHeader& h = *f.info;
+            lifi_session_process_frame_color(
+                    session, f.y, f.u, f.v,
+                    h.width, h.height, h.count,
+                    h.yRowStride, h.uvRowStride, h.uvPixelStride,
+                    h.roiX, h.roiY, h.roiW, h.roiH,
+                    out7);
+
+            if (pass == 0) {
+                std::fprintf(out, "%zu,%" PRId64 ",%d,%.4f,%.4f,%.4f,%.2f,%.4f,%d,%d\n",
+                             i, h.timestampNs, h.count, out7[0], out7[1], out7[2],
+                             out7[3], out7[4], int(out7[5]), int(out7[6]));
+            }
+        }
+        totalNs += std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - t0).count();
+        lifi_session_destroy(session);
+    }
+
+    if (out != stdout) std::fclose(out);
+    if (reader.size() > 0) {
+        std::fprintf(stderr, "%.0f ns/frame over %d pass(es)\n",
+                     totalNs / (double(reader.size()) * repeat), repeat);
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Multi-ROI scaling of lifi_process_frame_color_multi.
+//
+//   lifi_scaling [--quick] [--min-ms N] [--roi PX] [--max-threads N] > scaling.csv
+//
+// Decodes 1 to 32 ROIs (one session each) of a 1080p YUV_420_888 frame
+// with the pool sized 1 to N threads (N = hardware threads unless given)
+// and prints the median wall time per frame, the speedup over one thread
+// and the parallel efficiency. With enough cores, 8 ROIs on 8 threads
+// should cost about what one ROI costs on one.
+//
+// The last rows decode one frame-sized ROI, which the session splits into
+// row bands on the same pool.
+
+#include "c_plugin.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+double medianNs(const std::vector<double>& s) {
+    std::vector<double> v = s;
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+// Median ns per call of fn, after a short warm-up
+template <typename Fn>
+std::pair<double, size_t> timeIt(double minMs, Fn&& fn) {
+    for (int i = 0; i < 3; ++i) fn();
+    std::vector<double> samples;
+    const auto start = std::chrono::steady_clock::now();
+    double total = 0.0;
+    while (samples.size() < 5 || total < minMs * 1e6) {
+        const auto t0 = std::chrono::steady_clock::now();
+        fn();
+        const auto t1 = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+        total = std::chrono::duration<double, std::nano>(t1 - start).count();
+    }
+    return {medianNs(samples), samples.size()};
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr, "usage: %s [--quick] [--min-ms N] [--roi PX] [--max-threads N]\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    double minMs = 200.0;
+    int roiSize = 128;
+    int maxThreads = std::max(1, int(std::thread::hardware_concurrency()));
+
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--quick")) {
+            quick = true;
+        } else if (!std::strcmp(argv[i], "--min-ms") && i + 1 < argc) {
+            minMs = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--roi") && i + 1 < argc) {
+            roiSize = std::max(8, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--max-threads") && i + 1 < argc) {
+            maxThreads = std::max(1, std::atoi(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Noisy 1080p frame, planar chroma
+    const int W = 1920, H = 1080;
+    std::vector<uint8_t> y(size_t(W) * H), u(size_t(W / 2) * (H / 2), 110), v(u.size(), 170);
+    std::srand(7);
+    for (uint8_t& p : y) p = uint8_t(40 + std::rand() % 64);
+
+    // Up to 32 ROIs on an 8 x 4 grid
+    const int gridCols = 8, gridRows = 4, maxRois = gridCols * gridRows;
+    const int cellW = W / gridCols, cellH = H / gridRows;
+    const int rw = std::min(roiSize, cellW), rh = std::min(roiSize, cellH);
+    std::vector<int32_t> rois;
+    for (int i = 0; i < maxRois; ++i) {
+        const int cx = (i % gridCols) * cellW + (cellW - rw) / 2;
+        const int cy = (i / gridCols) * cellH + (cellH - rh) / 2;
+        rois.insert(rois.end(), {cx, cy, rw, rh});
+    }
+
+    std::vector<int> roiCounts = quick ? std::vector<int>{1, 8} : std::vector<int>{1, 2, 4, 8, 16, 32};
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    lifi_trace_enable(0);
+    std::printf("rois,roi,threads,iterations,ns_per_frame,ns_per_roi,speedup,efficiency\n");
+
+    for (int n : roiCounts) {
+        std::vector<lifi_session*> sessions;
+        for (int i = 0; i < n; ++i) sessions.push_back(lifi_session_create(rw, rh));
+        std::vector<double> out(size_t(7) * n);
+        double single = 0.0;
+
+        for (int threads : threadCounts) {
+            const int size = lifi_pool_set_threads(threads);
+            int frame = 0;
+            const auto [ns, iterations] = timeIt(minMs, [&] {
+                lifi_process_frame_color_multi(sessions.data(), n, y.data(), u.data(), v.data(),
+                                               W, H, frame++, W, W / 2, 1, rois.data(), out.data());
+            });
+
+            if (threads == 1) single = ns;
+            const double speedup = ns > 0 ? single / ns : 0.0;
+            std::printf("%d,%dx%d,%d,%zu,%.0f,%.0f,%.2f,%.2f\n", n, rw, rh, size, iterations, ns,
+                        ns / n, speedup, speedup / std::min(size, n));
+            std::fflush(stdout);
+        }
+        for (lifi_session* s : sessions) lifi_session_destroy(s);
+    }
+
+    // One frame-sized ROI: row bands inside the session
+    lifi_session* big = lifi_session_create(W, H);
+    double single = 0.0;
+    for (int threads : threadCounts) {
+        const int size = lifi_pool_set_threads(threads);
+        int frame = 0;
+        double out[7];
+        const auto [ns, iterations] = timeIt(minMs, [&] {
+            lifi_session_process_frame_color(big, y.data(), u.data(), v.data(), W, H, frame++,
+                                             W, W / 2, 1, 0, 0, W, H, out);
+        });
+        if (threads == 1) single = ns;
+        const double speedup = ns > 0 ? single / ns : 0.0;
+        std::printf("1,%dx%d,%d,%zu,%.0f,%.0f,%.2f,%.2f\n", W, H, size, iterations, ns, ns,
+                    speedup, speedup / size);
+        std::fflush(stdout);
+    }
+    lifi_session_destroy(big);
+
+    std::fprintf(stderr, "big-core pool size: %d\n", lifi_pool_set_threads(0));
+    return 0;
+}
@@ -0,0 +1,194 @@
+// Renders a transmission through the synthetic optical channel to a .lfc
+// capture, ready for lifi_replay.
+//
+//   lifi_channel_sim --text "Hi" [options] -o sim.lfc [--truth truth.csv]
+//
+// The message goes through the host port of the firmware's processTextState,
+// so symbol timing matches the ESP32 exactly. Every run with the same options
+// produces the same file. --truth writes, per frame, the strip colour the
+// ROI centre row actually integrated, for scoring a decode.
+//
+// Options (defaults in brackets):
+//   --text STR | --hex HEX     message bytes
+//   --interval MS              symbol interval [99]
+//   --repeat N                 message repetitions to render [1]
+//   --size WxH                 frame size [640x480]
+//   --fps F --jitter MS        frame rate and start-time jitter s.d. [30, 1]
+//   --exposure MS --readout MS exposure time and rolling-shutter skew [8, 20]
+//   --led X,Y,R                LED blob, repeatable [one in the centre]
+//   --blur PX --gain G         blob edge width, LED level vs. clip [2, 1.6]
+//   --ambient A                background level 0..1 [0.1]
+//   --flicker D --flicker-hz F ambient modulation depth and rate [0, 100]
+//   --noise SY --noise-c SC    sensor noise s.d., 8-bit codes [2, 1]
+//   --pixel-stride 1|2 --pad N chroma layout and row padding [2, 0]
+//   --crop MARGIN              store only ROI + margin (-1 = full frame) [-1]
+//   --seed N                   [1]
+
+#include "capture_file.h"
+#include "channel_sim.h"
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+bool parseHex(const char* s, std::vector<uint8_t>& out) {
+    std::string hex;
+    for (; *s; ++s) {
+        if (!std::isspace(static_cast<unsigned char>(*s))) hex += *s;
+    }
+    if (hex.empty() || hex.size() % 2) return false;
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        char* end = nullptr;
+        std::string byte = hex.substr(i, 2);
+        long v = std::strtol(byte.c_str(), &end, 16);
+        if (*end) return false;
+        out.push_back(uint8_t(v));
+    }
+    return true;
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+                 "usage: %s (--text STR | --hex HEX) -o out.lfc [--truth truth.csv]\n"
+                 "       [--interval MS] [--repeat N] [--size WxH] [--fps F] [--jitter MS]\n"
+                 "       [--exposure MS] [--readout MS] [--led X,Y,R]... [--blur PX] [--gain G]\n"
+                 "       [--ambient A] [--flicker D] [--flicker-hz F] [--noise SY] [--noise-c SC]\n"
+                 "       [--pixel-stride 1|2] [--pad N] [--crop MARGIN] [--seed N]\n",
+                 argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ChannelConfig cfg;
+    std::vector<uint8_t> message;
+    const char* outPath = nullptr;
+    const char* truthPath = nullptr;
+    int interval = 99, repeat = 1, crop = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const char* val = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!val) {
+            usage(argv[0]);
+            return 2;
+        }
+        ++i;
+        if (a == "--text") message.assign(val, val + std::strlen(val));
+        else if (a == "--hex") {
+            if (!parseHex(val, message)) {
+                std::fprintf(stderr, "bad --hex value\n");
+                return 2;
+            }
+        }
+        else if (a == "-o") outPath = val;
+        else if (a == "--truth") truthPath = val;
+        else if (a == "--interval") interval = std::atoi(val);
+        else if (a == "--repeat") repeat = std::max(1, std::atoi(val));
+        else if (a == "--size") {
+            if (std::sscanf(val, "%dx%d", &cfg.width, &cfg.height) != 2) {
+                usage(argv[0]);
+                return 2;
+            }
+        }
+        else if (a == "--fps") cfg.fps = std::atof(val);
+        else if (a == "--jitter") cfg.jitterMs = std::atof(val);
+        else if (a == "--exposure") cfg.exposureMs = std::atof(val);
+        else if (a == "--readout") cfg.readoutMs = std::atof(val);
+        else if (a == "--led") {
+            LedBlob b;
+            if (std::sscanf(val, "%f,%f,%f", &b.x, &b.y, &b.radius) != 3) {
+                usage(argv[0]);
+                return 2;
+            }
+            cfg.blobs.push_back(b);
+        }
+        else if (a == "--blur") cfg.blurPx = std::atof(val);
+        else if (a == "--gain") cfg.ledGain = std::atof(val);
+        else if (a == "--ambient") cfg.ambient = std::atof(val);
+        else if (a == "--flicker") cfg.flickerDepth = std::atof(val);
+        else if (a == "--flicker-hz") cfg.flickerHz = std::atof(val);
+        else if (a == "--noise") cfg.noiseY = std::atof(val);
+        else if (a == "--noise-c") cfg.noiseC = std::atof(val);
+        else if (a == "--pixel-stride") cfg.pixelStride = std::atoi(val);
+        else if (a == "--pad") cfg.rowPad = std::atoi(val);
+        else if (a == "--crop") crop = std::atoi(val);
+        else if (a == "--seed") cfg.seed = uint32_t(std::strtoul(val, nullptr, 10));
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (message.empty() || !outPath) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (cfg.blobs.empty()) {
+        LedBlob b;
+        b.x = cfg.width * 0.5f;
+        b.y = cfg.height * 0.5f;
+        b.radius = std::min(cfg.width, cfg.height) / 8.f;
+        cfg.blobs.push_back(b);
+    }
+
+    // One character is 29 intervals on air; add the lead-in and the camera's
+    // readout so the last symbol is fully exposed
+    TextTransmitter tx;
+    tx.send(message, uint16_t(std::max(0, std::min(interval, 65535))), 0);
+    const double chars = double(message.size()) * repeat;
+    const uint32_t durationMs = uint32_t((chars * 29 + 2) * tx.interval() +
+                                         cfg.readoutMs + cfg.exposureMs);
+    LedTimeline timeline = LedTimeline::record(tx, durationMs);
+
+    ChannelSim sim(cfg, timeline);
+    int x0, y0, w, h;
+    sim.bounds(x0, y0, w, h);
+
+    CaptureWriter writer;
+    if (!writer.open(outPath)) {
+        std::perror(outPath);
+        return 1;
+    }
+    FILE* truth = nullptr;
+    if (truthPath) {
+        truth = std::fopen(truthPath, "w");
+        if (!truth) {
+            std::perror(truthPath);
+            return 1;
+        }
+        std::fprintf(truth, "frame,timestamp_ns,lit,r,g,b\n");
+    }
+
+    SimFrame f;
+    const float litLevel = 0.5f * TX_BRIGHTNESS * float(cfg.ledGain);
+    while (sim.next(f)) {
+        const int frame = sim.frameIndex() - 1;
+        if (!writer.write(f.y.data(), f.u, f.v, f.width, f.height,
+                          f.yRowStride, f.uvRowStride, f.uvPixelStride,
+                          frame, f.timestampNs, x0, y0, w, h, crop)) {
+            std::fprintf(stderr, "%s: write failed\n", outPath);
+            return 1;
+        }
+        if (truth) {
+            const LedColor c = sim.exposed(std::min(f.height - 1, y0 + h / 2));
+            std::fprintf(truth, "%d,%" PRId64 ",%d,%.4f,%.4f,%.4f\n", frame, f.timestampNs,
+                         std::max(c.r, c.b) >= litLevel ? 1 : 0, c.r, c.g, c.b);
+        }
+    }
+    if (truth) std::fclose(truth);
+
+    const int frames = writer.close();
+    if (frames < 0) {
+        std::fprintf(stderr, "%s: write failed\n", outPath);
+        return 1;
+    }
+    std::fprintf(stderr, "%s: %d frames %dx%d, %zu bytes x %d, %u ms at %u ms/symbol, roi %d,%d %dx%d\n",
+                 outPath, frames, f.width, f.height, message.size(), repeat,
+                 durationMs, unsigned(tx.interval()), x0, y0, w, h);
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "symbol_decoder.h"
+#include <algorithm>
+
+namespace {
+
+// classify_hsv_color codes, folded the way _ledColorNames names them
+constexpr int BLACK = 0, YELLOW = 1, GRAY = 2, RED = 3, GREEN = 6, BLUE = 8,
+              MAGENTA = 9, UNKNOWN = 11;
+
+// Name the decoder gives a strip colour (lifi_protocol.h)
+int slotName(uint8_t slot) {
+    return slot == SLOT_RED ? RED : slot == SLOT_BLUE ? BLUE : slot == SLOT_GREEN ? GREEN : -1;
+}
+
+} // namespace
+
+int SymbolDecoder::colorName(int code) {
+    static const int names[] = {BLACK, YELLOW, GRAY, RED, RED, YELLOW,
+                                GREEN, GREEN, BLUE, MAGENTA, RED, UNKNOWN};
+    return code < 0 || code > 11 ? UNKNOWN : names[code];
+}
+
+void SymbolDecoder::reset() {
+    *this = SymbolDecoder();
+}
+
+int SymbolDecoder::push(const double* out) {
+    const int frame = ++counter;        // the Dart counter, 1-based
+    const int encoded = int(out[6]);
+    const int color = colorName(int(out[5]));
+
+    // ledMainArrayUpdate: frame k of the last five reads history slot k % 5,
+    // which is bit (4 - k % 5) of the encoded value
+    const int first = frame < 6 ? 0 : frame - 5;
+    const int last  = frame < 6 ? 4 : frame - 1;
+    if (int(ledtest.size()) <= last) ledtest.resize(size_t(last) + 1, 0);
+    for (int k = first; k <= last; ++k) {
+        ledtest[size_t(k)] = uint8_t((encoded >> (4 - k % 5)) & 1);
+    }
+
+    pairOn.push_back(ledtest[size_t(frame) - 1]);
+    pairColor.push_back(color);
+
+    // The first five frames are settled once the history is primed
+    if (frame == 5) {
+        for (int i = 0; i < 5; ++i) {
+            pairOn[size_t(i)] = ledtest[size_t(i)];
+            if (!pairOn[size_t(i)]) pairColor[size_t(i)] = OFF;
+        }
+    }
+
+    constexpr size_t N = LIFI_FRAMES_PER_SLOT;
+    if (frame > 5 && !bitStart) {
+        for (size_t i = 0; i + N <= pairOn.size() && !bitStart; ++i) {
+            size_t lit = 0;
+            while (lit < N && pairOn[i + lit]) ++lit;
+            if (lit == N) {
+                bitStart = true;
+                bitStartIndex = int(i);
+            }
+        }
+    }
+    if (bitStart) group();
+
+    const int len = int(groupOn.size());
+    if (!started && len >= lifiMarkerBack(0)) {
+        bool marker = true;
+        for (int p = 0; p < LIFI_MARKER_PULSES && marker; ++p) {
+            const size_t g = size_t(len - lifiMarkerBack(p));
+            marker = groupOn[g] && groupColor[g] == slotName(LIFI_MARKER[p]);
+        }
+        if (marker) {
+            started = true;
+            startIndex = len;
+        }
+    }
+
+    if (started && len >= startIndex + LIFI_PAYLOAD_SLOTS) {
+        // decodeCharacter keeps the lit group of every pulse
+        int byte = 0;
+        for (int b = 0; b < LIFI_PAYLOAD_BITS; ++b) {
+            const size_t g = size_t(startIndex + lifiBitSlot(b));
+            const int bit = groupOn[g] && groupColor[g] == slotName(LIFI_BIT_COLOR[1]) ? 1 : 0;
+            byte = (byte << 1) | bit;
+        }
+        started = false;
+        startIndex = -1;
+        return byte;
+    }
+    return -1;
+}
+
+void SymbolDecoder::group() {
+    constexpr size_t N = LIFI_FRAMES_PER_SLOT;
+    size_t next = size_t(bitStartIndex) + groupOn.size() * N;
+    while (next + N <= pairOn.size()) {
+        // Majority of lit frames, and the colour most of the frames agree
+        // on (the earliest such colour on a tie, as the Dart code picks A)
+        int lit = 0, current = OFF;
+        size_t best = 0;
+        for (size_t i = 0; i < N; ++i) {
+            const int color = pairOn[next + i] ? pairColor[next + i] : OFF;
+            lit += pairOn[next + i];
+            size_t votes = 0;
+            for (size_t j = 0; j < N; ++j) votes += (pairOn[next + j] ? pairColor[next + j] : OFF) == color;
+            if (color != OFF && votes > best) {
+                best = votes;
+                current = color;
+            }
+        }
+        if (2 * best <= N) current = OFF;
+
+        const bool bit = 2 * lit > int(N);
+        groupOn.push_back(bit ? 1 : 0);
+        groupColor.push_back(bit ? current : OFF);
+        next += N;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef SYMBOL_DECODER_H
+#define SYMBOL_DECODER_H
+
+#include "lifi_protocol.h"
+#include <cstdint>
+#include <vector>
+
+// Frame results -> bytes, ported from the receiver in
+// lib/Detection/detection_page.dart (_onFrame and decodeCharacter):
+//
+//   1. The on/off of the last five frames is re-read from the encoded
+//      history (out_values[6]) every frame, like ledMainArrayUpdate.
+//   2. From the first run of LIFI_FRAMES_PER_SLOT lit frames on, frames
+//      are grouped per slot; each group's bit and colour are majority votes.
+//   3. The lit groups of LIFI_MARKER, one per pulse, are the start marker;
+//      the LIFI_PAYLOAD_BITS pulses after it carry the bits (lit in
+//      LIFI_BIT_COLOR[1] = 1). Layout as in lifi_protocol.h.
+//
+// The app stops the stream after one character; the port keeps looking
+// for the next marker so a whole message can be scored in one run.
+class SymbolDecoder {
+public:
+    void reset();
+
+    // Feeds one process_frame_color result (7 values). Returns the decoded
+    // byte, or -1 if this frame did not complete a character.
+    int push(const double* outValues);
+
+    // Frames and groups seen so far
+    int frames() const { return counter; }
+    int groups() const { return int(groupOn.size()); }
+
+private:
+    static constexpr int OFF = -1;      // the Dart code's "Black": not lit
+
+    int counter = 0;
+    std::vector<uint8_t> ledtest;       // per-frame on/off, revised
+    std::vector<uint8_t> pairOn;        // ledPairCompute[0]
+    std::vector<int> pairColor;         // ledPairCompute[1], colour names
+    std::vector<uint8_t> groupOn;       // finalBits[0]
+    std::vector<int> groupColor;        // finalBits[1]
+    bool bitStart = false;
+    int bitStartIndex = 0;
+    bool started = false;
+    int startIndex = -1;
+
+    static int colorName(int code);
+    void group();
+};
+
+#endif // SYMBOL_DECODER_H
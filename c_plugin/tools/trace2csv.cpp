@@ -0,0 +1,75 @@
+// Converts a lifi_trace_dump() file into CSV.
+//
+//   adb pull /data/.../lifi.trace && lifi_trace2csv lifi.trace > lifi.csv
+//
+// t_ms is relative to the first record of the dump. Rows with byte = 1 are
+// lifi_session_mark_byte() emissions: frame is the byte index, encoded the
+// byte, latency_us sensor -> byte and wait_us last decision -> byte. gap
+// marks frames with frames missing before them (lifi_session_frames_missed),
+// late frames that overran the frame budget.
+
+#include "trace_ring.h"
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <trace file> [out.csv]\n", argv[0]);
+        return 2;
+    }
+
+    FILE* in = std::fopen(argv[1], "rb");
+    if (!in) {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    TraceFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, in) != 1 ||
+        std::memcmp(header.magic, "LTRC", 4) != 0) {
+        std::fprintf(stderr, "%s: not a LiFi trace\n", argv[1]);
+        std::fclose(in);
+        return 1;
+    }
+    if (header.version != TRACE_FILE_VERSION || header.recordSize != sizeof(lifi_trace_record)) {
+        std::fprintf(stderr, "%s: unsupported trace version %u (record size %u)\n",
+                     argv[1], header.version, header.recordSize);
+        std::fclose(in);
+        return 1;
+    }
+
+    std::vector<lifi_trace_record> records(header.count);
+    size_t got = std::fread(records.data(), sizeof(lifi_trace_record), records.size(), in);
+    std::fclose(in);
+    if (got != records.size()) {
+        std::fprintf(stderr, "%s: truncated, %zu of %u records\n", argv[1], got, header.count);
+        records.resize(got);
+    }
+
+    FILE* out = argc > 2 ? std::fopen(argv[2], "w") : stdout;
+    if (!out) {
+        std::perror(argv[2]);
+        return 1;
+    }
+
+    std::fprintf(out, "session,frame,t_ns,t_ms,y,dyn_min,dyn_max,led_on,encoded,color,reset,ambient_ring,"
+                      "sensor_ns,latency_us,wait_us,byte,gap,late\n");
+    const uint64_t t0 = records.empty() ? 0 : records.front().t_ns;
+    for (const lifi_trace_record& r : records) {
+        std::fprintf(out, "%u,%u,%" PRIu64 ",%.3f,%.3f,%.3f,%.3f,%u,%u,%u,%d,%d,%" PRId64 ",%u,%u,%d,%d,%d\n",
+                     r.session, r.frame, r.t_ns, double(int64_t(r.t_ns - t0)) / 1e6,
+                     r.y, r.dyn_min, r.dyn_max,
+                     unsigned(r.led_on), unsigned(r.encoded), unsigned(r.color),
+                     (r.flags & LIFI_TRACE_RESET) ? 1 : 0,
+                     (r.flags & LIFI_TRACE_AMBIENT_RING) ? 1 : 0,
+                     r.sensor_ns, r.latency_us, r.wait_us,
+                     (r.flags & LIFI_TRACE_BYTE) ? 1 : 0,
+                     (r.flags & LIFI_TRACE_GAP) ? 1 : 0,
+                     (r.flags & LIFI_TRACE_LATE) ? 1 : 0);
+    }
+
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,295 @@
+// Edge timing of the ESP32 symbol engine on a virtual clock.
+//
+//   lifi_tx_engine_check [--slots N] [--interval-ms N] [--latency-us N] [--seed N]
+//
+// Runs esp32Codenew/fully_working/symbol_engine.cpp, fed from a message
+// precomputed by symbol_buffer.cpp, against a virtual periodic timer, whose callbacks arrive up to --latency-us late, and a
+// sink that records every strip change. Checks that:
+//
+//   grid       every edge lands within the callback latency of its nominal
+//              time start + k * interval, with no drift over the run
+//   waveform   the slot sequence matches the firmware's polled state
+//              machine (TextTransmitter in channel_sim) slot for slot
+//   underrun   a starved queue darkens the strip and is counted
+//   restart    stop() drops queued slots; a new message starts cleanly
+//   fec        Hamming(7,4) payloads decode back to the message with one
+//              flipped bit in every codeword
+//
+// Exits 1 if any check fails.
+
+#include "channel_sim.h"
+#include "symbol_engine.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Periodic timer on a virtual microsecond clock. Each callback runs
+// latency() after its nominal time, like an esp_timer callback waiting for
+// its task; the schedule itself never drifts.
+class VirtualTimer : public SlotTimer {
+public:
+    std::mt19937 rng{1};
+    uint32_t maxLatencyUs = 0;
+
+    void start(uint32_t p, void (*f)(void*), void* a) override {
+        period = p;
+        fn = f;
+        arg = a;
+        due = now + p;
+        running = true;
+    }
+
+    void stop() override { running = false; }
+
+    uint64_t nowUs() const override { return now; }
+
+    // Advances to `until`, firing the callbacks due on the way; `loop` runs
+    // after each one, standing in for loop()
+    template <typename Loop>
+    void advance(uint64_t until, Loop&& loop) {
+        while (running && due <= until) {
+            now = due + (maxLatencyUs ? rng() % (maxLatencyUs + 1) : 0);
+            fn(arg);
+            loop();
+            due += period;
+        }
+        now = std::max(now, until);
+    }
+
+private:
+    uint64_t now = 0;
+    uint64_t due = 0;
+    uint32_t period = 0;
+    void (*fn)(void*) = nullptr;
+    void* arg = nullptr;
+    bool running = false;
+};
+
+class RecordingSink : public LedSink {
+public:
+    struct Edge {
+        uint64_t tUs;
+        uint8_t slot;
+    };
+
+    explicit RecordingSink(const VirtualTimer& clock) : clock(clock) {}
+
+    void show(uint8_t slot) override { edges.push_back(Edge{clock.nowUs(), slot}); }
+
+    // What the strip showed at time t
+    uint8_t at(uint64_t tUs) const {
+        uint8_t s = SLOT_OFF;
+        for (const Edge& e : edges) {
+            if (e.tUs > tUs) break;
+            s = e.slot;
+        }
+        return s;
+    }
+
+    std::vector<Edge> edges;
+
+private:
+    const VirtualTimer& clock;
+};
+
+uint8_t slotOf(const TextTransmitter& tx) {
+    if (!tx.lit()) return SLOT_OFF;
+    const LedColor c = tx.color();
+    return c.r > 0.f ? SLOT_RED : c.b > 0.f ? SLOT_BLUE : SLOT_GREEN;
+}
+
+// Payload bits of every character of a repeating text buffer, read back
+// from the lit slots after the marker
+std::vector<uint32_t> payloads(const SymbolBuffer& buf, TxFec fec) {
+    std::vector<uint32_t> out;
+    const int per = slotsPerChar(fec);
+    for (uint32_t c = 0; c + per <= buf.count; c += per) {
+        uint32_t bits = 0;
+        for (int b = 0; b < payloadBits(fec); ++b)
+            bits = bits << 1 | (buf.at(c + LIFI_SLOTS_PER_PULSE * (LIFI_MARKER_PULSES + b)) == LIFI_BIT_COLOR[1]);
+        out.push_back(bits);
+    }
+    return out;
+}
+
+// Syndrome decode of a p1 p2 d1 p3 d2 d3 d4 codeword
+uint8_t hammingDecode(uint8_t cw) {
+    auto bit = [&](int pos) { return (cw >> (7 - pos)) & 1; };
+    const int syndrome = (bit(1) ^ bit(3) ^ bit(5) ^ bit(7)) |
+                         (bit(2) ^ bit(3) ^ bit(6) ^ bit(7)) << 1 |
+                         (bit(4) ^ bit(5) ^ bit(6) ^ bit(7)) << 2;
+    if (syndrome) cw ^= uint8_t(1 << (7 - syndrome));
+    return uint8_t(bit(3) << 3 | bit(5) << 2 | bit(6) << 1 | bit(7));
+}
+
+bool report(const char* name, bool ok, const std::string& detail) {
+    std::printf("  %-10s %s  %s\n", name, ok ? "ok  " : "FAIL", detail.c_str());
+    return ok;
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr, "usage: %s [--slots N] [--interval-ms N] [--latency-us N] [--seed N]\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int slots = 20000, intervalMs = 33, latencyUs = 300;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--slots") && i + 1 < argc) {
+            slots = std::max(100, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--interval-ms") && i + 1 < argc) {
+            intervalMs = std::max(20, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--latency-us") && i + 1 < argc) {
+            latencyUs = std::max(0, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+            seed = unsigned(std::atoi(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    const uint64_t period = uint64_t(intervalMs) * 1000;
+    latencyUs = std::min<int>(latencyUs, int(period / 2));
+
+    const std::string text = "LiFi 0123456789 \x01\x7f\xff";
+    const std::vector<uint8_t> message(text.begin(), text.end());
+
+    // What onWrite builds; large, so not on the stack
+    static SymbolBuffer symbols;
+    encodeText(message.data(), message.size(), TX_FEC_NONE, symbols);
+
+    std::printf("%d slots of %d ms, callback latency up to %d us\n", slots, intervalMs, latencyUs);
+    bool ok = true;
+
+    // grid + waveform: one run, loop() refilling after every callback
+    {
+        VirtualTimer timer;
+        timer.rng.seed(seed);
+        timer.maxLatencyUs = uint32_t(latencyUs);
+        RecordingSink sink(timer);
+        SymbolEngine engine(timer, sink);
+        SymbolCursor source;
+
+        source.play(&symbols);
+        engine.refill(source);
+        engine.start(uint32_t(period));
+        timer.advance(uint64_t(slots) * period, [&] { engine.refill(source); });
+
+        uint64_t worst = 0;
+        for (const RecordingSink::Edge& e : sink.edges) worst = std::max(worst, e.tUs % period);
+        const SymbolEngineStats st = engine.stats();
+        ok &= report("grid", worst <= uint64_t(latencyUs) && st.slots == uint32_t(slots) && st.underruns == 0,
+                     std::to_string(sink.edges.size()) + " edges, max " + std::to_string(worst) +
+                     " us off the grid, mean callback latency " + std::to_string(st.meanLateUs) + " us");
+
+        // The firmware's machine, polled every millisecond from t = 0. Its
+        // slot k runs from (k + 1) * interval, like the engine's.
+        TextTransmitter tx;
+        tx.send(message, uint16_t(intervalMs), 0);
+        int mismatches = 0, first = -1;
+        uint32_t ms = 0;
+        for (int k = 0; k < slots - 1; ++k) {
+            const uint32_t mid = uint32_t((k + 1) * intervalMs + intervalMs / 2);
+            for (; ms <= mid; ++ms) tx.poll(ms);
+            if (slotOf(tx) != sink.at(uint64_t(mid) * 1000)) {
+                if (first < 0) first = k;
+                ++mismatches;
+            }
+        }
+        ok &= report("waveform", mismatches == 0,
+                     std::to_string(slots - 1) + " slots vs TextTransmitter, " + std::to_string(mismatches) +
+                     " differ" + (first >= 0 ? " (first at slot " + std::to_string(first) + ")" : ""));
+    }
+
+    // underrun: loop() only gets round every 100 slots, the queue holds 64
+    {
+        VirtualTimer timer;
+        RecordingSink sink(timer);
+        SymbolEngine engine(timer, sink);
+        SymbolCursor source;
+
+        source.play(&symbols);
+        engine.refill(source);
+        engine.start(uint32_t(period));
+        int calls = 0;
+        timer.advance(1000 * period, [&] {
+            if (++calls % 100 == 0) engine.refill(source);
+        });
+
+        const SymbolEngineStats st = engine.stats();
+        const uint32_t expected = 1000 - 10 * SlotQueue::CAPACITY;
+        ok &= report("underrun", st.underruns == expected,
+                     std::to_string(st.underruns) + " underruns, expected " + std::to_string(expected));
+    }
+
+    // restart: stop() mid-message, then a new message
+    {
+        VirtualTimer timer;
+        RecordingSink sink(timer);
+        SymbolEngine engine(timer, sink);
+        SymbolCursor source;
+
+        source.play(&symbols);
+        engine.refill(source);
+        engine.start(uint32_t(period));
+        timer.advance(7 * period, [&] { engine.refill(source); });
+        engine.stop();
+        const size_t stoppedAt = sink.edges.size();
+        timer.advance(20 * period, [] {});
+        const bool quiet = sink.edges.size() == stoppedAt && sink.edges.back().slot == SLOT_OFF;
+
+        static SymbolBuffer nextSymbols;
+        const uint8_t next[] = {0x00};
+        encodeText(next, 1, TX_FEC_NONE, nextSymbols);
+        source.play(&nextSymbols);
+        engine.refill(source);
+        const uint64_t t0 = timer.nowUs();
+        engine.start(uint32_t(period));
+        timer.advance(t0 + uint64_t(LIFI_SLOTS_PER_CHAR) * period, [&] { engine.refill(source); });
+
+        // Marker first, then all-zero bits: nothing left over from the old message
+        uint8_t one[MAX_SLOTS_PER_CHAR];
+        const int n = encodeChar(next[0], TX_FEC_NONE, one);
+        std::vector<uint8_t> want, got;
+        for (int k = 0; k < n; ++k) {
+            if (one[k] != SLOT_OFF) want.push_back(one[k]);
+        }
+        for (size_t i = stoppedAt; i < sink.edges.size(); ++i) {
+            if (sink.edges[i].slot != SLOT_OFF) got.push_back(sink.edges[i].slot);
+        }
+        const bool clean = sink.edges[stoppedAt].slot == LIFI_MARKER[0] &&
+                           sink.edges[stoppedAt].tUs == t0 + period && got == want;
+        ok &= report("restart", quiet && clean,
+                     std::string(quiet ? "dark after stop" : "edges after stop") + ", " +
+                     (clean ? "new message from its first slot" : "stale slots after restart"));
+    }
+
+    // fec: encode with Hamming(7,4), flip one bit per codeword, decode
+    {
+        static SymbolBuffer coded;
+        encodeText(message.data(), message.size(), TX_FEC_HAMMING74, coded);
+        const std::vector<uint32_t> words = payloads(coded, TX_FEC_HAMMING74);
+
+        int wrong = 0;
+        for (size_t i = 0; i < words.size(); ++i) {
+            const uint32_t hit = words[i] ^ (1u << (i % 7)) ^ (1u << (7 + (i * 3) % 7));
+            const uint8_t c = uint8_t(hammingDecode(uint8_t(hit >> 7)) << 4 | hammingDecode(uint8_t(hit & 0x7f)));
+            wrong += i >= message.size() || c != message[i];
+        }
+        const bool sized = coded.count == message.size() * uint32_t(slotsPerChar(TX_FEC_HAMMING74)) &&
+                           payloads(symbols, TX_FEC_NONE).size() == message.size();
+        ok &= report("fec", wrong == 0 && words.size() == message.size() && sized,
+                     std::to_string(words.size()) + " characters, " + std::to_string(wrong) +
+                     " wrong after a bit error per codeword");
+    }
+
+    return ok ? 0 : 1;
+}
@@ -1,18 +1,37 @@
 #include <Arduino.h>
 #include <FastLED.h>
 #include <NimBLEDevice.h>
+#include <esp_timer.h>
+#include "message_queue.h"
+#include "symbol_engine.h"
 
 #define NUM_LEDS    32
 #define DATA_PIN    2
 #define BRIGHTNESS  150
 
+// Payload coding of text messages (symbol_buffer.h). The phone decodes
+// TX_FEC_NONE only.
+#define TX_FEC      TX_FEC_NONE
+
+// Stream queue size in bytes, a power of two up to 32768
+#define TX_QUEUE_BYTES 4096
+
+// LED output task: highest priority, away from the NimBLE host on core 0
+#if CONFIG_FREERTOS_UNICORE
+#define LED_CORE    0
+#else
+#define LED_CORE    1
+#endif
+
 CRGB leds[NUM_LEDS];
 
 #define SERVICE_UUID_16        0x1819
 #define CHARACTERISTIC_UUID_16 0x2B1E
+#define STREAM_UUID_16         0x2B1F
 #define DEVICE_NAME            "ESP32-LED-Controller"
 
 NimBLECharacteristic* pCharacteristic = nullptr;
+NimBLECharacteristic* pStreamCharacteristic = nullptr;
 
 static bool     blinkState   = false;
 static uint32_t lastToggleMs = 0;
@@ -21,56 +40,155 @@ uint8_t  gMode     = 0;
 uint8_t  gR        = 0;
 uint8_t  gG        = 0;
 uint8_t  gB        = 0;
-uint16_t gInterval = 99;
+uint16_t gInterval = LIFI_DEFAULT_INTERVAL_MS;
 
-bool ledOn = false;
-
-enum BlinkState {
-  BS_IDLE,
-  BS_START_MARKER,
-  BS_MARKER_ON,
-  BS_MARKER_OFF,
-  BS_BIT_ON,
-  BS_BIT_OFF
-};
-
-static BlinkState    textState      = BS_IDLE;
-static unsigned long phaseStart     = 0;
-static int           startupStep    = 0;
-static int           charIndex      = 0;
-static int           bitIndex       = 0;
-static int           prevBitValue   = -1;  // New: Track previous bit
-static String        currentMessage = "";
-static bool          newMessageFlag = false;
-int markerIndex = 0;  // 0–5 (111000)
-bool bitIsOn = false;
+// ——————— STRIP ———————
+// leds[] and FastLED.show() are shared by loop() (legacy modes) and the LED
+// task (text transmission)
+static SemaphoreHandle_t stripLock = nullptr;
+static TaskHandle_t      ledTask   = nullptr;
 
 static void stripOff() {
+  xSemaphoreTake(stripLock, portMAX_DELAY);
   FastLED.clear();
   FastLED.show();
+  xSemaphoreGive(stripLock);
 }
 
-static void blinkColor200ms(const CRGB &color) {
+static void stripFill(const CRGB &color) {
+  xSemaphoreTake(stripLock, portMAX_DELAY);
   fill_solid(leds, NUM_LEDS, color);
   FastLED.show();
-  delay(gInterval);
-  stripOff();
-  delay(gInterval);
+  xSemaphoreGive(stripLock);
+}
+
+static CRGB slotColor(uint8_t slot) {
+  switch (slot) {
+    case SLOT_RED:   return CRGB::Red;
+    case SLOT_BLUE:  return CRGB::Blue;
+    case SLOT_GREEN: return CRGB::Green;
+    default:         return CRGB::Black;
+  }
+}
+
+// Shows each slot the timer hands over. FastLED.show() takes about a
+// millisecond for the strip, too long for the timer callback itself.
+static void ledTaskMain(void*) {
+  uint32_t slot;
+  for (;;) {
+    if (xTaskNotifyWait(0, 0, &slot, portMAX_DELAY) != pdTRUE) continue;
+    if (slot == SLOT_OFF) stripOff();
+    else stripFill(slotColor(uint8_t(slot)));
+  }
+}
+
+// ——————— SYMBOL ENGINE ———————
+class EspSlotTimer : public SlotTimer {
+ public:
+  void start(uint32_t periodUs, void (*fn)(void*), void* arg) override {
+    if (!handle) {
+      esp_timer_create_args_t args = {};
+      args.callback        = fn;
+      args.arg             = arg;
+      args.dispatch_method = ESP_TIMER_TASK;
+      args.name            = "lifi_slot";
+      esp_timer_create(&args, &handle);
+    }
+    esp_timer_stop(handle);
+    esp_timer_start_periodic(handle, periodUs);
+  }
+
+  void stop() override {
+    if (handle) esp_timer_stop(handle);
+  }
+
+  uint64_t nowUs() const override { return uint64_t(esp_timer_get_time()); }
+
+ private:
+  esp_timer_handle_t handle = nullptr;
+};
+
+class TaskLedSink : public LedSink {
+ public:
+  void show(uint8_t slot) override {
+    xTaskNotify(ledTask, slot, eSetValueWithOverwrite);
+  }
+};
+
+static EspSlotTimer   slotTimer;
+static TaskLedSink    ledSink;
+static SymbolEngine   txEngine(slotTimer, ledSink);
+static SymbolCursor   txSource;
+
+// Messages are encoded in the BLE task and handed to loop(), which owns the
+// transmitter. The mailbox has a single writer: the BLE task, or setup()
+// before BLE is up.
+static Mailbox<SymbolBuffer> txMailbox;
+
+// Chunks written to the stream characteristic queue up here and go out
+// back to back (message_queue.h). A legacy or text command drops whatever
+// is still queued.
+class CharacteristicNotifier : public StatusNotifier {
+ public:
+  void notify(const uint8_t* status, size_t length) override {
+    if (pStreamCharacteristic) pStreamCharacteristic->notify(status, length);
+  }
+};
+
+static uint8_t                txQueueStorage[TX_QUEUE_BYTES];
+static ByteRing               txQueue(txQueueStorage, TX_QUEUE_BYTES);
+static CharacteristicNotifier txNotifier;
+static ChunkReceiver          txReceiver(txQueue, txNotifier);
+static StreamSource           txStream(txQueue, TX_FEC);
+static bool                   streaming = false;
+
+enum Command : uint8_t { CMD_NONE, CMD_LEGACY, CMD_TEXT };
+
+static portMUX_TYPE     pendingMux     = portMUX_INITIALIZER_UNLOCKED;
+static volatile Command pendingCommand = CMD_NONE;
+
+static void postCommand(Command cmd) {
+  portENTER_CRITICAL(&pendingMux);
+  pendingCommand = cmd;
+  portEXIT_CRITICAL(&pendingMux);
+}
+
+static void startTransmitter(uint16_t intervalMs) {
+  txEngine.refill(txSource);
+  txEngine.start(uint32_t(intervalMs) * 1000);
+}
+
+static void startStream() {
+  txEngine.stop();
+  txSource.clear();
+  streaming = true;
+  gMode = 0;
+  if (gInterval < LIFI_MIN_INTERVAL_MS) gInterval = LIFI_DEFAULT_INTERVAL_MS;
+  txEngine.refill(txStream);
+  txEngine.start(uint32_t(gInterval) * 1000);
+}
+
+static void blinkStartupGreen() {
+  static const uint8_t pattern[] = {SLOT_GREEN, SLOT_OFF, SLOT_GREEN, SLOT_OFF, SLOT_GREEN, SLOT_OFF};
+  encodePattern(pattern, sizeof(pattern), txMailbox.back());
+  txMailbox.publish();
+  postCommand(CMD_TEXT);
 }
+
 const uint8_t blinkIndices[] = {10,11, 12,13,18,19,21, 20,2,3,4,5,26,27,28,29};
 const uint8_t numToBlink = sizeof(blinkIndices) / sizeof(blinkIndices[0]);
 
 void ControllLed(uint8_t mode_, uint8_t r, uint8_t g, uint8_t b, uint16_t interval) {
   switch (mode_) {
     case 1:
-      fill_solid(leds, NUM_LEDS, CRGB(r, g, b));
-      FastLED.show();
+      stripFill(CRGB(r, g, b));
       break;
     case 2: {
       uint32_t now = millis();
       if (now - lastToggleMs >= interval) {
         lastToggleMs = now;
         blinkState = !blinkState;
+        xSemaphoreTake(stripLock, portMAX_DELAY);
         fill_solid(leds, NUM_LEDS, CRGB::Black);
        if (blinkState) {
     for (int i = 0; i < numToBlink; i++) {
@@ -78,6 +196,7 @@ void ControllLed(uint8_t mode_, uint8_t r, uint8_t g, uint8_t b, uint16_t interv
     }
   }
         FastLED.show();
+        xSemaphoreGive(stripLock);
       }
       break;
     }
@@ -87,99 +206,33 @@ void ControllLed(uint8_t mode_, uint8_t r, uint8_t g, uint8_t b, uint16_t interv
   }
 }
 
-static void blinkStartupGreen() {
-  for (int i = 0; i < 3; i++) {
-    blinkColor200ms(CRGB::Green);
-  }
-}
-
-static void processTextState() {
-  unsigned long now = millis();
-
-  switch (textState) {
-    case BS_IDLE:
-      if (newMessageFlag) {
-        newMessageFlag = false;
-        charIndex = 0;
-        markerIndex = 0;
-        bitIndex = 7;
-        ledOn = false;
-        textState = BS_START_MARKER;
-        phaseStart = now;
-      }
-      break;
-
-    case BS_START_MARKER:
-      if (now - phaseStart >= gInterval) {
-        phaseStart = now;
-
-        if (ledOn) {
-          stripOff();
-        } else {
-          fill_solid(leds, NUM_LEDS, markerIndex < 3 ? CRGB::Red : CRGB::Blue);
-          FastLED.show();
-        }
-
-        ledOn = !ledOn;
-
-        if (!ledOn) {
-          markerIndex++;
-          if (markerIndex >= 6) {
-            markerIndex = 0;
-            bitIndex = 7;
-            textState = BS_BIT_ON;
-          }
-        }
-      }
-      break;
-
-    case BS_BIT_ON:
-      if (now - phaseStart >= gInterval) {
-        phaseStart = now;
-
-        if (bitIndex >= 0) {
-          if (ledOn) {
-            stripOff();
-            ledOn = false;
-            bitIndex--;
-          } else {
-            char c = currentMessage.charAt(charIndex);
-            bool bit = (c >> bitIndex) & 0x01;
-            fill_solid(leds, NUM_LEDS, bit ? CRGB::Red : CRGB::Blue);
-            FastLED.show();
-            ledOn = true;
-          }
-        } else {
-          stripOff();
-          textState = BS_IDLE;
-
-          // Prepare for repeat if more characters
-          charIndex++;
-          if (charIndex < currentMessage.length()) {
-            textState = BS_START_MARKER;
-            markerIndex = 0;
-            bitIndex = 7;
-            ledOn = false;
-            phaseStart = now;
-          } else {
-             textState = BS_START_MARKER;
-charIndex = 0;
-bitIndex = 7;
-markerIndex = 0;
-ledOn = false;
-phaseStart = now;
-          }
-        }
-      }
-      break;
-
-    default:
-      break;
+static void handleBleCommand() {
+  if (pendingCommand == CMD_NONE) return;
+
+  // Stop any active transmission before the source changes under it
+  txEngine.stop();
+
+  portENTER_CRITICAL(&pendingMux);
+  const Command cmd = pendingCommand;
+  pendingCommand = CMD_NONE;
+  portEXIT_CRITICAL(&pendingMux);
+
+  txSource.clear();
+  txStream.clear();
+  streaming = false;
+  const SymbolBuffer* symbols = cmd == CMD_TEXT ? txMailbox.take() : nullptr;
+  if (symbols) {
+    txSource.play(symbols);
+    gMode = 0;
+    lastToggleMs = millis();
+    if (gInterval < LIFI_MIN_INTERVAL_MS) gInterval = LIFI_DEFAULT_INTERVAL_MS;
+    startTransmitter(gInterval);
   }
 }
 
 class MyServerCallbacks : public NimBLEServerCallbacks {
   void onConnect(NimBLEServer*, NimBLEConnInfo&) override {
+    txReceiver.reset();
     Serial.println("Client connected");
   }
   void onDisconnect(NimBLEServer*, NimBLEConnInfo&, int) override {
@@ -200,46 +253,44 @@ class CharacteristicCallbacks : public NimBLECharacteristicCallbacks {
       gG = static_cast<uint8_t>(val[2]);
       gB = static_cast<uint8_t>(val[3]);
       gInterval = (static_cast<uint16_t>(val[4]) << 8) | static_cast<uint16_t>(val[5]);
-      if (gInterval < 20) gInterval = 99;
+      if (gInterval < LIFI_MIN_INTERVAL_MS) gInterval = LIFI_DEFAULT_INTERVAL_MS;
 
       // 🛑 Stop any active text transmission
-      currentMessage = "";
-      newMessageFlag = false;
-      textState = BS_IDLE;
-      stripOff();
+      postCommand(CMD_LEGACY);
 
       Serial.printf("\u25B6 LEGACY CMD: mode=%u, R=%u, G=%u, B=%u, interval=%u ms\n", gMode, gR, gG, gB, gInterval);
       return;
     }
   }
 
-  // 🟢 Valid text message
-  String incoming = "";
-  for (size_t i = 0; i < val.size(); i++) incoming += char(val[i]);
+  // 🟢 Valid text message: encode every slot now, loop() only walks them
+  const size_t len = val.size() < MAX_MESSAGE ? val.size() : MAX_MESSAGE;
+  encodeText(val.data(), len, TX_FEC, txMailbox.back());
+  txMailbox.publish();
+  postCommand(CMD_TEXT);
 
   Serial.print("\u25B6 Received TEXT: ");
-  Serial.println(incoming);
-
-  currentMessage = incoming;
-  gMode = 0;
-textState = BS_IDLE;
-charIndex = 0;
-bitIndex = 7;
-markerIndex = 0;
-ledOn = false;
-lastToggleMs = millis();
-newMessageFlag = true;
-stripOff();             // <--- Ensure all LEDs are off
-phaseStart = millis();
-if (gInterval < 20) gInterval = 99;// <--- Proper sync with clock
- // Reset state machine
+  Serial.write(val.data(), len);
+  Serial.println();
 }
 };
 
+class StreamCallbacks : public NimBLECharacteristicCallbacks {
+  void onWrite(NimBLECharacteristic* pChr, NimBLEConnInfo&) override {
+    auto val = pChr->getValue();
+    // Status goes back as a notification; loop() picks the data up
+    txReceiver.onWrite(val.data(), val.size());
+  }
+};
+
 void setup() {
   Serial.begin(115200);
   FastLED.addLeds<WS2811, DATA_PIN, GRB>(leds, NUM_LEDS);
   FastLED.setBrightness(BRIGHTNESS);
+
+  stripLock = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(ledTaskMain, "lifi_led", 4096, nullptr,
+                          configMAX_PRIORITIES - 1, &ledTask, LED_CORE);
   stripOff();
 
   NimBLEDevice::init(DEVICE_NAME);
@@ -258,18 +309,48 @@ void setup() {
   );
   pCharacteristic->setCallbacks(new CharacteristicCallbacks());
 
+  NimBLEUUID streamUUID((uint16_t)STREAM_UUID_16);
+  pStreamCharacteristic = pService->createCharacteristic(
+    streamUUID,
+    NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR | NIMBLE_PROPERTY::NOTIFY
+  );
+  pStreamCharacteristic->setCallbacks(new StreamCallbacks());
+
   pService->start();
   NimBLEAdvertising* pAdv = NimBLEDevice::getAdvertising();
   pAdv->addServiceUUID(svcUUID);
   pAdv->setName(DEVICE_NAME);
   pAdv->start();
 
-  Serial.println("BLE up and advertising (write-char 0x2B1E)");
+  Serial.println("BLE up and advertising (write-char 0x2B1E, stream-char 0x2B1F)");
 }
 
 void loop() {
-  if (currentMessage.length() > 0 || textState != BS_IDLE) {
-    processTextState();
+  handleBleCommand();
+  if (!streaming && txQueue.size() > 0) startStream();
+  txReceiver.poll();
+
+  if (txEngine.running()) {
+    // Keep the slot queue topped up; edges come from the timer, so loop()
+    // running late only matters if the queue empties
+    if (streaming) {
+      txEngine.refill(txStream);
+      if (txStream.idle() && txEngine.queue().size() == 0) {
+        txEngine.stop();
+        streaming = false;
+      }
+    } else {
+      txEngine.refill(txSource);
+      if (!txSource.active() && txEngine.queue().size() == 0) txEngine.stop();
+    }
+
+    static uint32_t lastReportMs = 0;
+    if (millis() - lastReportMs >= 5000) {
+      lastReportMs = millis();
+      const SymbolEngineStats st = txEngine.stats();
+      Serial.printf("TX slots=%u underruns=%u late mean=%u max=%u us\n",
+                    st.slots, st.underruns, st.meanLateUs, st.maxLateUs);
+    }
   }
   else if (gMode > 0) {
     ControllLed(gMode, gR, gG, gB, gInterval);
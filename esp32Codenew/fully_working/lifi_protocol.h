@@ -0,0 +1,75 @@
+#ifndef LIFI_PROTOCOL_H
+#define LIFI_PROTOCOL_H
+
+// The optical text protocol, for both ends of the link.
+//
+// The firmware's encoder (symbol_buffer.cpp) and the receivers compile
+// against this one header: the plugin exports it to the app through
+// lifi_get_protocol(), and the decoder port and channel model in
+// c_plugin/tools use it directly. A faster or denser variant is a change
+// here and a rebuild of both sides.
+//
+// On air, one slot per interval, per character:
+//
+//   marker    LIFI_MARKER, every pulse lit for one slot and then dark for
+//             LIFI_SLOTS_PER_PULSE - 1
+//   payload   LIFI_PAYLOAD_BITS bits MSB first, pulses in LIFI_BIT_COLOR
+//   gap       LIFI_GAP_SLOTS more dark slots
+//
+// and the message repeats. The receiver votes LIFI_FRAMES_PER_SLOT camera
+// frames into one slot and frames characters on the voted slots.
+
+#include <stdint.h>
+
+// What the strip shows during one slot
+enum SlotColor : uint8_t {
+    SLOT_OFF = 0,
+    SLOT_RED,
+    SLOT_BLUE,
+    SLOT_GREEN,
+};
+
+// Start marker, in transmit order
+constexpr uint8_t LIFI_MARKER[] = {SLOT_RED, SLOT_RED, SLOT_RED, SLOT_BLUE, SLOT_BLUE, SLOT_BLUE};
+constexpr int     LIFI_MARKER_PULSES = int(sizeof(LIFI_MARKER));
+
+// Slots per pulse: one lit, the rest dark
+constexpr int LIFI_SLOTS_PER_PULSE = 2;
+
+// Payload bits per character and the colour of each bit value
+constexpr int     LIFI_PAYLOAD_BITS = 8;
+constexpr uint8_t LIFI_BIT_COLOR[2] = {SLOT_BLUE, SLOT_RED};
+
+// Dark slots between the last bit's pulse and the next marker
+constexpr int LIFI_GAP_SLOTS = 1;
+
+constexpr int lifiSlotsPerChar(int payloadBits) {
+    return LIFI_SLOTS_PER_PULSE * (LIFI_MARKER_PULSES + payloadBits) + LIFI_GAP_SLOTS;
+}
+
+constexpr int LIFI_SLOTS_PER_CHAR = lifiSlotsPerChar(LIFI_PAYLOAD_BITS);
+
+// Slot interval; requests under the minimum fall back to the default
+constexpr int LIFI_DEFAULT_INTERVAL_MS = 99;
+constexpr int LIFI_MIN_INTERVAL_MS     = 20;
+
+// Receiver: camera frames per slot at the default interval (about 30 fps)
+constexpr int LIFI_FRAMES_PER_SLOT = 3;
+
+// Receiver framing, on voted slots with the newest last. The marker is
+// recognised when the lit slot of its last pulse is the newest slot; the lit
+// slot of pulse i is then lifiMarkerBack(i) slots back (1 = newest).
+constexpr int lifiMarkerBack(int pulse) {
+    return (LIFI_MARKER_PULSES - 1 - pulse) * LIFI_SLOTS_PER_PULSE + 1;
+}
+
+// Counted from the slot after the marker's last lit slot: the lit slot of
+// bit b, and the slots to wait for before the character is complete
+constexpr int lifiBitSlot(int bit) { return 1 + bit * LIFI_SLOTS_PER_PULSE; }
+
+constexpr int LIFI_PAYLOAD_SLOTS = 1 + LIFI_PAYLOAD_BITS * LIFI_SLOTS_PER_PULSE;
+
+static_assert(LIFI_MARKER_PULSES <= 16, "lifi_protocol carries up to 16 marker pulses");
+static_assert(LIFI_SLOTS_PER_PULSE >= 2, "pulses need a dark slot to be told apart");
+
+#endif // LIFI_PROTOCOL_H
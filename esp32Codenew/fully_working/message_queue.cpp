@@ -0,0 +1,97 @@
+#include "message_queue.h"
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// ByteRing
+
+bool ByteRing::push(const uint8_t* data, uint32_t length) {
+    const uint32_t h = head.load(std::memory_order_relaxed);
+    if (cap - (h - tail.load(std::memory_order_acquire)) < length) return false;
+
+    const uint32_t at = h & (cap - 1);
+    const uint32_t first = length < cap - at ? length : cap - at;
+    std::memcpy(bytes + at, data, first);
+    std::memcpy(bytes, data + first, length - first);
+    head.store(h + length, std::memory_order_release);
+    return true;
+}
+
+uint32_t ByteRing::space() const {
+    return cap - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+}
+
+uint32_t ByteRing::size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
+
+bool ByteRing::pop(uint8_t& byte) {
+    const uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    byte = bytes[t & (cap - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ChunkReceiver
+
+void ChunkReceiver::reset() {
+    expected.store(0, std::memory_order_relaxed);
+    accepted.store(false, std::memory_order_relaxed);
+}
+
+ChunkStatus ChunkReceiver::onWrite(const uint8_t* data, size_t length) {
+    const uint8_t want = expected.load(std::memory_order_relaxed);
+
+    ChunkStatus status;
+    if (length < 2) {
+        status = CHUNK_EMPTY;
+    } else if (data[0] != want) {
+        const bool resend = accepted.load(std::memory_order_relaxed) && uint8_t(data[0] + 1) == want;
+        status = resend ? CHUNK_DUPLICATE : CHUNK_OUT_OF_ORDER;
+    } else if (!ring.push(data + 1, uint32_t(length - 1))) {
+        status = CHUNK_FULL;
+    } else {
+        expected.store(uint8_t(want + 1), std::memory_order_relaxed);
+        accepted.store(true, std::memory_order_relaxed);
+        status = CHUNK_ACCEPTED;
+    }
+
+    send(status);
+    return status;
+}
+
+void ChunkReceiver::poll() {
+    const uint32_t used = ring.size();
+    const uint32_t last = reported.load(std::memory_order_relaxed);
+    const uint32_t moved = used > last ? used - last : last - used;
+    if (moved >= step || (used == 0 && last != 0)) send(STREAM_LEVEL);
+}
+
+void ChunkReceiver::send(ChunkStatus status) {
+    const uint32_t used = ring.size();
+    const uint32_t free = ring.capacity() - used;
+    reported.store(used, std::memory_order_relaxed);
+
+    const uint8_t packet[STATUS_BYTES] = {
+        status,
+        expected.load(std::memory_order_relaxed),
+        uint8_t(used), uint8_t(used >> 8),
+        uint8_t(free), uint8_t(free >> 8),
+    };
+    out.notify(packet, sizeof(packet));
+}
+
+// ---------------------------------------------------------------------------
+// StreamSource
+
+bool StreamSource::next(uint8_t& slot) {
+    if (index == count) {
+        uint8_t c;
+        if (!ring.pop(c)) return false;
+        count = encodeChar(c, fec, slots);
+        index = 0;
+    }
+    slot = slots[index++];
+    return true;
+}
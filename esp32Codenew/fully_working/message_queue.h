@@ -0,0 +1,137 @@
+#ifndef MESSAGE_QUEUE_H
+#define MESSAGE_QUEUE_H
+
+// Streaming over BLE.
+//
+// A write on the text characteristic replaces the message being repeated.
+// The stream characteristic instead appends sequence-numbered chunks to a
+// byte queue that the transmitter drains character after character, so the
+// phone can send more than one write's worth of data and line up the next
+// message while the current one is still going out.
+//
+//   ByteRing        SPSC byte queue, BLE task -> loop()
+//   ChunkReceiver   chunk writes in, status notifications out
+//   StreamSource    pops queued bytes and encodes their slots on the way out
+//
+// Nothing in here touches NimBLE: the sketch forwards writes to
+// ChunkReceiver and implements StatusNotifier with a notify
+// characteristic, and the host check in c_plugin/tools mocks both.
+//
+// Chunk write:    [seq] [payload, at least one byte]
+//   seq runs 0, 1, ... 255, 0, ... from the start of each connection. A
+//   chunk is queued whole or not at all.
+// Status notify:  [status] [next seq] [used lo, hi] [free lo, hi]
+//   after every write, and whenever the fill level moved by a reporting
+//   step or the queue ran empty. A sender keeps `free` above its next chunk
+//   and resends from `next seq` after CHUNK_FULL or CHUNK_OUT_OF_ORDER.
+
+#include "symbol_buffer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum ChunkStatus : uint8_t {
+    CHUNK_ACCEPTED = 0,     // queued
+    CHUNK_DUPLICATE,        // resend of the last accepted chunk, ignored
+    CHUNK_FULL,             // does not fit yet, nothing queued
+    CHUNK_OUT_OF_ORDER,     // not `next seq`, nothing queued
+    CHUNK_EMPTY,            // no payload
+    STREAM_LEVEL,           // fill report, not an answer to a write
+};
+
+constexpr size_t STATUS_BYTES = 6;
+
+// Single-producer / single-consumer byte queue over caller-owned storage.
+// The producer is the BLE task, the consumer loop().
+class ByteRing {
+public:
+    // `capacity` must be a power of two, at most 32768 so the levels fit the
+    // status packet
+    ByteRing(uint8_t* storage, uint32_t capacity) : bytes(storage), cap(capacity) {}
+
+    // Producer side: all of data, or nothing if it does not fit
+    bool push(const uint8_t* data, uint32_t length);
+    uint32_t space() const;
+
+    // Consumer side
+    bool pop(uint8_t& byte);
+
+    // Drops everything queued; consumer side
+    void clear() { tail.store(head.load(std::memory_order_acquire), std::memory_order_release); }
+
+    uint32_t size() const;
+    uint32_t capacity() const { return cap; }
+
+private:
+    uint8_t* bytes;
+    uint32_t cap;
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+};
+
+// Where status packets go: the notify characteristic on the ESP32
+class StatusNotifier {
+public:
+    virtual ~StatusNotifier() = default;
+    virtual void notify(const uint8_t* status, size_t length) = 0;
+};
+
+class ChunkReceiver {
+public:
+    // Fill level reports go out every `step` bytes of change; 0 means an
+    // eighth of the queue
+    ChunkReceiver(ByteRing& ring, StatusNotifier& out, uint32_t step = 0)
+        : ring(ring), out(out), step(step ? step : ring.capacity() / 8) {}
+
+    // BLE task: a new connection starts again at seq 0
+    void reset();
+
+    // BLE task: one write on the stream characteristic; the status is also
+    // notified
+    ChunkStatus onWrite(const uint8_t* data, size_t length);
+
+    // loop(): reports the fill level if it moved by a step since the last
+    // report, or the queue just ran empty
+    void poll();
+
+    uint8_t nextSeq() const { return expected.load(std::memory_order_relaxed); }
+
+private:
+    void send(ChunkStatus status);
+
+    ByteRing&       ring;
+    StatusNotifier& out;
+    uint32_t        step;
+
+    std::atomic<uint8_t>  expected{0};
+    std::atomic<bool>     accepted{false};      // a chunk this connection
+    std::atomic<uint32_t> reported{0};          // `used` in the last status
+};
+
+// Slot source for SymbolEngine::refill(): one character at a time off the
+// queue, back to back, so the strip only goes dark between characters when
+// the queue has run dry. Consumer side of the ring.
+class StreamSource {
+public:
+    explicit StreamSource(ByteRing& ring, TxFec fec = TX_FEC_NONE) : ring(ring), fec(fec) {}
+
+    bool next(uint8_t& slot);
+
+    // Queue empty and the last character handed out completely
+    bool idle() const { return index == count && ring.size() == 0; }
+
+    // Drops the queue and the character in progress
+    void clear() {
+        index = count = 0;
+        ring.clear();
+    }
+
+private:
+    ByteRing& ring;
+    TxFec     fec;
+    uint8_t   slots[MAX_SLOTS_PER_CHAR];
+    int       count = 0;
+    int       index = 0;
+};
+
+#endif // MESSAGE_QUEUE_H
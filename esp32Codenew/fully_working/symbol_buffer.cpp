@@ -0,0 +1,56 @@
+#include "symbol_buffer.h"
+
+uint8_t hamming74(uint8_t nibble) {
+    const uint8_t d1 = (nibble >> 3) & 1, d2 = (nibble >> 2) & 1;
+    const uint8_t d3 = (nibble >> 1) & 1, d4 = nibble & 1;
+    const uint8_t p1 = d1 ^ d2 ^ d4;
+    const uint8_t p2 = d1 ^ d3 ^ d4;
+    const uint8_t p3 = d2 ^ d3 ^ d4;
+    // Positions 1..7: p1 p2 d1 p3 d2 d3 d4
+    return uint8_t(p1 << 6 | p2 << 5 | d1 << 4 | p3 << 3 | d2 << 2 | d3 << 1 | d4);
+}
+
+static int putPulse(uint8_t color, uint8_t* slots) {
+    slots[0] = color;
+    for (int k = 1; k < LIFI_SLOTS_PER_PULSE; ++k) slots[k] = SLOT_OFF;
+    return LIFI_SLOTS_PER_PULSE;
+}
+
+static int putBits(uint32_t bits, int n, uint8_t* slots) {
+    int k = 0;
+    for (int i = n - 1; i >= 0; --i) k += putPulse(LIFI_BIT_COLOR[(bits >> i) & 1], slots + k);
+    return k;
+}
+
+int encodeChar(uint8_t c, TxFec fec, uint8_t* slots) {
+    int k = 0;
+    for (int m = 0; m < LIFI_MARKER_PULSES; ++m) k += putPulse(LIFI_MARKER[m], slots + k);
+
+    if (fec == TX_FEC_HAMMING74) {
+        k += putBits(uint32_t(hamming74(c >> 4)) << 7 | hamming74(c & 15), 14, slots + k);
+    } else {
+        k += putBits(c, LIFI_PAYLOAD_BITS, slots + k);
+    }
+
+    for (int g = 0; g < LIFI_GAP_SLOTS; ++g) slots[k++] = SLOT_OFF;
+    return k;
+}
+
+void encodeText(const uint8_t* message, size_t length, TxFec fec, SymbolBuffer& out) {
+    if (length > MAX_MESSAGE) length = MAX_MESSAGE;
+    out.clear();
+    out.repeat = true;
+
+    uint8_t slots[MAX_SLOTS_PER_CHAR];
+    for (size_t i = 0; i < length; ++i) {
+        const int n = encodeChar(message[i], fec, slots);
+        for (int k = 0; k < n; ++k) out.push(slots[k]);
+    }
+}
+
+void encodePattern(const uint8_t* slots, size_t count, SymbolBuffer& out) {
+    if (count > SymbolBuffer::MAX_SLOTS) count = SymbolBuffer::MAX_SLOTS;
+    out.clear();
+    out.repeat = false;
+    for (size_t i = 0; i < count; ++i) out.push(slots[i]);
+}
@@ -0,0 +1,127 @@
+#ifndef SYMBOL_BUFFER_H
+#define SYMBOL_BUFFER_H
+
+// Transmit symbols, encoded once when a message arrives.
+//
+// The BLE write handler turns the whole message into a SymbolBuffer: every
+// slot of every character (start marker, payload bits, gaps) as a 2-bit
+// colour code, four slots per byte. The output side then only walks an
+// index through it (SymbolCursor), so the per-slot path is a load and a
+// shift whatever the framing or coding.
+//
+// Mailbox hands finished buffers from the BLE task to loop() without a lock.
+
+#include "lifi_protocol.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Payload coding
+enum TxFec : uint8_t {
+    TX_FEC_NONE = 0,    // LIFI_PAYLOAD_BITS per character, what the receiver decodes today
+    TX_FEC_HAMMING74,   // each nibble as a Hamming(7,4) codeword: 14 bits, 1 error per nibble corrected
+};
+
+// Character layout is lifi_protocol.h; the coding only changes the payload
+constexpr int payloadBits(TxFec fec) { return fec == TX_FEC_HAMMING74 ? 14 : LIFI_PAYLOAD_BITS; }
+
+constexpr int slotsPerChar(TxFec fec) { return lifiSlotsPerChar(payloadBits(fec)); }
+
+// Longest text message kept for transmission
+constexpr size_t MAX_MESSAGE = 512;
+
+constexpr int MAX_SLOTS_PER_CHAR = slotsPerChar(TX_FEC_HAMMING74) > LIFI_SLOTS_PER_CHAR
+                                       ? slotsPerChar(TX_FEC_HAMMING74) : LIFI_SLOTS_PER_CHAR;
+
+// Slots as 2-bit SlotColor codes, four per byte
+struct SymbolBuffer {
+    static constexpr uint32_t MAX_SLOTS = uint32_t(MAX_MESSAGE) * MAX_SLOTS_PER_CHAR;
+
+    uint32_t count = 0;
+    bool     repeat = false;    // loop back to slot 0 at the end
+    uint8_t  packed[(MAX_SLOTS + 3) / 4];
+
+    void clear() { count = 0; }
+
+    void push(uint8_t slot) {
+        const uint32_t shift = (count & 3) * 2;
+        uint8_t& b = packed[count >> 2];
+        b = uint8_t((b & ~(3u << shift)) | ((slot & 3u) << shift));
+        ++count;
+    }
+
+    uint8_t at(uint32_t i) const { return (packed[i >> 2] >> ((i & 3) * 2)) & 3; }
+};
+
+// One character's slots into `slots` (room for slotsPerChar(fec)); returns
+// the count
+int encodeChar(uint8_t c, TxFec fec, uint8_t* slots);
+
+// Text protocol, repeated forever like the firmware always has. The message
+// is cut to MAX_MESSAGE bytes.
+void encodeText(const uint8_t* message, size_t length, TxFec fec, SymbolBuffer& out);
+
+// Raw slots played once
+void encodePattern(const uint8_t* slots, size_t count, SymbolBuffer& out);
+
+// Hamming(7,4) codeword of a nibble, bit 6 first on air
+uint8_t hamming74(uint8_t nibble);
+
+// Walks a SymbolBuffer slot by slot
+class SymbolCursor {
+public:
+    void play(const SymbolBuffer* buffer) {
+        buf = buffer && buffer->count ? buffer : nullptr;
+        index = 0;
+    }
+
+    void clear() { buf = nullptr; }
+    bool active() const { return buf != nullptr; }
+
+    // Next slot; false once a one-shot buffer is done or nothing is loaded
+    bool next(uint8_t& slot) {
+        if (!buf) return false;
+        slot = buf->at(index);
+        if (++index == buf->count) {
+            index = 0;
+            if (!buf->repeat) buf = nullptr;
+        }
+        return true;
+    }
+
+private:
+    const SymbolBuffer* buf = nullptr;
+    uint32_t index = 0;
+};
+
+// Lock-free triple buffer for one writer and one reader. The writer fills
+// back() and publish()es it; the reader take()s the newest published value,
+// which stays valid until its next take(). Neither side ever waits, and a
+// value published twice before the reader looks is simply replaced.
+template <typename T>
+class Mailbox {
+public:
+    T& back() { return slots[backIndex]; }
+
+    void publish() {
+        backIndex = uint8_t(middle.exchange(uint8_t(backIndex | FRESH), std::memory_order_acq_rel) & INDEX);
+    }
+
+    // Newest value, or nullptr if nothing was published since the last take()
+    const T* take() {
+        if (!(middle.load(std::memory_order_acquire) & FRESH)) return nullptr;
+        frontIndex = uint8_t(middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX);
+        return &slots[frontIndex];
+    }
+
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4;
+
+    T slots[3];
+    uint8_t backIndex  = 0;         // writer-owned
+    uint8_t frontIndex = 1;         // reader-owned
+    std::atomic<uint8_t> middle{2};
+};
+
+#endif // SYMBOL_BUFFER_H
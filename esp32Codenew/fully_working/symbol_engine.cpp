@@ -0,0 +1,91 @@
+#include "symbol_engine.h"
+
+// ---------------------------------------------------------------------------
+// SlotQueue
+
+bool SlotQueue::push(uint8_t slot) {
+    const uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= CAPACITY) return false;
+    slots[h % CAPACITY] = slot;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t SlotQueue::space() const {
+    return CAPACITY - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+}
+
+uint32_t SlotQueue::size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
+
+bool SlotQueue::pop(uint8_t& slot) {
+    const uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    slot = slots[t % CAPACITY];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// SymbolEngine
+
+void SymbolEngine::start(uint32_t period) {
+    timer.stop();
+    periodUs = period;
+    ticks.store(0, std::memory_order_relaxed);
+    underruns.store(0, std::memory_order_relaxed);
+    maxLate.store(0, std::memory_order_relaxed);
+    totalLate.store(0, std::memory_order_relaxed);
+    shown = SLOT_OFF;
+    startUs = timer.nowUs();
+    active.store(true, std::memory_order_release);
+    timer.start(periodUs, &SymbolEngine::onTimer, this);
+}
+
+void SymbolEngine::stop() {
+    active.store(false);
+    timer.stop();
+    while (inTick.load()) {
+    }
+    slots.clear();
+    sink.show(SLOT_OFF);
+}
+
+void SymbolEngine::tick() {
+    // Paired with stop(): either this sees active == false, or stop() sees
+    // inTick and waits for the slot to be shown
+    inTick.store(true);
+    if (!active.load()) {
+        inTick.store(false);
+        return;
+    }
+
+    const uint32_t k = ticks.load(std::memory_order_relaxed) + 1;
+    const uint64_t due = startUs + uint64_t(k) * periodUs;
+    const uint64_t now = timer.nowUs();
+    const uint32_t late = now > due ? uint32_t(now - due) : 0;
+    if (late > maxLate.load(std::memory_order_relaxed)) maxLate.store(late, std::memory_order_relaxed);
+    totalLate.store(totalLate.load(std::memory_order_relaxed) + late, std::memory_order_relaxed);
+
+    uint8_t slot;
+    if (!slots.pop(slot)) {
+        slot = SLOT_OFF;
+        underruns.store(underruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    if (slot != shown) {
+        shown = slot;
+        sink.show(slot);
+    }
+    ticks.store(k, std::memory_order_release);
+    inTick.store(false, std::memory_order_release);
+}
+
+SymbolEngineStats SymbolEngine::stats() const {
+    SymbolEngineStats s;
+    s.slots      = ticks.load(std::memory_order_acquire);
+    s.underruns  = underruns.load(std::memory_order_relaxed);
+    s.maxLateUs  = maxLate.load(std::memory_order_relaxed);
+    s.meanLateUs = s.slots ? uint32_t(totalLate.load(std::memory_order_relaxed) / s.slots) : 0;
+    return s;
+}
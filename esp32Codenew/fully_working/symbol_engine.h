@@ -0,0 +1,123 @@
+#ifndef SYMBOL_ENGINE_H
+#define SYMBOL_ENGINE_H
+
+// Timer-driven symbol output for the LED transmitter.
+//
+// Nothing in here touches Arduino, FreeRTOS or FastLED: the sketch supplies
+// a SlotTimer (esp_timer) and an LedSink (FastLED on its own task), and the
+// host check in c_plugin/tools supplies a virtual clock and a recording
+// sink, so the edge timing can be verified without hardware.
+//
+//   SymbolCursor    walks the message's precomputed slots (symbol_buffer.h)
+//   StreamSource    encodes queued stream bytes as they go out (message_queue.h)
+//   SlotQueue       lock-free SPSC ring, loop() -> timer callback
+//   SymbolEngine    pops one slot per timer period and hands it to the sink
+//
+// The timer is periodic, so slot edges land on start + k * period no matter
+// how late loop() runs; loop() only has to keep the queue from emptying.
+
+#include "symbol_buffer.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Hardware timer: fn(arg) every periodUs, the first call one period after
+// start(). nowUs() is the clock the timer runs on.
+class SlotTimer {
+public:
+    virtual ~SlotTimer() = default;
+    virtual void start(uint32_t periodUs, void (*fn)(void*), void* arg) = 0;
+    virtual void stop() = 0;
+    virtual uint64_t nowUs() const = 0;
+};
+
+// Strip output. Called from the timer callback, so it must not block: the
+// firmware hands the slot to the LED task.
+class LedSink {
+public:
+    virtual ~LedSink() = default;
+    virtual void show(uint8_t slot) = 0;
+};
+
+// Single-producer / single-consumer ring of slots. The producer is loop(),
+// the consumer the timer callback.
+class SlotQueue {
+public:
+    static constexpr uint32_t CAPACITY = 64;    // power of two
+
+    // Producer side
+    bool push(uint8_t slot);
+    uint32_t space() const;
+
+    // Empties the queue; only while the consumer is stopped
+    void clear() { tail.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+    // Consumer side
+    bool pop(uint8_t& slot);
+
+    uint32_t size() const;
+
+private:
+    uint8_t slots[CAPACITY] = {};
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+};
+
+// Counters of the timer side, readable from anywhere
+struct SymbolEngineStats {
+    uint32_t slots;         // timer periods since start()
+    uint32_t underruns;     // periods the queue was empty (strip dark)
+    uint32_t maxLateUs;     // latest callback relative to its nominal edge
+    uint32_t meanLateUs;
+};
+
+class SymbolEngine {
+public:
+    SymbolEngine(SlotTimer& timer, LedSink& sink) : timer(timer), sink(sink) {}
+
+    // Starts emitting one queued slot per period; the first edge is one
+    // period from now.
+    void start(uint32_t periodUs);
+
+    // Stops the timer, drops the queued slots and turns the strip off. A
+    // callback already in flight is waited for, so nothing the engine shows
+    // can land after this returns.
+    void stop();
+
+    bool running() const { return active.load(std::memory_order_acquire); }
+
+    // loop(): tops the queue up from `source`, a SymbolCursor or StreamSource
+    // (anything with bool next(uint8_t& slot))
+    template <typename Source>
+    void refill(Source& source) {
+        uint8_t slot;
+        for (uint32_t n = slots.space(); n > 0 && source.next(slot); --n) slots.push(slot);
+    }
+
+    SlotQueue& queue() { return slots; }
+
+    SymbolEngineStats stats() const;
+
+    // Timer callback body
+    void tick();
+
+private:
+    static void onTimer(void* self) { static_cast<SymbolEngine*>(self)->tick(); }
+
+    SlotTimer& timer;
+    LedSink&   sink;
+    SlotQueue  slots;
+
+    std::atomic<bool> active{false};
+    std::atomic<bool> inTick{false};
+    uint64_t startUs = 0;
+    uint32_t periodUs = 0;
+    uint8_t  shown = SLOT_OFF;
+
+    std::atomic<uint32_t> ticks{0};
+    std::atomic<uint32_t> underruns{0};
+    std::atomic<uint32_t> maxLate{0};
+    std::atomic<uint64_t> totalLate{0};
+};
+
+#endif // SYMBOL_ENGINE_H
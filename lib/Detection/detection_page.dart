@@ -1,4 +1,5 @@
 import 'dart:async';
+import 'dart:isolate';
 import 'package:c_plugin/c_plugin.dart';
 import 'package:camera/camera.dart';
 import 'package:flutter/material.dart';
@@ -44,6 +45,29 @@ class DetectionResult {
   });
 }
 
+/// Decoder isolate of [DetectionScreen]: drains the page's frame queue on
+/// its own session each time it is woken, and sends every result back.
+/// A null wake-up stops it.
+void _decoderMain(List<Object> args) {
+  final queue = FrameQueue.fromAddress(args[0] as int);
+  final session = LifiSession(args[1] as int, args[2] as int);
+  final results = args[3] as SendPort;
+  final wake = ReceivePort();
+  wake.listen((msg) {
+    if (msg == null) {
+      wake.close();
+      queue.dispose();
+      session.dispose();
+      results.send(null);
+      return;
+    }
+    for (var r = queue.process(session); r != null; r = queue.process(session)) {
+      results.send(<Object>[r.seq, r.timestampNs, ...r.values]);
+    }
+  });
+  results.send(wake.sendPort);
+}
+
 class DetectionScreen extends StatefulWidget {
   const DetectionScreen({super.key});
 
@@ -58,7 +82,6 @@ class _DetectionScreenState extends State<DetectionScreen> {
 
   DateTime?     _warmUpStart;
   DateTime?     _measurementStart;
-  bool          _processing = false;
   Timer?        _fpsTimer;
   Timer?        _measurementTimer;
   int           _fpsFrameCount = 0;
@@ -81,7 +104,15 @@ class _DetectionScreenState extends State<DetectionScreen> {
 
   // Detection state:
   bool _detecting = false;
-  //bool _processing = false;
+
+  // Camera frames go through a counted queue to a decoder isolate instead
+  // of being skipped while busy; drops show up as gaps in the sequence
+  // numbers of the results it sends back
+  FrameQueue? _queue;
+  SendPort? _wake;
+  bool _stopping = false;
+  int _offered = 0;
+  int _nextSeq = 0;
 
   // Latest stats & history
   static const int _kMaxHistory = 100;
@@ -163,6 +194,7 @@ class _DetectionScreenState extends State<DetectionScreen> {
     }
     _controller?.dispose();
     _valueController.close();
+    _stopDecoder();
     _fpsTimer?.cancel();
     _measurementTimer?.cancel();
     super.dispose();
@@ -181,8 +213,9 @@ class _DetectionScreenState extends State<DetectionScreen> {
   }
 
   void _toggleDetect() {
-    if (_processing == false && _controller != null && !_detecting) {
+    if (_controller != null && !_detecting) {
       counter = 1;
+      _offered = 0;
       minMax.clear();
       ledtest.clear();
       ledOnOffCompute.clear();
@@ -374,7 +407,11 @@ class _DetectionScreenState extends State<DetectionScreen> {
 
   void _onFrame(CameraImage img) {
 
+    // camera 0.11 hands no sensor timestamp over; arrival here, on the
+    // latency clock, is the closest the queue can get
+    final arrivalNs = latencyNow();
     final now = DateTime.now();
+    if (_stopping) return;
 
     if (_warmUpStart == null) {
       _warmUpStart = now;
@@ -395,11 +432,6 @@ class _DetectionScreenState extends State<DetectionScreen> {
 
 
     _fpsFrameCount++;
-    if(_processing == true){
-      print("dropped");
-    }
-    if (_processing) return;
-    _processing = true;
 
     // Recompute ROI only if ROI changed
     if (_lastOrigin != _boxOrigin ||
@@ -420,20 +452,63 @@ class _DetectionScreenState extends State<DetectionScreen> {
 
     //print("start function");
 
-    // Call the native FFI function
-    final stats = processFrameColor(
+    // Queue the frame (drop oldest: the UI isolate must never wait) and
+    // wake the decoder isolate
+    final queue = _queue ?? _startDecoder(img.width, img.height);
+    final queued = queue.push(
       yPlane:        img.planes[0].bytes,
       uPlane:        img.planes[1].bytes,
       vPlane:        img.planes[2].bytes,
       width:         img.width,
       height:        img.height,
-      count:         counter-1,
+      count:         _offered++,
       yRowStride:    img.planes[0].bytesPerRow,
       uvRowStride:   img.planes[1].bytesPerRow,
       uvPixelStride: img.planes[1].bytesPerPixel!,
       roi:           roi,
+      timestampNs:   arrivalNs,
     );
+    if (queued) _wake?.send(true);
+  }
 
+  // Creates the frame queue and spawns the isolate that decodes it. Its
+  // results come back as [seq, timestampNs, ...stats].
+  FrameQueue _startDecoder(int width, int height) {
+    final queue = _queue = FrameQueue(4, width, height);
+    final results = ReceivePort();
+    results.listen((msg) {
+      if (msg is SendPort) {
+        _wake = msg;
+        msg.send(_stopping ? null : true);
+        return;
+      }
+      if (msg == null) {
+        // Decoder has let go of the queue
+        results.close();
+        queue.dispose();
+        return;
+      }
+      if (_stopping) return;
+      final r = msg as List;
+      final seq = r[0] as int;
+      if (seq != _nextSeq) {
+        print("dropped ${seq - _nextSeq} frames (${queue.stats.dropped} total)");
+      }
+      _nextSeq = seq + 1;
+      _onStats(r.sublist(2).cast<double>());
+    });
+    Isolate.spawn(_decoderMain, <Object>[
+      queue.pointer.address, width, height, results.sendPort,
+    ]);
+    return queue;
+  }
+
+  void _stopDecoder() {
+    _stopping = true;
+    _wake?.send(null);
+  }
+
+  void _onStats(List<double> stats) {
 
     // Update all fields, then push to stream
     _avgBrightness = stats[0];
@@ -465,9 +540,12 @@ class _DetectionScreenState extends State<DetectionScreen> {
       }
     }
 
+    // Frames per slot, marker and bit layout come from the shared
+    // protocol spec (lifi_protocol.h), like the firmware's encoder
+    final frames = protocol.framesPerSlot;
     if (counter > 5 && !bitStart) {
-      for (int i = 0; i < ledPairCompute[0].length - 2; i++) {
-        if (ledPairCompute[0][i] == 1 && ledPairCompute[0][i + 1] == 1 && ledPairCompute[0][i + 2] == 1) {
+      for (int i = 0; i + frames <= ledPairCompute[0].length; i++) {
+        if (List.generate(frames, (k) => ledPairCompute[0][i + k]).every((on) => on == 1)) {
           bitStart = true;
           bitStartIndex = i; // Start grouping from here
           break;
@@ -475,51 +553,45 @@ class _DetectionScreenState extends State<DetectionScreen> {
       }
     }
 
-// Step 2: Group into 3s and classify (if start was detected)
+// Step 2: Group into slots and classify (if start was detected)
     if (bitStart && bitStartIndex != null) {
       // Only group chunks that haven’t been grouped before
-      int nextGroupStart = bitStartIndex! + finalBits[0].length * 3;
-
-      while (nextGroupStart + 2 < ledPairCompute[0].length){
-        int a = ledPairCompute[0][nextGroupStart];
-        String colorA = ( a ==1 ?  ledPairCompute[1][nextGroupStart]:"Black"); // ledPairCompute[1][nextGroupStart] = "green"
-        int b = ledPairCompute[0][nextGroupStart + 1];
-        String colorB =  b == 1?  ledPairCompute[1][nextGroupStart+1]:"Black";
-        int c = ledPairCompute[0][nextGroupStart + 2];
-        String colorC =  c == 1?  ledPairCompute[1][nextGroupStart+2]:"Black";
-
-        if(colorA == colorB && colorA == colorC && colorA != "Black"){
-          //thunama eka pata
-          currentColor = colorA;
-        }else if((colorA == colorB || colorA == colorC) && colorA != "Black"){
-          //color eka A
-          currentColor = colorA;
-        }else if(colorB ==colorC && colorB != "Black"){
-          //color eka B
-          currentColor = colorB;
-        }else{
-          // off state
-          currentColor = "Black";
+      int nextGroupStart = bitStartIndex! + finalBits[0].length * frames;
+
+      while (nextGroupStart + frames <= ledPairCompute[0].length){
+        final on = List<int>.generate(frames, (k) => ledPairCompute[0][nextGroupStart + k]);
+        final colors = List<String>.generate(
+            frames, (k) => on[k] == 1 ? ledPairCompute[1][nextGroupStart + k] : "Black");
+
+        // Colour most frames agree on (the earliest on a tie), if a majority
+        currentColor = "Black";
+        int best = 0;
+        for (final color in colors) {
+          final votes = colors.where((c) => c == color).length;
+          if (color != "Black" && votes > best) {
+            best = votes;
+            currentColor = color;
+          }
         }
-        int sum = a + b + c;
-        int decodedBit = sum >= 2 ? 1 : 0; // Majority voting
+        if (2 * best <= frames) currentColor = "Black";
+
+        int sum = on.reduce((a, b) => a + b);
+        int decodedBit = 2 * sum > frames ? 1 : 0; // Majority voting
         decodedBit == 1? finalBits[1].add(currentColor):finalBits[1].add("Black");
         finalBits[0].add(decodedBit);
-        nextGroupStart += 3;
+        nextGroupStart += frames;
       }
     }
 
     final lp = finalBits;
     final len = lp[0].length;
-    if ( !transmissionStarted && len >= 11) {     //!transmissionStarted &&
-      if (lp[0][len - 5] == 1 && lp[1][len - 5] == "blue" &&
-          lp[0][len - 3] == 1 && lp[1][len - 3] == "blue" &&
-          lp[0][len - 1] == 1 && lp[1][len - 1] == "blue"&&
-          lp[0][len - 7] == 1 && lp[1][len - 7] == "red" &&
-          lp[0][len - 9] == 1 && lp[1][len - 9] == "red" &&
-          lp[0][len - 11] == 1 && lp[1][len - 11] == "red"
-
-      ) {
+    if ( !transmissionStarted && len >= protocol.markerBack(0)) {     //!transmissionStarted &&
+      bool marker = true;
+      for (int p = 0; p < protocol.marker.length && marker; p++) {
+        final back = protocol.markerBack(p);
+        marker = lp[0][len - back] == 1 && lp[1][len - back] == protocol.marker[p].name;
+      }
+      if (marker) {
         transmissionStarted = true;
         greenBlinkCount ++;
         transmissionStartIndex = len; // next index is yellow
@@ -538,14 +610,14 @@ class _DetectionScreenState extends State<DetectionScreen> {
       }
     }
 
-    if (transmissionStarted && len >= transmissionStartIndex + 17) {
+    if (transmissionStarted && len >= transmissionStartIndex + protocol.payloadSlots) {
       List<int> bits = [];
       List<String> colors = [];
 
-      for (int i = transmissionStartIndex+1 ; i <= transmissionStartIndex + 16; i++) {
+      for (int i = transmissionStartIndex + 1; i < transmissionStartIndex + protocol.payloadSlots; i++) {
         final isOn = lp[0][i] == 1;
         final color = lp[1][i];
-        final bit = (isOn && color == "red") ? 1 : 0;
+        final bit = (isOn && color == protocol.bitColors[1].name) ? 1 : 0;
         bits.add(bit);
         colors.add(color);
       }
@@ -656,17 +728,16 @@ class _DetectionScreenState extends State<DetectionScreen> {
     //   ),
     // );
     counter = counter +1;
-    _processing = false;
   }
 
   String decodeCharacter(List<int> frameBits){
     String char = "";
-    if (frameBits.length != 16) return '?';
+    if (frameBits.length != protocol.payloadSlots - 1) return '?';
 
     List<int> bits = [];
 
-    for (int i = 0; i < 16; i += 2) {
-      bits.add(frameBits[i]); // take every ON frame
+    for (int b = 0; b < protocol.payloadBits; b++) {
+      bits.add(frameBits[protocol.bitSlot(b) - 1]); // take every ON slot
     }
 
     int charCode = 0;